@@ -1,13 +1,17 @@
 import 'dart:io';
+import 'dart:ui' as ui;
 
 import 'package:flutter/material.dart';
 import 'package:long_shot_app/native/native_main.dart';
+import 'package:long_shot_app/native/native_opencv.dart';
 import 'package:photo_view/photo_view.dart';
 
 class DisplayImage extends StatefulWidget {
-  final String imagePath;
+  final String? imagePath;
+  final StitchResult? result;
 
-  const DisplayImage({super.key, required this.imagePath});
+  const DisplayImage({super.key, this.imagePath, this.result})
+      : assert(imagePath != null || result != null);
 
   @override
   State<DisplayImage> createState() => _DisplayImageState();
@@ -15,10 +19,52 @@ class DisplayImage extends StatefulWidget {
 
 class _DisplayImageState extends State<DisplayImage> {
   final GlobalKey _imageKey = GlobalKey();
+  ui.Image? _image;
 
   @override
   void initState() {
     super.initState();
+    final result = widget.result;
+    if (result != null) {
+      // Upload the native pixels directly, no encode/decode round trip
+      ui.decodeImageFromPixels(
+        result.pixels,
+        result.width,
+        result.height,
+        ui.PixelFormat.rgba8888,
+        (image) {
+          if (mounted) {
+            setState(() => _image = image);
+          } else {
+            image.dispose();
+          }
+        },
+        rowBytes: result.stride,
+      );
+    }
+  }
+
+  @override
+  void dispose() {
+    _image?.dispose();
+    super.dispose();
+  }
+
+  Widget _buildImage() {
+    if (widget.result == null) {
+      return PhotoView(
+        key: _imageKey,
+        imageProvider: Image.file(File(widget.imagePath!)).image,
+      );
+    }
+    if (_image == null) {
+      return const Center(child: CircularProgressIndicator());
+    }
+    return PhotoView.customChild(
+      key: _imageKey,
+      childSize: Size(_image!.width.toDouble(), _image!.height.toDouble()),
+      child: RawImage(image: _image),
+    );
   }
 
   @override
@@ -26,10 +72,7 @@ class _DisplayImageState extends State<DisplayImage> {
     return Scaffold(
       body: Stack(
         children: [
-          PhotoView(
-            key: _imageKey,
-            imageProvider: Image.file(File(widget.imagePath)).image,
-          ),
+          _buildImage(),
           Positioned(
             top: 32,
             right: 32,
@@ -1,6 +1,5 @@
 import 'dart:async';
 import 'dart:io';
-import 'dart:isolate';
 
 import 'package:file_picker/file_picker.dart';
 import 'package:flutter/material.dart';
@@ -38,6 +37,8 @@ class NativeMainState extends State<NativeMain> {
 
   Future<void> _initializeTempDir() async {
     tempDir = await getTemporaryDirectory();
+    setCanvasBudget(scratchDir: tempDir.path);
+    setFeatureCache(dir: '${tempDir.path}/stitch_features');
   }
 
   Future<void> _initializePerm() async {
@@ -94,45 +95,14 @@ class NativeMainState extends State<NativeMain> {
     }
   }
 
-  Future<void> _processInIsolate(
-      List<String?> imagePaths, String outputPath) async {
-    final receivePort = ReceivePort();
-    await Isolate.spawn(
-      _isolateEntry,
-      [receivePort.sendPort, imagePaths, outputPath],
+  void _reportResult(StitchResult? result) {
+    if (!mounted) return;
+    ScaffoldMessenger.of(context).showSnackBar(
+      SnackBar(
+        content: Text(
+            result == null ? 'Error: Stitching failed' : 'Stitching complete'),
+      ),
     );
-
-    final result = await receivePort.first;
-    if (result is Exception) {
-      if (mounted) {
-        ScaffoldMessenger.of(context).showSnackBar(
-          SnackBar(
-            content: Text('Error: ${result.toString()}'),
-          ),
-        );
-      }
-    } else {
-      if (mounted) {
-        ScaffoldMessenger.of(context).showSnackBar(
-          const SnackBar(
-            content: Text('Stitching complete'),
-          ),
-        );
-      }
-    }
-  }
-
-  static void _isolateEntry(List<dynamic> args) {
-    final sendPort = args[0] as SendPort;
-    final imagePaths = args[1] as List<String?>;
-    final outputPath = args[2] as String;
-
-    try {
-      stitchImages(StitchImagesArguments(imagePaths, outputPath));
-      sendPort.send('Success');
-    } catch (e) {
-      sendPort.send(e);
-    }
   }
 
   void _processImage() async {
@@ -150,15 +120,20 @@ class NativeMainState extends State<NativeMain> {
     final directory = await getDownloadsDirectory();
     final outputPath = '${directory!.path}/stitched_bill.jpg';
 
-    await _processInIsolate(imagePaths, outputPath);
+    final result = await StitchJobs.instance.stitchImages(imagePaths).result;
+    _reportResult(result);
 
-    if (mounted) {
-      Navigator.push(
-        context,
-        MaterialPageRoute(
-          builder: (_) => DisplayImage(imagePath: outputPath),
-        ),
-      );
+    if (result != null) {
+      // Show the in-memory result right away, persist it in the background
+      result.persist(outputPath);
+      if (mounted) {
+        Navigator.push(
+          context,
+          MaterialPageRoute(
+            builder: (_) => DisplayImage(result: result),
+          ),
+        );
+      }
     }
 
     setState(() => _isLoading = false);
@@ -1,23 +1,270 @@
 // native_opencv.dart
+import 'dart:async';
 import 'dart:ffi' as ffi;
 import 'dart:io';
+import 'dart:isolate';
+import 'dart:typed_data';
 import 'package:ffi/ffi.dart';
 
 // C function signatures
 typedef _CVersionFunc = ffi.Pointer<Utf8> Function();
 typedef _CStitchImagesFunc = ffi.Void Function(
     ffi.Pointer<ffi.Pointer<Utf8>>,
+    ffi.Pointer<ffi.Int64>,
     ffi.Int32,
     ffi.Pointer<Utf8>,
+    ffi.Pointer<_CStitchConfig>,
     );
+typedef _CSessionCreateFunc = ffi.Pointer<ffi.Void> Function();
+typedef _CSessionPushFrameFunc = ffi.Void Function(
+    ffi.Pointer<ffi.Void>,
+    ffi.Pointer<Utf8>,
+    ffi.Int64,
+    );
+typedef _CSessionFinalizeFunc = ffi.Int32 Function(
+    ffi.Pointer<ffi.Void>,
+    ffi.Pointer<Utf8>,
+    ffi.Pointer<_CStitchConfig>,
+    );
+typedef _CSessionPushYuv420Func = ffi.Void Function(
+    ffi.Pointer<ffi.Void>,
+    ffi.Pointer<ffi.Uint8>,
+    ffi.Pointer<ffi.Uint8>,
+    ffi.Pointer<ffi.Uint8>,
+    ffi.Int32,
+    ffi.Int32,
+    ffi.Int32,
+    ffi.Int32,
+    ffi.Int32,
+    ffi.Int32,
+    ffi.Int64,
+    );
+typedef _CSessionTrackYuv420Func = ffi.Int32 Function(
+    ffi.Pointer<ffi.Void>,
+    ffi.Pointer<ffi.Uint8>,
+    ffi.Pointer<ffi.Uint8>,
+    ffi.Pointer<ffi.Uint8>,
+    ffi.Int32,
+    ffi.Int32,
+    ffi.Int32,
+    ffi.Int32,
+    ffi.Int32,
+    ffi.Int32,
+    ffi.Int64,
+    );
+typedef _CSessionFinalizeResultFunc = ffi.Pointer<ffi.Void> Function(
+    ffi.Pointer<ffi.Void>);
+typedef _CStitchImagesResultFunc = ffi.Pointer<ffi.Void> Function(
+    ffi.Pointer<ffi.Pointer<Utf8>>,
+    ffi.Pointer<ffi.Int64>,
+    ffi.Int32,
+    ffi.Pointer<_CStitchConfig>,
+    );
+typedef _CResultIntFunc = ffi.Int32 Function(ffi.Pointer<ffi.Void>);
+typedef _CResultPixelsFunc = ffi.Pointer<ffi.Uint8> Function(
+    ffi.Pointer<ffi.Void>);
+typedef _CResultEncodeFunc = ffi.Pointer<ffi.Uint8> Function(
+    ffi.Pointer<ffi.Void>,
+    ffi.Pointer<Utf8>,
+    ffi.Int32,
+    ffi.Pointer<ffi.Int32>,
+    );
+typedef _CResultWriteFunc = ffi.Int32 Function(
+    ffi.Pointer<ffi.Void>,
+    ffi.Pointer<Utf8>,
+    ffi.Int32,
+    );
+typedef _CResultReleaseFunc = ffi.Void Function(ffi.Pointer<ffi.Void>);
+typedef _CResultFrameCountsFunc = ffi.Void Function(
+    ffi.Pointer<ffi.Void>, ffi.Pointer<ffi.Int32>);
+typedef _CJobCompletionFunc = ffi.Void Function(
+    ffi.Int64,
+    ffi.Int32,
+    ffi.Pointer<ffi.Void>,
+    );
+typedef _CJobProgressFunc = ffi.Void Function(
+    ffi.Int64,
+    ffi.Int32,
+    ffi.Int32,
+    ffi.Int32,
+    );
+typedef _CJobSubmitImagesFunc = ffi.Int64 Function(
+    ffi.Pointer<ffi.Pointer<Utf8>>,
+    ffi.Pointer<ffi.Int64>,
+    ffi.Int32,
+    ffi.Int32,
+    ffi.Pointer<ffi.NativeFunction<_CJobCompletionFunc>>,
+    ffi.Pointer<ffi.NativeFunction<_CJobProgressFunc>>,
+    ffi.Pointer<_CStitchConfig>,
+    );
+typedef _CJobSubmitSessionFunc = ffi.Int64 Function(
+    ffi.Pointer<ffi.Void>,
+    ffi.Int32,
+    ffi.Pointer<ffi.NativeFunction<_CJobCompletionFunc>>,
+    ffi.Pointer<ffi.NativeFunction<_CJobProgressFunc>>,
+    );
+typedef _CJobSubmitRenderFunc = ffi.Int64 Function(
+    ffi.Pointer<Utf8>,
+    ffi.Double,
+    ffi.Int32,
+    ffi.Pointer<ffi.NativeFunction<_CJobCompletionFunc>>,
+    ffi.Pointer<ffi.NativeFunction<_CJobProgressFunc>>,
+    );
+typedef _CJobCancelFunc = ffi.Void Function(ffi.Int64);
+typedef _CQualityScoreFunc = ffi.Int32 Function(
+    ffi.Pointer<ffi.Uint8>,
+    ffi.Int32,
+    ffi.Int32,
+    ffi.Int32,
+    ffi.Pointer<ffi.Double>,
+    );
+typedef _CFeatureBenchmarkFunc = ffi.Int32 Function(
+    ffi.Pointer<ffi.Pointer<Utf8>>,
+    ffi.Int32,
+    ffi.Pointer<ffi.Double>,
+    );
+typedef _CGuideCreateFunc = ffi.Pointer<ffi.Void> Function();
+typedef _CGuideUpdateFunc = ffi.Int32 Function(
+    ffi.Pointer<ffi.Void>,
+    ffi.Pointer<ffi.Uint8>,
+    ffi.Int32,
+    ffi.Int32,
+    ffi.Int32,
+    ffi.Int32,
+    ffi.Int64,
+    ffi.Pointer<ffi.Double>,
+    );
+typedef _CGuideFunc = ffi.Void Function(ffi.Pointer<ffi.Void>);
+typedef _CSetCanvasBudgetFunc = ffi.Void Function(ffi.Int64, ffi.Pointer<Utf8>);
+typedef _CSetFeatureCacheFunc = ffi.Void Function(ffi.Pointer<Utf8>, ffi.Int64);
+typedef _CConfigDefaultsFunc = ffi.Int32 Function(
+    ffi.Pointer<_CStitchConfig>, ffi.Int32);
+typedef _CConfigValidateFunc = ffi.Int32 Function(ffi.Pointer<_CStitchConfig>);
+typedef _CSessionDestroyFunc = ffi.Void Function(ffi.Pointer<ffi.Void>);
 
 // Dart function signatures
 typedef _VersionFunc = ffi.Pointer<Utf8> Function();
 typedef _StitchImagesFunc = void Function(
     ffi.Pointer<ffi.Pointer<Utf8>>,
+    ffi.Pointer<ffi.Int64>,
+    int,
+    ffi.Pointer<Utf8>,
+    ffi.Pointer<_CStitchConfig>,
+    );
+typedef _SessionCreateFunc = ffi.Pointer<ffi.Void> Function();
+typedef _SessionPushFrameFunc = void Function(
+    ffi.Pointer<ffi.Void>,
+    ffi.Pointer<Utf8>,
+    int,
+    );
+typedef _SessionFinalizeFunc = int Function(
+    ffi.Pointer<ffi.Void>,
+    ffi.Pointer<Utf8>,
+    ffi.Pointer<_CStitchConfig>,
+    );
+typedef _SessionPushYuv420Func = void Function(
+    ffi.Pointer<ffi.Void>,
+    ffi.Pointer<ffi.Uint8>,
+    ffi.Pointer<ffi.Uint8>,
+    ffi.Pointer<ffi.Uint8>,
+    int,
+    int,
+    int,
+    int,
+    int,
+    int,
+    int,
+    );
+typedef _SessionTrackYuv420Func = int Function(
+    ffi.Pointer<ffi.Void>,
+    ffi.Pointer<ffi.Uint8>,
+    ffi.Pointer<ffi.Uint8>,
+    ffi.Pointer<ffi.Uint8>,
+    int,
+    int,
+    int,
+    int,
+    int,
+    int,
+    int,
+    );
+typedef _SessionFinalizeResultFunc = ffi.Pointer<ffi.Void> Function(
+    ffi.Pointer<ffi.Void>);
+typedef _StitchImagesResultFunc = ffi.Pointer<ffi.Void> Function(
+    ffi.Pointer<ffi.Pointer<Utf8>>,
+    ffi.Pointer<ffi.Int64>,
+    int,
+    ffi.Pointer<_CStitchConfig>,
+    );
+typedef _ResultIntFunc = int Function(ffi.Pointer<ffi.Void>);
+typedef _ResultFrameCountsFunc = void Function(
+    ffi.Pointer<ffi.Void>, ffi.Pointer<ffi.Int32>);
+typedef _ResultPixelsFunc = ffi.Pointer<ffi.Uint8> Function(
+    ffi.Pointer<ffi.Void>);
+typedef _ResultEncodeFunc = ffi.Pointer<ffi.Uint8> Function(
+    ffi.Pointer<ffi.Void>,
+    ffi.Pointer<Utf8>,
+    int,
+    ffi.Pointer<ffi.Int32>,
+    );
+typedef _ResultWriteFunc = int Function(
+    ffi.Pointer<ffi.Void>,
+    ffi.Pointer<Utf8>,
+    int,
+    );
+typedef _ResultReleaseFunc = void Function(ffi.Pointer<ffi.Void>);
+typedef _JobSubmitImagesFunc = int Function(
+    ffi.Pointer<ffi.Pointer<Utf8>>,
+    ffi.Pointer<ffi.Int64>,
+    int,
     int,
+    ffi.Pointer<ffi.NativeFunction<_CJobCompletionFunc>>,
+    ffi.Pointer<ffi.NativeFunction<_CJobProgressFunc>>,
+    ffi.Pointer<_CStitchConfig>,
+    );
+typedef _JobSubmitSessionFunc = int Function(
+    ffi.Pointer<ffi.Void>,
+    int,
+    ffi.Pointer<ffi.NativeFunction<_CJobCompletionFunc>>,
+    ffi.Pointer<ffi.NativeFunction<_CJobProgressFunc>>,
+    );
+typedef _JobSubmitRenderFunc = int Function(
     ffi.Pointer<Utf8>,
+    double,
+    int,
+    ffi.Pointer<ffi.NativeFunction<_CJobCompletionFunc>>,
+    ffi.Pointer<ffi.NativeFunction<_CJobProgressFunc>>,
+    );
+typedef _JobCancelFunc = void Function(int);
+typedef _QualityScoreFunc = int Function(
+    ffi.Pointer<ffi.Uint8>,
+    int,
+    int,
+    int,
+    ffi.Pointer<ffi.Double>,
+    );
+typedef _FeatureBenchmarkFunc = int Function(
+    ffi.Pointer<ffi.Pointer<Utf8>>,
+    int,
+    ffi.Pointer<ffi.Double>,
     );
+typedef _GuideCreateFunc = ffi.Pointer<ffi.Void> Function();
+typedef _GuideUpdateFunc = int Function(
+    ffi.Pointer<ffi.Void>,
+    ffi.Pointer<ffi.Uint8>,
+    int,
+    int,
+    int,
+    int,
+    int,
+    ffi.Pointer<ffi.Double>,
+    );
+typedef _GuideFunc = void Function(ffi.Pointer<ffi.Void>);
+typedef _SetCanvasBudgetFunc = void Function(int, ffi.Pointer<Utf8>);
+typedef _SetFeatureCacheFunc = void Function(ffi.Pointer<Utf8>, int);
+typedef _ConfigDefaultsFunc = int Function(ffi.Pointer<_CStitchConfig>, int);
+typedef _ConfigValidateFunc = int Function(ffi.Pointer<_CStitchConfig>);
+typedef _SessionDestroyFunc = void Function(ffi.Pointer<ffi.Void>);
 
 // Getting a library that holds needed symbols
 ffi.DynamicLibrary _openDynamicLibrary() {
@@ -37,27 +284,365 @@ final _StitchImagesFunc _stitchImages = _lib
     .lookup<ffi.NativeFunction<_CStitchImagesFunc>>('stitch_images')
     .asFunction();
 
+final _SessionCreateFunc _sessionCreate = _lib
+    .lookup<ffi.NativeFunction<_CSessionCreateFunc>>('stitch_session_create')
+    .asFunction();
+
+final _SessionPushFrameFunc _sessionPushFrame = _lib
+    .lookup<ffi.NativeFunction<_CSessionPushFrameFunc>>(
+        'stitch_session_push_frame')
+    .asFunction();
+
+final _SessionFinalizeFunc _sessionFinalize = _lib
+    .lookup<ffi.NativeFunction<_CSessionFinalizeFunc>>(
+        'stitch_session_finalize')
+    .asFunction();
+
+final _SessionPushYuv420Func _sessionPushYuv420 = _lib
+    .lookup<ffi.NativeFunction<_CSessionPushYuv420Func>>(
+        'stitch_session_push_yuv420')
+    .asFunction();
+
+final _SessionTrackYuv420Func _sessionTrackYuv420 = _lib
+    .lookup<ffi.NativeFunction<_CSessionTrackYuv420Func>>(
+        'stitch_session_track_yuv420')
+    .asFunction();
+
+final _SessionFinalizeResultFunc _sessionFinalizeResult = _lib
+    .lookup<ffi.NativeFunction<_CSessionFinalizeResultFunc>>(
+        'stitch_session_finalize_result')
+    .asFunction();
+
+final _StitchImagesResultFunc _stitchImagesResult = _lib
+    .lookup<ffi.NativeFunction<_CStitchImagesResultFunc>>(
+        'stitch_images_result')
+    .asFunction();
+
+final _ResultIntFunc _resultWidth = _lib
+    .lookup<ffi.NativeFunction<_CResultIntFunc>>('stitch_result_width')
+    .asFunction();
+
+final _ResultIntFunc _resultHeight = _lib
+    .lookup<ffi.NativeFunction<_CResultIntFunc>>('stitch_result_height')
+    .asFunction();
+
+final _ResultIntFunc _resultStride = _lib
+    .lookup<ffi.NativeFunction<_CResultIntFunc>>('stitch_result_stride')
+    .asFunction();
+
+final _ResultIntFunc _resultFormat = _lib
+    .lookup<ffi.NativeFunction<_CResultIntFunc>>('stitch_result_format')
+    .asFunction();
+
+final _ResultFrameCountsFunc _resultFrameCounts = _lib
+    .lookup<ffi.NativeFunction<_CResultFrameCountsFunc>>(
+        'stitch_result_frame_counts')
+    .asFunction();
+
+final _ResultPixelsFunc _resultPixels = _lib
+    .lookup<ffi.NativeFunction<_CResultPixelsFunc>>('stitch_result_pixels')
+    .asFunction();
+
+final _ResultEncodeFunc _resultEncode = _lib
+    .lookup<ffi.NativeFunction<_CResultEncodeFunc>>('stitch_result_encode')
+    .asFunction();
+
+final _ResultWriteFunc _resultWrite = _lib
+    .lookup<ffi.NativeFunction<_CResultWriteFunc>>('stitch_result_write')
+    .asFunction();
+
+final _ResultReleaseFunc _resultRetain = _lib
+    .lookup<ffi.NativeFunction<_CResultReleaseFunc>>('stitch_result_retain')
+    .asFunction();
+
+final ffi.Pointer<ffi.NativeFunction<_CResultReleaseFunc>> _resultReleasePtr =
+    _lib.lookup<ffi.NativeFunction<_CResultReleaseFunc>>(
+        'stitch_result_release');
+
+final _ResultReleaseFunc _resultRelease = _resultReleasePtr.asFunction();
+
+final _JobSubmitImagesFunc _jobSubmitImages = _lib
+    .lookup<ffi.NativeFunction<_CJobSubmitImagesFunc>>(
+        'stitch_job_submit_images')
+    .asFunction();
+
+final _JobSubmitSessionFunc _jobSubmitSession = _lib
+    .lookup<ffi.NativeFunction<_CJobSubmitSessionFunc>>(
+        'stitch_job_submit_session')
+    .asFunction();
+
+final _JobSubmitRenderFunc _jobSubmitRender = _lib
+    .lookup<ffi.NativeFunction<_CJobSubmitRenderFunc>>(
+        'stitch_job_submit_render')
+    .asFunction();
+
+final _JobCancelFunc _jobCancel = _lib
+    .lookup<ffi.NativeFunction<_CJobCancelFunc>>('stitch_job_cancel')
+    .asFunction();
+
+final _QualityScoreFunc _qualityScore = _lib
+    .lookup<ffi.NativeFunction<_CQualityScoreFunc>>('frame_quality_score')
+    .asFunction();
+
+final _FeatureBenchmarkFunc _featureBenchmark = _lib
+    .lookup<ffi.NativeFunction<_CFeatureBenchmarkFunc>>('feature_benchmark')
+    .asFunction();
+
+final _GuideCreateFunc _guideCreate = _lib
+    .lookup<ffi.NativeFunction<_CGuideCreateFunc>>('scan_guide_create')
+    .asFunction();
+
+final _GuideUpdateFunc _guideUpdate = _lib
+    .lookup<ffi.NativeFunction<_CGuideUpdateFunc>>('scan_guide_update')
+    .asFunction();
+
+final _GuideFunc _guideMarkCaptured = _lib
+    .lookup<ffi.NativeFunction<_CGuideFunc>>('scan_guide_mark_captured')
+    .asFunction();
+
+final _GuideFunc _guideDestroy = _lib
+    .lookup<ffi.NativeFunction<_CGuideFunc>>('scan_guide_destroy')
+    .asFunction();
+
+final _SetCanvasBudgetFunc _setCanvasBudget = _lib
+    .lookup<ffi.NativeFunction<_CSetCanvasBudgetFunc>>(
+        'stitch_set_canvas_budget')
+    .asFunction();
+
+final _SetFeatureCacheFunc _setFeatureCache = _lib
+    .lookup<ffi.NativeFunction<_CSetFeatureCacheFunc>>(
+        'stitch_set_feature_cache')
+    .asFunction();
+
+final _ConfigDefaultsFunc _configDefaults = _lib
+    .lookup<ffi.NativeFunction<_CConfigDefaultsFunc>>('stitch_config_defaults')
+    .asFunction();
+
+final _ConfigValidateFunc _configValidate = _lib
+    .lookup<ffi.NativeFunction<_CConfigValidateFunc>>('stitch_config_validate')
+    .asFunction();
+
+final _SessionDestroyFunc _sessionDestroy = _lib
+    .lookup<ffi.NativeFunction<_CSessionDestroyFunc>>('stitch_session_destroy')
+    .asFunction();
+
 String opencvVersion() {
   return _version().toDartString();
 }
 
-void stitchImages(StitchImagesArguments args) {
-  final imagePaths = args.imagePaths;
-  final int numImages = imagePaths.length;
+// Caps the memory held by the stitching canvas. Tiles beyond [budgetBytes]
+// are spilled to a scratch file in [scratchDir] (e.g. the app cache
+// directory). A non-positive budget keeps the native default.
+void setCanvasBudget({int budgetBytes = 0, required String scratchDir}) {
+  final dirPtr = scratchDir.toNativeUtf8();
+  _setCanvasBudget(budgetBytes, dirPtr);
+  malloc.free(dirPtr);
+}
 
-  // Get timestamps of images
-  final List<int> timestamps = imagePaths.map((imagePath) {
-    return File(imagePath!).lastModifiedSync().millisecondsSinceEpoch;
-  }).toList();
+// Keeps the keypoints and descriptors of every stitched frame in [dir],
+// keyed by the frame's pixels and the detector settings, so stitching the
+// same photos again (a retry with another config, a QA re-run) skips
+// feature detection. Least recently used entries are evicted beyond
+// [maxBytes]; a non-positive value keeps the native default. An empty
+// [dir] disables the cache.
+void setFeatureCache({required String dir, int maxBytes = 0}) {
+  final dirPtr = dir.toNativeUtf8();
+  _setFeatureCache(dirPtr, maxBytes);
+  malloc.free(dirPtr);
+}
 
-  // Allocate memory for timestamps
-  final ffi.Pointer<ffi.Int64> timestampsPtr =
-  malloc.allocate<ffi.Int64>(ffi.sizeOf<ffi.Int64>() * numImages);
+/// Stitching backend. Must match `StitchEngine` in stitch_config.hpp.
+enum StitchEngine {
+  /// OpenCV's Stitcher in SCANS mode.
+  stitcherScans,
 
-  // Copy timestamps to native memory
-  for (int i = 0; i < numImages; i++) {
-    timestampsPtr[i] = timestamps[i];
+  /// Pairwise chain: phase correlation, features when it fails.
+  billChain,
+
+  /// Pairwise chain with phase correlation only; fastest, translation only.
+  translation,
+}
+
+/// Must match `FeatureDetector` in stitch_config.hpp.
+///
+/// [upright] skips orientation and scale-space estimation: FAST corners on a
+/// grid over a few fixed pyramid levels with an upright binary descriptor.
+/// It suits scans whose frames tilt only a few degrees relative to each
+/// other.
+enum FeatureDetector { orb, sift, akaze, brisk, upright }
+
+/// Must match `BlenderType` in stitch_config.hpp.
+enum BlenderType { none, feather, multiBand }
+
+/// Must match `OutputFormat` in stitch_config.hpp.
+enum OutputFormat { jpeg, png, webp }
+
+/// Layout of `StitchConfig` in stitch_config.hpp, version [_configVersion].
+final class _CStitchConfig extends ffi.Struct {
+  @ffi.Int32()
+  external int version;
+  @ffi.Int32()
+  external int engine;
+  @ffi.Int32()
+  external int detector;
+  @ffi.Int32()
+  external int detectorFeatures;
+  @ffi.Int32()
+  external int maxFeatures;
+  @ffi.Int32()
+  external int matchWindow;
+  @ffi.Double()
+  external double workScale;
+  @ffi.Double()
+  external double registrationMegapix;
+  @ffi.Double()
+  external double seamMegapix;
+  @ffi.Double()
+  external double composeMegapix;
+  @ffi.Double()
+  external double matchConfidence;
+  @ffi.Double()
+  external double panoConfidenceThresh;
+  @ffi.Int32()
+  external int blender;
+  @ffi.Int32()
+  external int outputFormat;
+  @ffi.Int32()
+  external int outputQuality;
+  @ffi.Int32()
+  external int qualityPrefilter;
+  @ffi.Double()
+  external double cullMinOverlap;
+  @ffi.Double()
+  external double composeScale;
+}
+
+const int _configVersion = 2;
+
+/// Stitching parameters passed to the native side. Fields left null keep
+/// the native defaults, so only the knobs being tuned need to be set.
+class StitchConfig {
+  final StitchEngine? engine;
+  final FeatureDetector? detector;
+
+  /// Keypoints requested from the detector, 0 for its own default.
+  final int? detectorFeatures;
+
+  /// Keypoints kept per image after spreading them out.
+  final int? maxFeatures;
+
+  /// Following images each image is matched with (Stitcher engine); zero or
+  /// less matches every pair.
+  final int? matchWindow;
+
+  /// Scale at which the input photos are decoded, in (0, 1].
+  final double? workScale;
+  final double? registrationMegapix;
+  final double? seamMegapix;
+
+  /// Compositing resolution; -1 keeps the work resolution.
+  final double? composeMegapix;
+  final double? matchConfidence;
+  final double? panoConfidenceThresh;
+
+  /// Blending of the Stitcher engine, [BlenderType.multiBand] by default.
+  /// [BlenderType.feather] composites into a tiled canvas whose memory use
+  /// does not grow with the bill, but without seam finding, so overlaps can
+  /// show ghosting; the other blenders hold the whole panorama in memory.
+  final BlenderType? blender;
+
+  /// Encoding of files written natively, e.g. by [stitchImages].
+  final OutputFormat? outputFormat;
+  final int? outputQuality;
+  final bool? qualityPrefilter;
+
+  /// Minimum overlap kept between frames when dropping redundant ones;
+  /// non-positive disables culling.
+  final double? cullMinOverlap;
+
+  /// Output resolution relative to the original photos, in (0, 1]. Above
+  /// [workScale], frames are registered on the small proxies and then
+  /// re-read at this scale for compositing, so speed ([workScale],
+  /// [registrationMegapix]) and output detail are tuned independently.
+  final double? composeScale;
+
+  const StitchConfig({
+    this.engine,
+    this.detector,
+    this.detectorFeatures,
+    this.maxFeatures,
+    this.matchWindow,
+    this.workScale,
+    this.registrationMegapix,
+    this.seamMegapix,
+    this.composeMegapix,
+    this.matchConfidence,
+    this.panoConfidenceThresh,
+    this.blender,
+    this.outputFormat,
+    this.outputQuality,
+    this.qualityPrefilter,
+    this.cullMinOverlap,
+    this.composeScale,
+  });
+
+  /// Throws [ArgumentError] if the native side rejects the config.
+  void validate() {
+    final ptr = _toNative(this);
+    malloc.free(ptr);
   }
+}
+
+/// Copies [config] into a native struct, or returns [ffi.nullptr] for the
+/// native defaults. Rejected configs throw before any work is queued.
+/// Free with [malloc.free].
+ffi.Pointer<_CStitchConfig> _toNative(StitchConfig? config) {
+  if (config == null) return ffi.nullptr;
+  final ptr = malloc<_CStitchConfig>();
+  if (_configDefaults(ptr, _configVersion) != 0) {
+    malloc.free(ptr);
+    throw StateError('Native library does not support config version '
+        '$_configVersion');
+  }
+  final c = ptr.ref;
+  if (config.engine != null) c.engine = config.engine!.index;
+  if (config.detector != null) c.detector = config.detector!.index;
+  c.detectorFeatures = config.detectorFeatures ?? c.detectorFeatures;
+  c.maxFeatures = config.maxFeatures ?? c.maxFeatures;
+  c.matchWindow = config.matchWindow ?? c.matchWindow;
+  c.workScale = config.workScale ?? c.workScale;
+  c.registrationMegapix =
+      config.registrationMegapix ?? c.registrationMegapix;
+  c.seamMegapix = config.seamMegapix ?? c.seamMegapix;
+  c.composeMegapix = config.composeMegapix ?? c.composeMegapix;
+  c.matchConfidence = config.matchConfidence ?? c.matchConfidence;
+  c.panoConfidenceThresh =
+      config.panoConfidenceThresh ?? c.panoConfidenceThresh;
+  if (config.blender != null) c.blender = config.blender!.index;
+  if (config.outputFormat != null) {
+    c.outputFormat = config.outputFormat!.index;
+  }
+  c.outputQuality = config.outputQuality ?? c.outputQuality;
+  if (config.qualityPrefilter != null) {
+    c.qualityPrefilter = config.qualityPrefilter! ? 1 : 0;
+  }
+  c.cullMinOverlap = config.cullMinOverlap ?? c.cullMinOverlap;
+  c.composeScale = config.composeScale ?? c.composeScale;
+  final status = _configValidate(ptr);
+  if (status != 0) {
+    malloc.free(ptr);
+    throw ArgumentError('Invalid stitch config (status $status)');
+  }
+  return ptr;
+}
+
+void stitchImages(StitchImagesArguments args) {
+  final imagePaths = args.imagePaths;
+  final int numImages = imagePaths.length;
+  final configPtr = _toNative(args.config);
+
+  // Capture timestamps of images, used natively to order the frames
+  final timestampsPtr = _allocTimestamps(imagePaths, args.timestampsUs);
 
   // Allocate memory for image paths
   final ffi.Pointer<ffi.Pointer<Utf8>> pathsPtr =
@@ -70,7 +655,8 @@ void stitchImages(StitchImagesArguments args) {
   }
 
   // Call the C++ function
-  _stitchImages(pathsPtr, numImages, args.outputPath.toNativeUtf8());
+  final outputPtr = args.outputPath.toNativeUtf8();
+  _stitchImages(pathsPtr, timestampsPtr, numImages, outputPtr, configPtr);
 
   // Free allocated memory
   for (int i = 0; i < numImages; i++) {
@@ -78,11 +664,683 @@ void stitchImages(StitchImagesArguments args) {
   }
   malloc.free(pathsPtr);
   malloc.free(timestampsPtr);
+  malloc.free(outputPtr);
+  if (configPtr != ffi.nullptr) malloc.free(configPtr);
+}
+
+/// Same as [stitchImages] but keeps the result in native memory. Returns the
+/// address of a native result handle (0 on failure) so it can cross isolates;
+/// wrap it with [StitchResult.fromAddress] on the receiving side.
+int stitchImagesToResult(List<String?> imagePaths,
+    {List<int>? timestampsUs, StitchConfig? config}) {
+  final int numImages = imagePaths.length;
+  final configPtr = _toNative(config);
+  final timestampsPtr = _allocTimestamps(imagePaths, timestampsUs);
+  final ffi.Pointer<ffi.Pointer<Utf8>> pathsPtr =
+  malloc.allocate<ffi.Pointer<Utf8>>(
+      ffi.sizeOf<ffi.Pointer<Utf8>>() * numImages);
+  for (int i = 0; i < numImages; i++) {
+    pathsPtr[i] = imagePaths[i]!.toNativeUtf8();
+  }
+
+  final result =
+      _stitchImagesResult(pathsPtr, timestampsPtr, numImages, configPtr);
+
+  for (int i = 0; i < numImages; i++) {
+    malloc.free(pathsPtr[i]);
+  }
+  malloc.free(pathsPtr);
+  malloc.free(timestampsPtr);
+  if (configPtr != ffi.nullptr) malloc.free(configPtr);
+  return result.address;
+}
+
+/// Copies per-frame capture timestamps (microseconds) to native memory,
+/// falling back to each file's last-modified time. Free with [malloc.free].
+ffi.Pointer<ffi.Int64> _allocTimestamps(
+    List<String?> imagePaths, List<int>? timestampsUs) {
+  final int numImages = imagePaths.length;
+  final ffi.Pointer<ffi.Int64> timestampsPtr =
+  malloc.allocate<ffi.Int64>(ffi.sizeOf<ffi.Int64>() * numImages);
+  for (int i = 0; i < numImages; i++) {
+    timestampsPtr[i] = timestampsUs != null
+        ? timestampsUs[i]
+        : File(imagePaths[i]!).lastModifiedSync().microsecondsSinceEpoch;
+  }
+  return timestampsPtr;
 }
 
 class StitchImagesArguments {
   final List<String?> imagePaths;
   final String outputPath;
 
-  StitchImagesArguments(this.imagePaths, this.outputPath);
+  /// Capture time of each image in microseconds; defaults to file times.
+  final List<int>? timestampsUs;
+
+  /// Native defaults when null.
+  final StitchConfig? config;
+
+  StitchImagesArguments(this.imagePaths, this.outputPath,
+      {this.timestampsUs, this.config});
+}
+
+/// Sharpness and exposure of a frame, scored natively on its luma plane.
+class FrameQuality {
+  /// Share of gradient energy lost to a slight blur, 0..1; low when blurred.
+  final double sharpness;
+  final double tenengrad;
+  final double clippedRatio;
+  final double meanLuma;
+  final bool acceptable;
+
+  const FrameQuality({
+    required this.sharpness,
+    required this.tenengrad,
+    required this.clippedRatio,
+    required this.meanLuma,
+    required this.acceptable,
+  });
+}
+
+/// Scores a camera luma plane before it is handed to the stitcher.
+FrameQuality scoreFrameQuality({
+  required Uint8List y,
+  required int width,
+  required int height,
+  required int yRowStride,
+}) {
+  final lumaPtr = malloc.allocate<ffi.Uint8>(y.length);
+  lumaPtr.asTypedList(y.length).setAll(0, y);
+  final quality = _scoreLuma(lumaPtr, width, height, yRowStride);
+  malloc.free(lumaPtr);
+  return quality;
+}
+
+FrameQuality _scoreLuma(
+    ffi.Pointer<ffi.Uint8> luma, int width, int height, int yRowStride) {
+  final outPtr = malloc.allocate<ffi.Double>(4 * ffi.sizeOf<ffi.Double>());
+  final acceptable =
+      _qualityScore(luma, width, height, yRowStride, outPtr) != 0;
+  final quality = FrameQuality(
+    sharpness: outPtr[0],
+    tenengrad: outPtr[1],
+    clippedRatio: outPtr[2],
+    meanLuma: outPtr[3],
+    acceptable: acceptable,
+  );
+  malloc.free(outPtr);
+  return quality;
+}
+
+/// Speed and accuracy of one [FeatureDetector] on synthetic scan pairs.
+class FeatureBenchmark {
+  final FeatureDetector detector;
+  final int pairs;
+  final double msPerFrame;
+  final double keypointsPerFrame;
+
+  /// Share of matches that agree with the known synthetic motion.
+  final double inlierRatio;
+
+  /// Share of pairs matched with enough confidence to be stitched.
+  final double registeredRatio;
+
+  const FeatureBenchmark({
+    required this.detector,
+    required this.pairs,
+    required this.msPerFrame,
+    required this.keypointsPerFrame,
+    required this.inlierRatio,
+    required this.registeredRatio,
+  });
+}
+
+/// Benchmarks ORB, SIFT and the upright extractor on [imagePaths]: each
+/// receipt photo is paired with a copy moved like a downward scan (shifted,
+/// tilted by a few degrees, with noise). Blocks for several seconds; call
+/// it from a background isolate.
+List<FeatureBenchmark> benchmarkFeatures(List<String> imagePaths) {
+  const int fields = 6;
+  final int numImages = imagePaths.length;
+  final pathsPtr = malloc.allocate<ffi.Pointer<Utf8>>(
+      ffi.sizeOf<ffi.Pointer<Utf8>>() * numImages);
+  for (int i = 0; i < numImages; i++) {
+    pathsPtr[i] = imagePaths[i].toNativeUtf8();
+  }
+  final outPtr = malloc.allocate<ffi.Double>(
+      FeatureDetector.values.length * fields * ffi.sizeOf<ffi.Double>());
+  final rows = _featureBenchmark(pathsPtr, numImages, outPtr);
+  final results = [
+    for (int i = 0; i < rows; i++)
+      FeatureBenchmark(
+        detector: FeatureDetector.values[outPtr[i * fields].toInt()],
+        pairs: outPtr[i * fields + 1].toInt(),
+        msPerFrame: outPtr[i * fields + 2],
+        keypointsPerFrame: outPtr[i * fields + 3],
+        inlierRatio: outPtr[i * fields + 4],
+        registeredRatio: outPtr[i * fields + 5],
+      ),
+  ];
+  for (int i = 0; i < numImages; i++) {
+    malloc.free(pathsPtr[i]);
+  }
+  malloc.free(pathsPtr);
+  malloc.free(outPtr);
+  return results;
+}
+
+/// Live-scan guidance for one preview frame. Displacement and velocity are
+/// fractions of the frame size (1.0 = a whole frame) since the last capture.
+class ScanGuidance {
+  final double displacementX;
+  final double displacementY;
+  final double velocityX;
+  final double velocityY;
+  final double overlap;
+  final double blurRisk;
+  final double confidence;
+  final bool captureNow;
+
+  const ScanGuidance({
+    required this.displacementX,
+    required this.displacementY,
+    required this.velocityX,
+    required this.velocityY,
+    required this.overlap,
+    required this.blurRisk,
+    required this.confidence,
+    required this.captureNow,
+  });
+}
+
+/// Decides when to capture from the preview luma, so the capture rate follows
+/// the actual camera motion instead of a fixed timer.
+class ScanGuide {
+  final ffi.Pointer<ffi.Void> _handle = _guideCreate();
+  final ffi.Pointer<ffi.Double> _out = malloc.allocate<ffi.Double>(
+      7 * ffi.sizeOf<ffi.Double>());
+  ffi.Pointer<ffi.Uint8> _luma = ffi.nullptr;
+  int _lumaCapacity = 0;
+  int _width = 0;
+  int _height = 0;
+  int _yRowStride = 0;
+
+  /// Evaluates a preview frame. [y] is the luma plane; [rotation] the
+  /// clockwise degrees that bring it upright.
+  ScanGuidance update({
+    required Uint8List y,
+    required int width,
+    required int height,
+    required int yRowStride,
+    int rotation = 0,
+    required int timestampUs,
+  }) {
+    if (_lumaCapacity < y.length) {
+      if (_luma != ffi.nullptr) malloc.free(_luma);
+      _luma = malloc.allocate<ffi.Uint8>(y.length);
+      _lumaCapacity = y.length;
+    }
+    _luma.asTypedList(y.length).setAll(0, y);
+    _width = width;
+    _height = height;
+    _yRowStride = yRowStride;
+    final capture = _guideUpdate(_handle, _luma, width, height, yRowStride,
+        rotation, timestampUs, _out);
+    return ScanGuidance(
+      displacementX: _out[0],
+      displacementY: _out[1],
+      velocityX: _out[2],
+      velocityY: _out[3],
+      overlap: _out[4],
+      blurRisk: _out[5],
+      confidence: _out[6],
+      captureNow: capture != 0,
+    );
+  }
+
+  /// Same as [scoreFrameQuality] for the frame passed to the last [update],
+  /// scored from the luma copy the guide already holds.
+  FrameQuality scoreLastFrame() {
+    if (_luma == ffi.nullptr) {
+      throw StateError('update() has not been called');
+    }
+    return _scoreLuma(_luma, _width, _height, _yRowStride);
+  }
+
+  /// The frame passed to the last [update] was captured.
+  void markCaptured() => _guideMarkCaptured(_handle);
+
+  void destroy() {
+    _guideDestroy(_handle);
+    malloc.free(_out);
+    if (_luma != ffi.nullptr) malloc.free(_luma);
+    _luma = ffi.nullptr;
+  }
+}
+
+/// Incremental stitching session backed by a native worker thread.
+///
+/// Frames pushed while the user is still scanning are decoded and registered
+/// against their predecessor in the background, so [finalize] only has to
+/// composite the result.
+class StitchSession {
+  static const int ok = 0;
+  static const int errNeedMoreImages = 1;
+  static const int errWriteFail = 2;
+  static const int errInvalid = 3;
+
+  final ffi.Pointer<ffi.Void> _handle;
+
+  // Reusable native staging buffers for camera planes, grown on demand
+  final List<ffi.Pointer<ffi.Uint8>> _planeBuffers = [];
+  final List<int> _planeCapacities = [];
+
+  StitchSession() : _handle = _sessionCreate();
+
+  /// Re-attaches to a session created in another isolate.
+  StitchSession.fromAddress(int address)
+      : _handle = ffi.Pointer<ffi.Void>.fromAddress(address);
+
+  int get address => _handle.address;
+
+  /// Queues an image file for registration and returns immediately.
+  /// [timestampUs] is its capture time, or 0 if unknown; it lets registration
+  /// predict the motion since the last frame.
+  void pushFrame(String imagePath, {int timestampUs = 0}) {
+    final pathPtr = imagePath.toNativeUtf8();
+    _sessionPushFrame(_handle, pathPtr, timestampUs);
+    malloc.free(pathPtr);
+  }
+
+  /// Queues a YUV420 camera frame. The native side wraps the planes without
+  /// copying and downsamples them before returning, so the staging buffers
+  /// are reused for the next frame. When [u] and [v] are the same interleaved
+  /// plane (iOS bi-planar), pass the same bytes for both with [vOffset] = 1.
+  void pushYuv420({
+    required Uint8List y,
+    required Uint8List u,
+    required Uint8List v,
+    required int width,
+    required int height,
+    required int yRowStride,
+    required int uvRowStride,
+    required int uvPixelStride,
+    int vOffset = 0,
+    int rotation = 0,
+    required int timestampUs,
+  }) {
+    final yPtr = _stage(0, y);
+    final uPtr = _stage(1, u);
+    final vPtr = vOffset > 0 ? uPtr + vOffset : _stage(2, v);
+    _sessionPushYuv420(_handle, yPtr, uPtr, vPtr, width, height, yRowStride,
+        uvRowStride, uvPixelStride, rotation, timestampUs);
+  }
+
+  /// Live scanning: call with every preview frame. The frame is tracked with
+  /// optical flow and only queued when it becomes a keyframe, which is
+  /// reported by returning true.
+  bool trackYuv420({
+    required Uint8List y,
+    required Uint8List u,
+    required Uint8List v,
+    required int width,
+    required int height,
+    required int yRowStride,
+    required int uvRowStride,
+    required int uvPixelStride,
+    int vOffset = 0,
+    int rotation = 0,
+    required int timestampUs,
+  }) {
+    final yPtr = _stage(0, y);
+    final uPtr = _stage(1, u);
+    final vPtr = vOffset > 0 ? uPtr + vOffset : _stage(2, v);
+    return _sessionTrackYuv420(_handle, yPtr, uPtr, vPtr, width, height,
+            yRowStride, uvRowStride, uvPixelStride, rotation, timestampUs) !=
+        0;
+  }
+
+  ffi.Pointer<ffi.Uint8> _stage(int index, Uint8List bytes) {
+    while (_planeBuffers.length <= index) {
+      _planeBuffers.add(ffi.nullptr);
+      _planeCapacities.add(0);
+    }
+    // Tail padding keeps the last interleaved chroma pair in bounds
+    final required = bytes.length + 64;
+    if (_planeCapacities[index] < required) {
+      if (_planeBuffers[index] != ffi.nullptr) {
+        malloc.free(_planeBuffers[index]);
+      }
+      _planeBuffers[index] = malloc.allocate<ffi.Uint8>(required);
+      _planeCapacities[index] = required;
+    }
+    _planeBuffers[index].asTypedList(bytes.length).setAll(0, bytes);
+    return _planeBuffers[index];
+  }
+
+  /// Blocks until every pushed frame is registered, then writes the stitched
+  /// image to [outputPath], encoded with the output format and quality of
+  /// [config] (the defaults when null). Returns one of the status constants
+  /// above.
+  int finalize(String outputPath, {StitchConfig? config}) {
+    final configPtr = _toNative(config);
+    final outputPtr = outputPath.toNativeUtf8();
+    final status = _sessionFinalize(_handle, outputPtr, configPtr);
+    malloc.free(outputPtr);
+    if (configPtr != ffi.nullptr) malloc.free(configPtr);
+    return status;
+  }
+
+  /// Like [finalize] but keeps the stitched image in native memory. Returns
+  /// the address of a native result handle, or 0 on failure.
+  int finalizeToResult() {
+    return _sessionFinalizeResult(_handle).address;
+  }
+
+  void destroy() {
+    _sessionDestroy(_handle);
+    for (final buffer in _planeBuffers) {
+      if (buffer != ffi.nullptr) {
+        malloc.free(buffer);
+      }
+    }
+    _planeBuffers.clear();
+    _planeCapacities.clear();
+  }
+}
+
+bool _writeResult(int address, String outputPath, int quality) {
+  final pathPtr = outputPath.toNativeUtf8();
+  final ok = _resultWrite(
+      ffi.Pointer<ffi.Void>.fromAddress(address), pathPtr, quality);
+  malloc.free(pathPtr);
+  return ok != 0;
+}
+
+/// How many frames survived each filter before stitching.
+class StitchFrameCounts {
+  /// Frames loaded from disk.
+  final int input;
+
+  /// Frames dropped as blurred or badly exposed.
+  final int rejectedQuality;
+
+  /// Frames dropped as redundant, already covered by their neighbours.
+  final int culled;
+
+  /// Frames handed to the stitcher.
+  final int stitched;
+
+  const StitchFrameCounts({
+    required this.input,
+    required this.rejectedQuality,
+    required this.culled,
+    required this.stitched,
+  });
+}
+
+/// Stitched image held in native memory.
+///
+/// Pixels are exposed as an external view over the native buffer, so the
+/// result can be displayed without encoding, writing and decoding a file.
+/// The native buffer is reference counted: the handle and every view handed
+/// out by [pixels] keep it alive until their finalizers run.
+class StitchResult implements ffi.Finalizable {
+  static const int formatRgba8888 = 0;
+
+  static final _finalizer = ffi.NativeFinalizer(_resultReleasePtr.cast());
+
+  final ffi.Pointer<ffi.Void> _handle;
+
+  /// Takes over the handle at [address]. Throws [ArgumentError] for 0, the
+  /// address native calls return on failure.
+  StitchResult.fromAddress(int address)
+      : _handle = ffi.Pointer<ffi.Void>.fromAddress(address) {
+    if (address == 0) {
+      throw ArgumentError.value(address, 'address', 'null result handle');
+    }
+    _finalizer.attach(this, _handle, detach: this);
+  }
+
+  int get width => _resultWidth(_handle);
+
+  int get height => _resultHeight(_handle);
+
+  /// Bytes per row of [pixels].
+  int get stride => _resultStride(_handle);
+
+  int get format => _resultFormat(_handle);
+
+  /// Frame counts of the pipeline that produced this result; all zero for
+  /// results of an incremental [StitchSession].
+  StitchFrameCounts get frameCounts {
+    final countsPtr = malloc.allocate<ffi.Int32>(4 * ffi.sizeOf<ffi.Int32>());
+    _resultFrameCounts(_handle, countsPtr);
+    final counts = StitchFrameCounts(
+      input: countsPtr[0],
+      rejectedQuality: countsPtr[1],
+      culled: countsPtr[2],
+      stitched: countsPtr[3],
+    );
+    malloc.free(countsPtr);
+    return counts;
+  }
+
+  /// Zero-copy view over the native pixel buffer.
+  Uint8List get pixels {
+    _resultRetain(_handle);
+    return _resultPixels(_handle).asTypedList(
+      stride * height,
+      finalizer: _resultReleasePtr.cast(),
+      token: _handle,
+    );
+  }
+
+  /// Encodes the result (e.g. '.jpg', '.png') and returns a copy of the bytes.
+  Uint8List? encode({String ext = '.jpg', int quality = 95}) {
+    final extPtr = ext.toNativeUtf8();
+    final lengthPtr = malloc.allocate<ffi.Int32>(ffi.sizeOf<ffi.Int32>());
+    final data = _resultEncode(_handle, extPtr, quality, lengthPtr);
+    final length = lengthPtr.value;
+    malloc.free(extPtr);
+    malloc.free(lengthPtr);
+    if (data == ffi.nullptr) return null;
+    return Uint8List.fromList(data.asTypedList(length));
+  }
+
+  /// Encodes and writes the result on a background isolate. Results of a
+  /// full stitch or a re-render also write their registration sidecar
+  /// (`<outputPath>.reg.yml.gz`) for [StitchJobs.renderRegistration].
+  Future<bool> persist(String outputPath, {int quality = 95}) async {
+    _resultRetain(_handle);
+    final address = _handle.address;
+    try {
+      return await Isolate.run(
+          () => _writeResult(address, outputPath, quality));
+    } finally {
+      _resultRelease(_handle);
+    }
+  }
+
+  /// Releases the handle early. Views returned by [pixels] stay valid.
+  void dispose() {
+    _finalizer.detach(this);
+    _resultRelease(_handle);
+  }
+}
+
+enum JobPriority {
+  /// Preview work the user is waiting on; always scheduled first.
+  interactive,
+
+  /// Final composites and re-exports.
+  background,
+}
+
+/// Pipeline stages reported by [StitchJob.onProgress], in execution order.
+/// Must match `StitchStage` in stitch_control.hpp.
+enum StitchStage {
+  decode,
+  preprocess,
+  features,
+  matching,
+  estimation,
+  seams,
+  blending,
+  encode,
+}
+
+typedef StitchProgressCallback = void Function(
+    StitchStage stage, int done, int total);
+
+/// A job queued on the native worker pool.
+class StitchJob {
+  StitchJob._(this.id, this.onProgress);
+
+  final int id;
+  final StitchProgressCallback? onProgress;
+  final Completer<StitchResult?> _completer = Completer<StitchResult?>();
+  bool _cancelled = false;
+
+  /// Completes with the stitched image, or null if the job failed or was
+  /// cancelled.
+  Future<StitchResult?> get result => _completer.future;
+
+  /// Whether the job ended because of [cancel].
+  bool get cancelled => _cancelled;
+
+  /// Asks the native job to stop at its next checkpoint (between stages or
+  /// frames). [result] then completes with null.
+  void cancel() {
+    if (!_completer.isCompleted) _jobCancel(id);
+  }
+
+  /// Overall progress in [0, 1], assuming stages of equal weight.
+  static double fraction(StitchStage stage, int done, int total) {
+    final stageDone = total > 0 ? (done / total).clamp(0.0, 1.0) : 0.0;
+    return (stage.index + stageDone) / StitchStage.values.length;
+  }
+}
+
+/// Client for the persistent native worker pool.
+///
+/// Jobs are submitted without blocking and complete through a single
+/// long-lived [ffi.NativeCallable.listener], so no isolate is spawned per
+/// stitch and the native workers keep their Stitcher/ORB objects warm.
+class StitchJobs {
+  StitchJobs._() {
+    _callback = ffi.NativeCallable<_CJobCompletionFunc>.listener(_onComplete);
+    _progress = ffi.NativeCallable<_CJobProgressFunc>.listener(_onProgress);
+  }
+
+  static const int _statusCancelled = 2;
+
+  static final StitchJobs instance = StitchJobs._();
+
+  late final ffi.NativeCallable<_CJobCompletionFunc> _callback;
+  late final ffi.NativeCallable<_CJobProgressFunc> _progress;
+  final Map<int, StitchJob> _pending = {};
+
+  /// [timestampsUs] are the capture times used to order the images; they
+  /// default to the files' last-modified times. An invalid [config] throws
+  /// [ArgumentError] before the job is queued.
+  StitchJob stitchImages(List<String?> imagePaths,
+      {List<int>? timestampsUs,
+      StitchConfig? config,
+      JobPriority priority = JobPriority.background,
+      StitchProgressCallback? onProgress}) {
+    final int numImages = imagePaths.length;
+    final configPtr = _toNative(config);
+    final timestampsPtr = _allocTimestamps(imagePaths, timestampsUs);
+    final ffi.Pointer<ffi.Pointer<Utf8>> pathsPtr =
+    malloc.allocate<ffi.Pointer<Utf8>>(
+        ffi.sizeOf<ffi.Pointer<Utf8>>() * numImages);
+    for (int i = 0; i < numImages; i++) {
+      pathsPtr[i] = imagePaths[i]!.toNativeUtf8();
+    }
+
+    // Paths and timestamps are copied natively before submit returns
+    final jobId = _jobSubmitImages(
+        pathsPtr,
+        timestampsPtr,
+        numImages,
+        priority.index,
+        _callback.nativeFunction,
+        _progressFunction(onProgress),
+        configPtr);
+
+    for (int i = 0; i < numImages; i++) {
+      malloc.free(pathsPtr[i]);
+    }
+    malloc.free(pathsPtr);
+    malloc.free(timestampsPtr);
+    if (configPtr != ffi.nullptr) malloc.free(configPtr);
+    return _track(jobId, onProgress);
+  }
+
+  /// Finalizes [session] on the pool. The session must stay alive until the
+  /// job's result completes.
+  StitchJob finalizeSession(StitchSession session,
+      {JobPriority priority = JobPriority.interactive,
+      StitchProgressCallback? onProgress}) {
+    final jobId = _jobSubmitSession(session._handle, priority.index,
+        _callback.nativeFunction, _progressFunction(onProgress));
+    return _track(jobId, onProgress);
+  }
+
+  /// Re-renders a stitch from its registration sidecar
+  /// (`<output>.reg.yml.gz`, written next to every stitched output) at
+  /// [scale] times the resolution of the source photos, in (0, 1]. Only the
+  /// source photos are decoded, warped and blended again; features,
+  /// matching and estimation are skipped. The photos must still exist at
+  /// the recorded paths.
+  StitchJob renderRegistration(String registrationPath,
+      {double scale = 1.0,
+      JobPriority priority = JobPriority.background,
+      StitchProgressCallback? onProgress}) {
+    if (!(scale > 0 && scale <= 1)) {
+      throw ArgumentError.value(scale, 'scale', 'must be in (0, 1]');
+    }
+    final pathPtr = registrationPath.toNativeUtf8();
+    final jobId = _jobSubmitRender(pathPtr, scale, priority.index,
+        _callback.nativeFunction, _progressFunction(onProgress));
+    malloc.free(pathPtr);
+    return _track(jobId, onProgress);
+  }
+
+  // Jobs without a listener skip the native -> Dart progress messages
+  ffi.Pointer<ffi.NativeFunction<_CJobProgressFunc>> _progressFunction(
+      StitchProgressCallback? onProgress) =>
+      onProgress == null ? ffi.nullptr : _progress.nativeFunction;
+
+  StitchJob _track(int jobId, StitchProgressCallback? onProgress) {
+    final job = StitchJob._(jobId, onProgress);
+    // 0: the native side rejected the arguments and created no job
+    if (jobId == 0) {
+      job._completer.complete(null);
+    } else {
+      _pending[jobId] = job;
+    }
+    return job;
+  }
+
+  void _onProgress(int jobId, int stage, int done, int total) {
+    final job = _pending[jobId];
+    if (job == null || stage < 0 || stage >= StitchStage.values.length) {
+      return;
+    }
+    job.onProgress?.call(StitchStage.values[stage], done, total);
+  }
+
+  void _onComplete(int jobId, int status, ffi.Pointer<ffi.Void> result) {
+    final job = _pending.remove(jobId);
+    final stitched =
+        result == ffi.nullptr ? null : StitchResult.fromAddress(result.address);
+    if (job == null) {
+      stitched?.dispose();
+      return;
+    }
+    job._cancelled = status == _statusCancelled;
+    job._completer.complete(stitched);
+  }
 }
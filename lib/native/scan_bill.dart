@@ -1,12 +1,7 @@
-import 'dart:async';
-import 'dart:io';
-import 'dart:isolate';
-
 import 'package:camera/camera.dart';
 import 'package:flutter/material.dart';
 import 'package:long_shot_app/widgets/frame/frame_overlay.dart';
 import 'package:long_shot_app/widgets/overlay.dart';
-import 'package:path_provider/path_provider.dart';
 
 import '../display_image.dart';
 import 'native_main.dart';
@@ -20,19 +15,24 @@ class ScanBillScreen extends StatefulWidget {
 }
 
 class ScanBillScreenState extends State<ScanBillScreen> {
+  // Below this overlap with the last capture a frame is taken even if its
+  // quality is poor, so the receipt is not left with a gap
+  static const double _forceCaptureOverlap = 0.3;
+
   CameraController? _controller;
-  List<XFile> _images = [];
+  int _capturedFrames = 0;
   bool _isRecording = false;
-  bool _isCapturingPicture = false;
-  Timer? _captureTimer;
   bool _isAligned = false;
   // var _stitchedImage = Uint8List(0);
   double _currentZoomLevel = 1.0;
   double _baseZoomLevel = 1.0;
   late double maxAllowedZoomLevel;
-  int _imageCounter = 1; // Start with 1 for the first image filename
   bool _isLoading = false;
   bool _isProcessing = false;
+  StitchSession? _session;
+  ScanGuide? _guide;
+  StitchJob? _job;
+  double _progress = 0;
 
   @override
   void initState() {
@@ -64,6 +64,14 @@ class ScanBillScreenState extends State<ScanBillScreen> {
   @override
   void dispose() {
     _controller?.dispose();
+    _guide?.destroy();
+    _guide = null;
+    // The running job releases the session once it stops
+    _job?.cancel();
+    if (!_isProcessing) {
+      _session?.destroy();
+      _session = null;
+    }
     super.dispose();
   }
 
@@ -72,60 +80,88 @@ class ScanBillScreenState extends State<ScanBillScreen> {
   //
   // }
 
-  Future<void> _captureImage() async {
-    if (!_isCapturingPicture && _isAligned) {
-      setState(() {
-        _isCapturingPicture = true;
-      });
-
-      final image = await _controller!.takePicture();
-      final bytes = await image.readAsBytes();
-
-      final String fileName = '$_imageCounter.jpg';
-      final File file =
-          File('${(await getTemporaryDirectory()).path}/$fileName');
-      await file.writeAsBytes(bytes);
-
-      _images.add(XFile(file.path, name: fileName));
-      _imageCounter++;
-
-      // if (_images.length >= 2) {
-      //   _stitchImagesForPreview();
-      // }
-
-      if (mounted) {
-        setState(() {
-          _isCapturingPicture = false;
-        });
-      }
+  // Frames come straight from the YUV420 preview stream, so there is no
+  // JPEG encode/decode or temp file per capture. Every preview frame goes
+  // through the native guide, which captures once the view has moved far
+  // enough from the last capture and the motion is slow enough to be sharp.
+  void _onCameraImage(CameraImage image) {
+    final session = _session;
+    final guide = _guide;
+    if (session == null || guide == null) return;
+
+    final planes = image.planes;
+    final yPlane = planes[0];
+    final rotation = _controller!.description.sensorOrientation;
+    final timestampUs = DateTime.now().microsecondsSinceEpoch;
+    final guidance = guide.update(
+      y: yPlane.bytes,
+      width: image.width,
+      height: image.height,
+      yRowStride: yPlane.bytesPerRow,
+      rotation: rotation,
+      timestampUs: timestampUs,
+    );
+    if (!guidance.captureNow || !_isAligned) return;
+
+    // Blurry or badly exposed frames are skipped while there is still overlap
+    // to spare (always for the first frame); the guide keeps asking for a
+    // capture on the next frames. Scored from the guide's copy of the luma
+    // plane, so the plane is copied to native memory once per frame.
+    final quality = guide.scoreLastFrame();
+    if (!quality.acceptable &&
+        (_capturedFrames == 0 || guidance.overlap > _forceCaptureOverlap)) {
+      return;
     }
+
+    final uPlane = planes[1];
+    // iOS delivers bi-planar NV12 (Y + interleaved UV), Android three planes
+    final bool interleaved = planes.length == 2;
+    final vPlane = interleaved ? uPlane : planes[2];
+
+    session.pushYuv420(
+      y: yPlane.bytes,
+      u: uPlane.bytes,
+      v: vPlane.bytes,
+      width: image.width,
+      height: image.height,
+      yRowStride: yPlane.bytesPerRow,
+      uvRowStride: uPlane.bytesPerRow,
+      uvPixelStride: interleaved ? 2 : (uPlane.bytesPerPixel ?? 1),
+      vOffset: interleaved ? 1 : 0,
+      rotation: rotation,
+      timestampUs: timestampUs,
+    );
+    guide.markCaptured();
+    _capturedFrames++;
   }
 
   void _startRecording() async {
+    // The session of the last scan is still owned by its stitch job
+    if (_isProcessing) return;
     setState(() {
       _isRecording = true;
     });
-    _images = [];
-    await _captureImage();
-    _captureTimer =
-        Timer.periodic(const Duration(milliseconds: 1000), (timer) async {
-      await _captureImage();
-    });
+    _capturedFrames = 0;
+    _session?.destroy();
+    _session = StitchSession();
+    _guide?.destroy();
+    _guide = ScanGuide();
+    await _controller!.startImageStream(_onCameraImage);
   }
 
   void _stopRecording() async {
-    _captureTimer?.cancel();
-    _captureTimer = null;
-
     if (_controller!.value.isStreamingImages) {
       await _controller!.stopImageStream();
     }
+    _guide?.destroy();
+    _guide = null;
     setState(() {
       _isRecording = false;
-      _isCapturingPicture = false;
+      // Keeps Start disabled until the stitch job has taken the session
+      _isProcessing = _capturedFrames > 0;
     });
 
-    if (_images.isEmpty) return;
+    if (_capturedFrames == 0) return;
 
     await _controller?.pausePreview();
 
@@ -135,7 +171,14 @@ class ScanBillScreenState extends State<ScanBillScreen> {
 
   // Reset function
   void _reset() {
-    _images = [];
+    _capturedFrames = 0;
+    _guide?.destroy();
+    _guide = null;
+    _job?.cancel();
+    if (!_isProcessing) {
+      _session?.destroy();
+      _session = null;
+    }
     // _stitchedImage = Uint8List(0);
     if (_controller!.value.isStreamingImages) {
       _controller!.stopImageStream();
@@ -144,45 +187,14 @@ class ScanBillScreenState extends State<ScanBillScreen> {
     setState(() {});
   }
 
-  Future<void> _processInIsolate(
-      List<String?> imagePaths, String outputPath) async {
-    final receivePort = ReceivePort();
-    await Isolate.spawn(
-      _isolateEntry,
-      [receivePort.sendPort, imagePaths, outputPath],
+  void _reportResult(StitchResult? result) {
+    if (!mounted) return;
+    ScaffoldMessenger.of(context).showSnackBar(
+      SnackBar(
+        content: Text(
+            result == null ? 'Error: Stitching failed' : 'Stitching complete'),
+      ),
     );
-
-    final result = await receivePort.first;
-    if (result is Exception) {
-      if (mounted) {
-        ScaffoldMessenger.of(context).showSnackBar(
-          SnackBar(
-            content: Text('Error: ${result.toString()}'),
-          ),
-        );
-      }
-    } else {
-      if (mounted) {
-        ScaffoldMessenger.of(context).showSnackBar(
-          const SnackBar(
-            content: Text('Stitching complete'),
-          ),
-        );
-      }
-    }
-  }
-
-  static void _isolateEntry(List<dynamic> args) {
-    final sendPort = args[0] as SendPort;
-    final imagePaths = args[1] as List<String?>;
-    final outputPath = args[2] as String;
-
-    try {
-      stitchImages(StitchImagesArguments(imagePaths, outputPath));
-      sendPort.send('Success');
-    } catch (e) {
-      sendPort.send(e);
-    }
   }
 
   void _processImage() async {
@@ -191,36 +203,54 @@ class ScanBillScreenState extends State<ScanBillScreen> {
     setState(() {
       _isLoading = true;
       _isProcessing = true;
+      _progress = 0;
     });
 
-    _images.sort((a, b) => a.name.compareTo(b.name));
-
-    final imagePaths = _images.map((e) => e.path).toList();
+    final session = _session;
 
-    if (imagePaths.isEmpty) {
+    if (_capturedFrames == 0 || session == null) {
       setState(() {
-        _isLoading = true;
-        _isProcessing = true;
+        _isLoading = false;
+        _isProcessing = false;
       });
       return;
     }
 
     final outputPath = '${tempDir.path}/stitched_image.jpg';
 
-    await _processInIsolate(imagePaths, outputPath);
-
-    if (mounted) {
-      Navigator.push(
-        context,
-        MaterialPageRoute(
-          builder: (_) => DisplayImage(imagePath: outputPath),
-        ),
-      );
+    // Runs on the persistent native worker pool, ahead of background jobs
+    final job = StitchJobs.instance.finalizeSession(
+      session,
+      onProgress: (stage, done, total) {
+        if (!mounted) return;
+        setState(() => _progress = StitchJob.fraction(stage, done, total));
+      },
+    );
+    _job = job;
+    final result = await job.result;
+    _job = null;
+    if (!job.cancelled) _reportResult(result);
+    // The job owned this session; a newer one may already be in _session
+    if (identical(_session, session)) _session = null;
+    session.destroy();
+
+    if (result != null) {
+      // Show the in-memory result right away, persist it in the background
+      result.persist(outputPath);
+      if (mounted) {
+        Navigator.push(
+          context,
+          MaterialPageRoute(
+            builder: (_) => DisplayImage(result: result),
+          ),
+        );
+      }
     }
 
+    if (!mounted) return;
     setState(() {
-      _isLoading = true;
-      _isProcessing = true;
+      _isLoading = false;
+      _isProcessing = false;
     });
   }
 
@@ -306,14 +336,18 @@ class ScanBillScreenState extends State<ScanBillScreen> {
               width: double.infinity,
               height: double.infinity,
               color: Colors.black54,
-              child: const Center(
-                child: CircularProgressIndicator(),
+              child: Center(
+                child: CircularProgressIndicator(
+                    value: _progress > 0 ? _progress : null),
               ),
             ),
         ],
       ),
       floatingActionButton: FloatingActionButton.extended(
-        onPressed: _isRecording ? _stopRecording : _startRecording,
+        // A new scan must not start while the last one is still stitching
+        onPressed: _isProcessing
+            ? null
+            : (_isRecording ? _stopRecording : _startRecording),
         label: Text(_isRecording ? 'Stop' : 'Start'),
         icon: Icon(_isRecording ? Icons.stop : Icons.camera),
       ),
@@ -11,6 +11,13 @@
 #include "opencv2/stitching/detail/warpers.hpp"
 #include "opencv2/stitching/warpers.hpp"
 #include "bill_stitching.hpp"
+#include "compositor.hpp"
+#include "feature_cache.hpp"
+#include "frame_registration.hpp"
+#include "guided_matcher.hpp"
+#include "keypoint_selection.hpp"
+#include "stage_pipeline.hpp"
+#include <type_traits>
 
 #ifdef __ANDROID__
 #include <android/log.h>
@@ -31,205 +38,254 @@ void stitching_log(const char *fmt, ...) {
     va_end(args);
 }
 
-// Hàm kiểm tra xem phép biến đổi có hợp lệ không
-bool isTransformValid(const Mat &H) {
-    double det = determinant(H);
-    if (det < 1e-6) {
-        stitching_log("Transformation matrix is degenerate (det = %f)\n", det);
-        return false;
+namespace {
+    struct BillFrame {
+        int index = 0;
+        Mat image;                   // preprocessed, at work scale
+        cv::bill_stitching::PhaseImage phase;
+        ImageFeatures features;      // only computed when phase correlation fails
+        bool hasFeatures = false;
+        Mat H;                       // transform into the previous image (index > 0)
+    };
+}
+
+// Tiền xử lý một ảnh bill: cân bằng trắng, giảm nhiễu, tăng tương phản
+Mat cv::bill_stitching::preprocessBill(const Mat &img) {
+    Mat preprocessed = img.clone();
+
+    //=== Cân bằng trắng ===
+    // Chuyển đổi sang ảnh xám
+    Mat gray;
+    cvtColor(preprocessed, gray, COLOR_BGR2GRAY);
+
+    // Tính toán histogram
+    Mat hist;
+    int histSize = 256;
+    float range[] = {0, 256};
+    const float *histRange = {range};
+    calcHist(&gray, 1, 0, Mat(), hist, 1, &histSize, &histRange, true, false);
+
+    // Tìm ngưỡng để phân đoạn nền và đối tượng
+    int totalPixels = gray.rows * gray.cols;
+    float sum = 0;
+    int thresholdValue = 0;
+    for (int i = 0; i < histSize; ++i) {
+        sum += hist.at<float>(i);
+        if (sum > 0.1 * totalPixels) {
+            thresholdValue = i;
+            break;
+        }
     }
-    return true;
+
+    // Tạo mặt nạ cho nền và đối tượng
+    Mat mask;
+    threshold(gray, mask, thresholdValue, 255, THRESH_BINARY);
+
+    // Tính toán giá trị trung bình cho nền và đối tượng
+    Scalar meanForeground, meanBackground;
+    meanStdDev(preprocessed, meanForeground, noArray(), mask);
+    meanStdDev(preprocessed, meanBackground, noArray(), ~mask);
+
+    // Cân bằng trắng bằng cách scale giá trị trung bình của đối tượng về giá trị trung bình của nền
+    Scalar scaleFactor = meanBackground / meanForeground;
+    preprocessed.convertTo(preprocessed, CV_32FC3);
+    multiply(preprocessed, scaleFactor, preprocessed);
+    preprocessed.convertTo(preprocessed, CV_8UC3);
+
+    //=== Giảm nhiễu ===
+    GaussianBlur(preprocessed, preprocessed, Size(5, 5), 0);
+
+    //=== Tăng cường độ tương phản ===
+    Ptr<CLAHE> clahe = createCLAHE();
+
+    clahe->setClipLimit(4.0);
+    Mat lab;
+    cvtColor(preprocessed, lab, COLOR_BGR2Lab);
+    vector<Mat> lab_planes(3);
+    split(lab, lab_planes);
+    clahe->apply(lab_planes[0], lab_planes[0]);
+    merge(lab_planes, lab);
+    cvtColor(lab, preprocessed, COLOR_Lab2BGR);
+
+    return preprocessed;
 }
 
-Mat cv::bill_stitching::stitchBills(const std::vector<cv::Mat> &images) {
-    double work_megapix = 0.5;   // Giảm xuống để tăng tốc độ
-    double seam_megapix = 0.5;
-    double compose_megapix = -1;
-//    string features_type = "orb"; // Sử dụng ORB cho tốc độ
-    string features_type = "sift";
-    string matcher_type = "affine";
-    string estimator_type = "affine";
-    string ba_cost_func = "affine";
-//    bool do_wave_correct = true;
-    string warp_type = "affine";  // Sử dụng affine warping cho bill hơi cong
-    float match_conf = 0.6;      // Tăng lên để lọc kết quả khớp tốt hơn
-    bool try_cuda = true;
-    double warped_image_scale = 1.0;
-    double seam_work_aspect = 1.0;
-    std::string seam_find_type = "dp_color";
-    std::string blend_type = "no";
+// Tìm features của một ảnh, loại bỏ các điểm đặc trưng trùng lặp và rải đều chúng
+// finder: SelectiveFeatures (loại điểm trùng lặp + ANMS) sau feature cache
+static void findBillFeatures(const Ptr<Feature2D> &finder, const Mat &image, int index,
+                             ImageFeatures &features) {
+    vector<KeyPoint> keypoints;
+    Mat descriptors;
+    // Detect keypoints and compute descriptors for the current image
+    finder->detectAndCompute(image, noArray(), keypoints, descriptors);
+    features.img_idx = index;
+    // GuidedMatcher dựa vào kích thước ảnh để tính bán kính tìm kiếm và lưới keypoint
+    features.img_size = image.size();
+    features.keypoints = keypoints;
+    descriptors.copyTo(features.descriptors);
+}
 
-    int num_images = static_cast<int>(images.size());
-    if (num_images < 2) {
-        stitching_log("Need more images\n");
-        return Mat();
-    }
+namespace {
+    using cv::bill_stitching::StitchConfig;
+
+    //=== Các policy của pipeline ghép chuỗi ===
+    // Mỗi policy được tạo một lần cho cả chuỗi ảnh; mỗi cặp ảnh chỉ còn công việc
+    // ghép và ước lượng thực sự. Tổ hợp policy được chọn lúc biên dịch nên các nhánh
+    // không dùng tới (matcher/estimator khác, ghép bằng features với engine chỉ tịnh
+    // tiến) không có trong binary.
+
+    // Detector: tìm features đã rải đều cho một frame
+    class SelectiveDetector {
+    public:
+        static const bool kFindsFeatures = true;
+
+        explicit SelectiveDetector(const StitchConfig &config) {
+            cv::bill_stitching::KeypointSelection selection;
+            selection.dedupRadius = 10.0f;   // Adjust this value as needed
+            selection.targetCount = config.maxFeatures;   // SIFT trả về hàng chục nghìn điểm trên ảnh nhiều chữ
+            finder_ = makePtr<cv::bill_stitching::CachedFeatures>(
+                    makePtr<cv::bill_stitching::SelectiveFeatures>(cv::bill_stitching::createDetector(config),
+                                                                   selection),
+                    cv::bill_stitching::featureSignature(config, selection));
+        }
 
-    //=== Tiền xử lý ===
-    vector<Mat> preprocessed_images;
-    for (const auto &img: images) {
-        Mat preprocessed = img.clone();
-
-        //=== Cân bằng trắng ===
-        // Chuyển đổi sang ảnh xám
-        Mat gray;
-        cvtColor(preprocessed, gray, COLOR_BGR2GRAY);
-
-        // Tính toán histogram
-        Mat hist;
-        int histSize = 256;
-        float range[] = {0, 256};
-        const float *histRange = {range};
-        calcHist(&gray, 1, 0, Mat(), hist, 1, &histSize, &histRange, true, false);
-
-        // Tìm ngưỡng để phân đoạn nền và đối tượng
-        int totalPixels = gray.rows * gray.cols;
-        float sum = 0;
-        int thresholdValue = 0;
-        for (int i = 0; i < histSize; ++i) {
-            sum += hist.at<float>(i);
-            if (sum > 0.1 * totalPixels) {
-                thresholdValue = i;
-                break;
-            }
+        void find(const Mat &image, int index, ImageFeatures &features) const {
+            findBillFeatures(finder_, image, index, features);
         }
 
-        // Tạo mặt nạ cho nền và đối tượng
-        Mat mask;
-        threshold(gray, mask, thresholdValue, 255, THRESH_BINARY);
-
-        // Tính toán giá trị trung bình cho nền và đối tượng
-        Scalar meanForeground, meanBackground;
-        meanStdDev(preprocessed, meanForeground, noArray(), mask);
-        meanStdDev(preprocessed, meanBackground, noArray(), ~mask);
-
-        // Cân bằng trắng bằng cách scale giá trị trung bình của đối tượng về giá trị trung bình của nền
-        Scalar scaleFactor = meanBackground / meanForeground;
-        preprocessed.convertTo(preprocessed, CV_32FC3);
-        multiply(preprocessed, scaleFactor, preprocessed);
-        preprocessed.convertTo(preprocessed, CV_8UC3);
-
-        //=== Giảm nhiễu ===
-        GaussianBlur(preprocessed, preprocessed, Size(5, 5), 0);
-
-        //=== Tăng cường độ tương phản ===
-        Ptr<CLAHE> clahe = createCLAHE();
-
-        clahe->setClipLimit(4.0);
-        Mat lab;
-        cvtColor(preprocessed, lab, COLOR_BGR2Lab);
-        vector<Mat> lab_planes(3);
-        split(lab, lab_planes);
-        clahe->apply(lab_planes[0], lab_planes[0]);
-        merge(lab_planes, lab);
-        cvtColor(lab, preprocessed, COLOR_Lab2BGR);
-
-        preprocessed_images.push_back(preprocessed);
-    }
+    private:
+        Ptr<Feature2D> finder_;
+    };
 
-    vector<Mat> resized_images;
-    double scale = 1.0;
-    if (work_megapix > 0) {
-        scale = min(1.0, sqrt(work_megapix * 1e6 / preprocessed_images[0].total()));
-    }
-    for (const auto &img: preprocessed_images) {
-        Mat resized;
-        if (scale < 1.0) {
-            resize(img, resized, Size(), scale, scale);
-        } else {
-            resized = img.clone();
+    // Không tìm features: cặp ảnh nào phase correlation không đăng ký được thì chuỗi thất bại
+    struct NoDetector {
+        static const bool kFindsFeatures = false;
+
+        explicit NoDetector(const StitchConfig &) {}
+    };
+
+    struct NoMatcher {
+    };
+
+    struct NoEstimator {
+    };
+
+    // Matcher: cv::detail matcher, tạo một lần với ngưỡng của config
+    template<typename Matcher>
+    struct MatcherFactory;
+
+    template<>
+    struct MatcherFactory<AffineBestOf2NearestMatcher> {
+        static Ptr<AffineBestOf2NearestMatcher> create(const StitchConfig &config) {
+            return makePtr<AffineBestOf2NearestMatcher>(false, true, static_cast<float>(config.matchConfidence));
+        }
+    };
+
+    // Ghép có hướng dẫn theo chuyển động của cặp trước, ghép toàn bộ khi chưa có prior
+    template<>
+    struct MatcherFactory<cv::bill_stitching::GuidedMatcher> {
+        static Ptr<cv::bill_stitching::GuidedMatcher> create(const StitchConfig &config) {
+            return makePtr<cv::bill_stitching::GuidedMatcher>(MatcherFactory<AffineBestOf2NearestMatcher>::create(config),
+                                                              config.matchConfidence, config.panoConfidenceThresh);
+        }
+    };
+
+    template<>
+    struct MatcherFactory<NoMatcher> {
+        static Ptr<NoMatcher> create(const StitchConfig &) {
+            return Ptr<NoMatcher>();
         }
-        stitching_log("Resized image size: width=%d, height=%d\n", resized.cols, resized.rows);
-        resized_images.push_back(resized);
+    };
+
+    // Thời điểm chụp và chuyển động đã biết cho matcher có hướng dẫn, bỏ qua với matcher khác
+    template<typename Matcher>
+    void setTimestamps(Matcher *, const vector<int64> &) {}
+
+    void setTimestamps(cv::bill_stitching::GuidedMatcher *matcher, const vector<int64> &timestampsUs) {
+        matcher->setTimestamps(timestampsUs);
     }
 
-    //=== 1. Tìm features & Tạo matcher ===
-    stitching_log("Finding features...\n");
-    Ptr<Feature2D> finder;
-    if (features_type == "orb") {
-        finder = ORB::create(7000); // Giảm số lượng features tối đa
-    } else if (features_type == "akaze") {
-        finder = AKAZE::create();
-    } else if (features_type == "sift") {
-        finder = SIFT::create();
-    } else if (features_type == "brisk") {
-        finder = BRISK::create();
-    } else {
-        stitching_log("Unknown 2D features type: '%s'\n", features_type.c_str());
-        return Mat();
+    template<typename Matcher>
+    void recordMotion(Matcher *, int, int, const Mat &) {}
+
+    void recordMotion(cv::bill_stitching::GuidedMatcher *matcher, int from, int to, const Mat &fromTo) {
+        matcher->recordMotion(from, to, fromTo);
     }
 
-    vector<ImageFeatures> features(num_images);
-    for (int i = 0; i < num_images; ++i) {
-        vector<KeyPoint> keypoints;
-        Mat descriptors;
-        // Detect keypoints and compute descriptors for the current image
-        finder->detectAndCompute(resized_images[i], noArray(), keypoints, descriptors);
-
-        // Loại bỏ điểm đặc trưng trùng lặp (radius match)
-        float radius = 10.0f; // Adjust this value as needed
-        vector<KeyPoint> filteredKeypoints;
-        for (size_t j = 0; j < keypoints.size(); ++j) {
-            bool keep = true;
-            for (size_t k = 0; k < filteredKeypoints.size(); ++k) {
-                if (norm(keypoints[j].pt - filteredKeypoints[k].pt) < radius) {
-                    keep = false;
-                    break;
-                }
-            }
-            if (keep) {
-                filteredKeypoints.push_back(keypoints[j]);
-            }
+    // Đăng ký từng cặp ảnh liên tiếp rồi ghép cả chuỗi vào canvas.
+    // Detector: SelectiveDetector / NoDetector. Matcher, Estimator: cv::detail types (or
+    // NoMatcher / NoEstimator with NoDetector). Blender: reset(size), feed(image,
+    // toCanvas), canvas().covered(), e.g. Compositor.
+    template<typename Detector, typename Matcher, typename Estimator, typename Blender>
+    class BillPipeline {
+    public:
+        // `timestampsUs` (optional, by image index) scales the motion prior of guided matching.
+        BillPipeline(const StitchConfig &config, const vector<int64> &timestampsUs)
+                : detector_(config), matcher_(MatcherFactory<Matcher>::create(config)),
+                  workMegapix_(config.registrationMegapix), pairFeatures_(2) {
+            setTimestamps(matcher_.get(), timestampsUs);
         }
-        keypoints = filteredKeypoints;
-        features[i].img_idx = i;
-        features[i].keypoints = keypoints;
-        descriptors.clone().copyTo(features[i].descriptors);
-    }
-    stitching_log("Features found\n");
-
-    //=== 2. Ghép nối từng cặp ảnh theo thứ tự đầu vào ===
-    stitching_log("Matching features...\n");
-
-    Mat result = resized_images[0].clone(); // Ảnh đầu tiên là ảnh khởi tạo
-    for (int i = 1; i < num_images; ++i) {
-        stitching_log("Stitching image %d to the panorama...\n", i);
-
-        // Tìm feature matching giữa ảnh hiện tại và kết quả ghép nối tạm thời
-        vector<MatchesInfo> pairwise_matches;
-        Ptr<FeaturesMatcher> matcher;
-        if (matcher_type == "affine")
-            matcher = makePtr<AffineBestOf2NearestMatcher>(false, try_cuda, match_conf);
-        else if (matcher_type == "homography")
-            matcher = makePtr<BestOf2NearestMatcher>(false, match_conf, try_cuda);
-        else {
-            stitching_log("Unknown matcher type: '%s'\n", matcher_type.c_str());
-            return Mat();
+
+        // Ghép chuỗi ảnh vào `blender`; false nếu không đăng ký được chuỗi ảnh.
+        // `source` (optional) supplies the frames to composite at a higher resolution.
+        // `registration` (optional) receives the layout in composited px, with the
+        // covered area as crop; see outputScale().
+        bool run(const vector<Mat> &images, const cv::bill_stitching::ComposeSource *source,
+                 cv::bill_stitching::Registration *registration, Blender &blender);
+
+        // Composited px per px of the input images, known after run().
+        double outputScale() const { return outputScale_; }
+
+    private:
+        typedef std::integral_constant<bool, Detector::kFindsFeatures> FindsFeatures;
+
+        void ensureFeatures(BillFrame &frame) {
+            if (!frame.hasFeatures) {
+                detector_.find(frame.image, frame.index, frame.features);
+                frame.hasFeatures = true;
+            }
         }
-        vector<ImageFeatures> twoFeatures;
-        twoFeatures.push_back(features[i - 1]); // Ảnh trước đó (đã được ghép nối)
-        twoFeatures.push_back(features[i]);     // Ảnh hiện tại
-        (*matcher)(twoFeatures, pairwise_matches);
-        matcher->collectGarbage();
 
-        // Estimate camera parameters
-        vector<CameraParams> cameras;
-        Ptr<Estimator> estimator;
-        if (estimator_type == "homography") {
-            estimator = makePtr<HomographyBasedEstimator>();
-        } else if (estimator_type == "affine") {
-            estimator = makePtr<AffineBasedEstimator>();
-        } else {
-            stitching_log("Unknown estimator type: '%s'\n", estimator_type.c_str());
-            return Mat();
+        bool registerByFeatures(BillFrame &, BillFrame &frame, std::false_type) {
+            stitching_log("Translation registration failed for image %d\n", frame.index);
+            return false;
         }
 
-        if (!(*estimator)(twoFeatures, pairwise_matches, cameras)) {
+        bool registerByFeatures(BillFrame &prev, BillFrame &frame, std::true_type);
+
+        Detector detector_;
+        Ptr<Matcher> matcher_;
+        Estimator estimator_;
+        double workMegapix_;
+        double outputScale_ = 1;
+        // Dùng lại giữa các cặp ảnh thay vì cấp phát lại cho mỗi cặp
+        vector<ImageFeatures> pairFeatures_;
+        vector<MatchesInfo> pairMatches_;
+        vector<CameraParams> cameras_;
+    };
+
+    template<typename Detector, typename Matcher, typename Estimator, typename Blender>
+    bool BillPipeline<Detector, Matcher, Estimator, Blender>::registerByFeatures(BillFrame &prev, BillFrame &frame,
+                                                                               std::true_type) {
+        ensureFeatures(prev);
+        ensureFeatures(frame);
+
+        // Tìm feature matching giữa ảnh hiện tại và ảnh trước đó. Features được chuyển
+        // tạm vào cặp (không sao chép) rồi trả lại sau khi ước lượng.
+        std::swap(pairFeatures_[0], prev.features);    // Ảnh trước đó (đã được ghép nối)
+        std::swap(pairFeatures_[1], frame.features);   // Ảnh hiện tại
+        (*matcher_)(pairFeatures_, pairMatches_);
+
+        // Estimate camera parameters
+        const bool ok = estimator_(pairFeatures_, pairMatches_, cameras_);
+        std::swap(pairFeatures_[0], prev.features);
+        std::swap(pairFeatures_[1], frame.features);
+        if (!ok) {
             stitching_log("Camera parameters estimation failed.\n");
-            return Mat();
+            return false;
         }
-        for (size_t j = 0; j < cameras.size(); ++j) {
-            Mat R = cameras[j].R;
+        for (size_t j = 0; j < cameras_.size(); ++j) {
+            Mat R = cameras_[j].R;
 
             // Kiểm tra xem có phép biến đổi lật ảnh không
             if (R.at<double>(0, 0) * R.at<double>(1, 1) -
@@ -238,104 +294,201 @@ Mat cv::bill_stitching::stitchBills(const std::vector<cv::Mat> &images) {
                 R.at<double>(0, 1) *= -1;
                 R.at<double>(1, 1) *= -1;
                 R.at<double>(2, 1) *= -1;
+            }
+        }
+        frame.H = cameras_[1].R.clone();
+        return true;
+    }
+
+    template<typename Detector, typename Matcher, typename Estimator, typename Blender>
+    bool BillPipeline<Detector, Matcher, Estimator, Blender>::run(const vector<Mat> &images,
+                                                                  const cv::bill_stitching::ComposeSource *source,
+                                                                  cv::bill_stitching::Registration *registration,
+                                                                  Blender &blender) {
+        const int num_images = static_cast<int>(images.size());
+        double scale = 1.0;
+        if (workMegapix_ > 0) {
+            scale = min(1.0, sqrt(workMegapix_ * 1e6 / images[0].total()));
+        }
 
-                // Cập nhật lại ma trận R trong cameras
-                cameras[j].R = R;
+        //=== 1. Tiền xử lý, chuẩn bị và ghép cặp (k-1, k) chạy chồng lên nhau ===
+        // Ảnh k+1 được tiền xử lý trong khi ảnh k đang được chuẩn bị và cặp (k-1, k)
+        // đang được ghép, thay vì chạy hết từng bước cho mọi ảnh rồi mới sang bước sau.
+        stitching_log("Registering images...\n");
+        vector<BillFrame> frames(num_images);
+        bool estimation_failed = false;
+
+        cv::bill_stitching::StagePipeline<BillFrame> pipeline;
+        pipeline.addStage("preprocess", [&](BillFrame &frame) {
+            Mat preprocessed = cv::bill_stitching::preprocessBill(images[frame.index]);
+            if (scale < 1.0) {
+                resize(preprocessed, frame.image, Size(), scale, scale);
+            } else {
+                frame.image = preprocessed;
+            }
+            stitching_log("Resized image size: width=%d, height=%d\n", frame.image.cols, frame.image.rows);
+            return true;
+        });
+        pipeline.addStage("prepare", [&](BillFrame &frame) {
+            Mat gray;
+            cvtColor(frame.image, gray, COLOR_BGR2GRAY);
+            frame.phase = cv::bill_stitching::preparePhaseImage(gray);
+            return true;
+        });
+        pipeline.addStage("match", [&](BillFrame &frame) {
+            if (frame.index > 0 && !estimation_failed) {
+                BillFrame &prev = frames[frame.index - 1];
+                stitching_log("Matching image %d with image %d...\n", frame.index, frame.index - 1);
+
+                // Bill được quét thẳng từ trên xuống: thử phép tịnh tiến bằng phase correlation
+                // trước, chỉ tìm và ghép features khi kết quả không đủ tin cậy
+                cv::bill_stitching::PairRegistration reg =
+                        cv::bill_stitching::registerTranslation(prev.phase, frame.phase);
+                if (reg.ok) {
+                    frame.H = reg.H;
+                    // Cặp sau có thể cần features: chuyển động này là prior của nó
+                    recordMotion(matcher_.get(), frame.index, prev.index, reg.H);
+                } else if (!registerByFeatures(prev, frame, FindsFeatures())) {
+                    estimation_failed = true;
+                }
+                // Ảnh trước đó không còn được dùng để ghép cặp
+                prev.phase = cv::bill_stitching::PhaseImage();
+                prev.features = ImageFeatures();
+            }
+            frames[frame.index] = std::move(frame);
+            return true;
+        });
+        pipeline.start();
+        for (int i = 0; i < num_images; ++i) {
+            BillFrame frame;
+            frame.index = i;
+            pipeline.push(std::move(frame));
+        }
+        pipeline.waitIdle();
+        pipeline.stop();
+        cv::bill_stitching::logStageStats("stitchBills", pipeline.stats());
+
+        // Một stage lỗi sẽ bỏ frame đó, khi đó không thể ghép tiếp chuỗi ảnh
+        for (int i = 0; i < num_images && !estimation_failed; ++i) {
+            estimation_failed = frames[i].image.empty() || (i > 0 && frames[i].H.empty());
+        }
+        if (estimation_failed) {
+            return false;
+        }
+        stitching_log("Features found\n");
+
+        //=== 2. Bố cục toàn cục: nối mọi phép biến đổi cặp về toạ độ canvas ===
+        // Tính bounding box một lần và cấp phát canvas một lần, sau đó mỗi ảnh chỉ được warp
+        // vào vùng (ROI) của nó, nên tổng công việc tuyến tính theo số ảnh.
+        // Khi ghép từ ảnh nguồn, phép biến đổi được đổi sang toạ độ của ảnh nguồn:
+        // H' = S * H * S^-1 với S = diag(k, k, 1), k = px nguồn trên mỗi px làm việc
+        const double k = source != nullptr ? source->scale / scale : 1.0;
+        outputScale_ = source != nullptr ? source->scale : scale;
+        const Mat S = (Mat_<double>(3, 3) << k, 0, 0, 0, k, 0, 0, 0, 1);
+        const Mat Sinv = (Mat_<double>(3, 3) << 1 / k, 0, 0, 0, 1 / k, 0, 0, 0, 1);
+        vector<Size> sizes(num_images);
+        vector<Mat> toPrev(num_images);
+        for (int i = 0; i < num_images; ++i) {
+            sizes[i] = source != nullptr ? Size(cvRound(images[i].cols * source->scale),
+                                                cvRound(images[i].rows * source->scale))
+                                         : frames[i].image.size();
+            if (i > 0) {
+                // Ma trận affine 3x3 đưa ảnh hiện tại về ảnh trước đó
+                frames[i].H.convertTo(toPrev[i], CV_64F);
+                toPrev[i].at<double>(2, 0) = 0;
+                toPrev[i].at<double>(2, 1) = 0;
+                toPrev[i].at<double>(2, 2) = 1;
+                if (source != nullptr) {
+                    toPrev[i] = S * toPrev[i] * Sinv;
+                }
             }
         }
+        cv::bill_stitching::FrameLayout layout = cv::bill_stitching::computeLayout(sizes, toPrev);
+        stitching_log("Output image size: width=%d, height=%d\n", layout.canvasSize.width,
+                      layout.canvasSize.height);
 
-        //=== 3. Warp ảnh hiện tại và ghép nối vào result ===
-// Chuyển đổi ma trận H từ 2x3 thành 3x3
-        Mat H = cameras[1].R;
-        H.convertTo(H, CV_32F); // Chuyển đổi kiểu dữ liệu của H sang float
-        H = Mat::eye(3, 3, CV_32F) * H;
-        H.at<float>(2, 2) = 1.0f;
-
-// Tính toán kích thước ảnh result sau khi warp
-        stitching_log("Calculating output image size...\n");
-        vector<Point2f> corners(4);
-        corners[0] = Point2f(0, 0);
-        corners[1] = Point2f(result.cols, 0);
-        corners[2] = Point2f(result.cols, result.rows);
-        corners[3] = Point2f(0, result.rows);
-        Mat cornersMat = Mat(corners).reshape(1).t();
-        cornersMat.convertTo(cornersMat, CV_32FC2);
-
-// Thực hiện perspectiveTransform
-        perspectiveTransform(cornersMat, cornersMat, H);
-        cornersMat = cornersMat.reshape(2, cornersMat.cols).t();
-        corners = vector<Point2f>(cornersMat.ptr<Point2f>(0),
-                                  cornersMat.ptr<Point2f>(0) + cornersMat.cols);
-
-        int minX = min(0, min(cvRound(corners[0].x), cvRound(corners[3].x)));
-        int minY = min(0, min(cvRound(corners[0].y), cvRound(corners[1].y)));
-        int maxX = max(cvRound(corners[1].x), max(cvRound(corners[2].x), result.cols));
-        int maxY = max(cvRound(corners[2].y), max(cvRound(corners[3].y), result.rows));
-        Size outputSize(maxX - minX, maxY - minY);
-        stitching_log("Output image size: width=%d, height=%d\n", outputSize.width,
-                      outputSize.height);
-
-        // Tạo ma trận dịch chuyển để đưa ảnh về đúng vị trí
-        Mat translation = Mat::eye(3, 3, CV_32F);
-        translation.at<float>(0, 2) = -minX;
-        translation.at<float>(1, 2) = -minY;
-
-        // Cập nhật ma trận homography
-        H = translation * H;
-
-        // Warp ảnh hiện tại
-        Mat warpedImage;
-        warpPerspective(resized_images[i], warpedImage, H, outputSize, INTER_LINEAR,
-                        BORDER_CONSTANT);
-
-        // Ghép nối ảnh đã warp vào result
+        //=== 3. Warp từng ảnh và ghép nối vào canvas ===
         stitching_log("Blending images...\n");
-        Mat finalImage(outputSize, CV_8UC3);
-        for (int y = 0; y < outputSize.height; y++) {
-            for (int x = 0; x < outputSize.width; x++) {
-                // Kiểm tra xem điểm ảnh có nằm trong vùng chồng lấp không
-                if (x - minX >= 0 && x - minX < result.cols && y - minY >= 0 &&
-                    y - minY < result.rows &&
-                    warpedImage.at<Vec3b>(y, x) != Vec3b(0, 0, 0)) {
-                    // Điểm ảnh nằm trong vùng chồng lấp, thực hiện blending
-                    finalImage.at<Vec3b>(y, x) =
-                            0.5 * result.at<Vec3b>(y - minY, x - minX) +
-                            0.5 * warpedImage.at<Vec3b>(y, x);
-                } else if (warpedImage.at<Vec3b>(y, x) != Vec3b(0, 0, 0)) {
-                    // Điểm ảnh chỉ nằm trong ảnh warped
-                    finalImage.at<Vec3b>(y, x) = warpedImage.at<Vec3b>(y, x);
-                } else if (x - minX >= 0 && x - minX < result.cols && y - minY >= 0 &&
-                           y - minY < result.rows) {
-                    // Điểm ảnh chỉ nằm trong ảnh result
-                    finalImage.at<Vec3b>(y, x) = result.at<Vec3b>(y - minY, x - minX);
-                } else {
-                    // Điểm ảnh không thuộc vùng nào, đặt là màu đen
-                    finalImage.at<Vec3b>(y, x) = Vec3b(0, 0, 0);
+        blender.reset(layout.canvasSize);
+        for (int i = 0; i < num_images; ++i) {
+            if (source != nullptr) {
+                // Ảnh nguồn chỉ được đọc khi tới lượt và giải phóng ngay sau khi ghép
+                frames[i].image.release();
+                Mat full = source->load(i);
+                if (full.empty()) {
+                    stitching_log("Source %d could not be reloaded\n", i);
+                    return false;
                 }
+                blender.feed(cv::bill_stitching::preprocessBill(full), layout.toCanvas[i]);
+            } else {
+                blender.feed(frames[i].image, layout.toCanvas[i]);
+                frames[i].image.release();
             }
         }
         stitching_log("Blending done\n");
-
-        // Cập nhật result
-        result = finalImage.clone();
+        if (registration != nullptr) {
+            registration->canvasSize = layout.canvasSize;
+            registration->toCanvas = layout.toCanvas;
+            registration->crop = blender.canvas().covered();
+        }
+        return true;
     }
+}
 
+bool cv::bill_stitching::stitchBills(const std::vector<cv::Mat> &images, Composite &result,
+                                     const StitchConfig &config, const ComposeSource *source,
+                                     Registration *registration, const std::vector<int64> &timestampsUs) {
+    int num_images = static_cast<int>(images.size());
+    if (num_images < 2) {
+        stitching_log("Need more images\n");
+        return false;
+    }
 
-    stitching_log("Features matched\n");
-
+    // Chọn tổ hợp policy một lần theo engine, mọi cặp ảnh dùng chung các đối tượng này
+    bool ok;
+    double outputScale = 1;
+    if (config.engine == ENGINE_TRANSLATION) {
+        BillPipeline<NoDetector, NoMatcher, NoEstimator, Compositor> pipeline(config, timestampsUs);
+        ok = pipeline.run(images, source, registration, result.compositor);
+        outputScale = pipeline.outputScale();
+    } else {
+        BillPipeline<SelectiveDetector, GuidedMatcher, AffineBasedEstimator, Compositor> pipeline(config,
+                                                                                                   timestampsUs);
+        ok = pipeline.run(images, source, registration, result.compositor);
+        outputScale = pipeline.outputScale();
+    }
+    if (!ok) {
+        return false;
+    }
 
+    // Vùng đã phủ của canvas, đọc ra một lần để tìm và làm phẳng bill
+    Mat stitched = result.compositor.result();
+    if (stitched.empty()) {
+        return false;
+    }
+    // Vùng cắt của registration: bill rect trong vùng đã phủ, theo toạ độ canvas. Bước làm
+    // phẳng bên dưới gần như là phép đồng nhất nên không được lưu lại.
+    auto finishRegistration = [&](const Rect &billRect) {
+        if (registration != nullptr) {
+            registration->crop = Rect(registration->crop.tl() + billRect.tl(), billRect.size());
+            scaleRegistration(*registration, 1 / outputScale);
+        }
+    };
 
     //=== 5. Cắt ảnh theo bill ===
     stitching_log("Finding bill contour...\n");
     Mat grayResult;
-    cvtColor(result, grayResult, COLOR_BGR2GRAY);
+    cvtColor(stitched, grayResult, COLOR_BGR2GRAY);
     threshold(grayResult, grayResult, 1, 255, THRESH_BINARY);
     vector<vector<Point>> contours;
     findContours(grayResult, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
 
     if (contours.empty()) {
         stitching_log("No contours found. Skipping bill cropping.\n");
-        return result;
+        finishRegistration(Rect(Point(), stitched.size()));
+        result.image = stitched;
+        result.compositor.reset(Size());
+        return true;
     }
 
     // Chọn contour lớn nhất (giả sử bill là đối tượng lớn nhất)
@@ -354,9 +507,10 @@ Mat cv::bill_stitching::stitchBills(const std::vector<cv::Mat> &images) {
     // Tìm bounding rect của contour lớn nhất
     Rect billRect = boundingRect(contours[largestContourIndex]);
     stitching_log("Bounding rect found\n");
+    finishRegistration(billRect);
 
     // Cắt ảnh theo bounding rect
-    result = result(billRect);
+    stitched = stitched(billRect);
 
     // === 6. Làm phẳng bill (sử dụng perspective transform) ===
     stitching_log("Flattening bill...\n");
@@ -392,11 +546,14 @@ Mat cv::bill_stitching::stitchBills(const std::vector<cv::Mat> &images) {
     stitching_log("Perspective transform computed\n");
 
     // Áp dụng perspective transform để làm phẳng bill
-    warpPerspective(result, result, perspectiveTransform1, outputSize1);
+    warpPerspective(stitched, stitched, perspectiveTransform1, outputSize1);
 
     stitching_log("Bill flattened\n");
 
     stitching_log("Stitching completed\n");
 
-    return result;
-}
\ No newline at end of file
+    result.image = stitched;
+    // Ảnh đã làm phẳng thay cho canvas, nhả các tile ngay
+    result.compositor.reset(Size());
+    return !result.empty();
+}
@@ -3,10 +3,29 @@
 
 #include "opencv2/core/core.hpp"
 #include "opencv2/imgproc/imgproc.hpp"
+#include "compositor.hpp"
+#include "registration_store.hpp"
+#include "source_compose.hpp"
+#include "stitch_config.hpp"
+
+void stitching_log(const char *fmt, ...);
 
 namespace cv {
     namespace bill_stitching {
-        cv::Mat stitchBills(const std::vector<cv::Mat>& images);
+        // Ghép bill theo ENGINE_BILL_CHAIN hoặc ENGINE_TRANSLATION; `config` phải hợp lệ. Có
+        // `source` thì các frame được đăng ký trên `images` nhưng ghép từ ảnh nguồn đọc lại.
+        // `registration` (tuỳ chọn) nhận các phép biến đổi và vùng cắt bill theo pixel của
+        // `images`; đường dẫn và gain do bên gọi điền. `timestampsUs` (tuỳ chọn) là thời điểm
+        // chụp từng ảnh, làm dự đoán chuyển động khi ghép cặp features. Bill đã cắt và làm
+        // phẳng nằm trong `result`.
+        bool stitchBills(const std::vector<cv::Mat>& images, Composite &result,
+                         const StitchConfig &config = defaultStitchConfig(), const ComposeSource *source = nullptr,
+                         Registration *registration = nullptr,
+                         const std::vector<int64> &timestampsUs = std::vector<int64>());
+
+        // Tiền xử lý một ảnh bill trước khi ghép theo chuỗi (cũng dùng khi dựng lại từ
+        // Registration của engine chuỗi).
+        cv::Mat preprocessBill(const cv::Mat &img);
     }
 }
 
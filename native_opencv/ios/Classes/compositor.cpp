@@ -0,0 +1,199 @@
+#include "opencv2/opencv.hpp"
+#include "opencv2/core/hal/intrin.hpp"
+#include "bill_stitching.hpp"
+#include "compositor.hpp"
+
+using namespace std;
+using namespace cv;
+
+namespace {
+    void logSpills(const cv::bill_stitching::TiledCanvas &canvas) {
+        if (canvas.spilledTiles() > 0) {
+            stitching_log("Compositor: %d tile spills, %lu KB resident\n", canvas.spilledTiles(),
+                          canvas.residentBytes() >> 10);
+        }
+    }
+
+    inline uchar blendScalar(uchar s, uchar d, int a) {
+        int t = s * a + d * (255 - a) + 128;
+        return static_cast<uchar>((t + (t >> 8)) >> 8);
+    }
+
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+    // 255 * wn / (wn + wo), phép chia duy nhất làm trên float
+    inline v_uint16 alpha16(const v_uint16 &wn, const v_uint16 &wo) {
+        const v_float32 v255 = vx_setall_f32(255.f), vOne = vx_setall_f32(1.f);
+        v_uint32 wn0, wn1, wo0, wo1;
+        v_expand(wn, wn0, wn1);
+        v_expand(wo, wo0, wo1);
+        v_float32 fn0 = v_cvt_f32(v_reinterpret_as_s32(wn0)), fn1 = v_cvt_f32(v_reinterpret_as_s32(wn1));
+        v_float32 fo0 = v_cvt_f32(v_reinterpret_as_s32(wo0)), fo1 = v_cvt_f32(v_reinterpret_as_s32(wo1));
+        v_int32 a0 = v_round(v_div(v_mul(fn0, v255), v_max(v_add(fn0, fo0), vOne)));
+        v_int32 a1 = v_round(v_div(v_mul(fn1, v255), v_max(v_add(fn1, fo1), vOne)));
+        return v_pack_u(a0, a1);
+    }
+
+    // (s * a + d * (255 - a)) / 255 trên 16 bit, chia 255 bằng (t + (t >> 8)) >> 8
+    inline v_uint8 mix(const v_uint8 &s, const v_uint8 &d, const v_uint8 &a) {
+        const v_uint16 v128 = vx_setall_u16(128);
+        v_uint16 s0, s1, d0, d1;
+        v_mul_expand(s, a, s0, s1);
+        v_mul_expand(d, v_sub(vx_setall_u8(255), a), d0, d1);
+        v_uint16 t0 = v_add(v_add(s0, d0), v128), t1 = v_add(v_add(s1, d1), v128);
+        t0 = v_shr<8>(v_add(t0, v_shr<8>(t0)));
+        t1 = v_shr<8>(v_add(t1, v_shr<8>(t1)));
+        return v_pack(t0, t1);
+    }
+#endif
+}
+
+void cv::bill_stitching::blendRow(const uchar *src, const uchar *srcW, uchar *dst, uchar *dstW, int width) {
+    int x = 0;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+    const int step = VTraits<v_uint8>::vlanes();
+    for (; x <= width - step; x += step) {
+        v_uint8 wn = vx_load(srcW + x), wo = vx_load(dstW + x);
+        v_uint16 wn0, wn1, wo0, wo1;
+        v_expand(wn, wn0, wn1);
+        v_expand(wo, wo0, wo1);
+        v_uint8 alpha = v_pack(alpha16(wn0, wo0), alpha16(wn1, wo1));
+
+        v_uint8 sb, sg, sr, db, dg, dr;
+        v_load_deinterleave(src + 3 * x, sb, sg, sr);
+        v_load_deinterleave(dst + 3 * x, db, dg, dr);
+        v_store_interleave(dst + 3 * x, mix(sb, db, alpha), mix(sg, dg, alpha), mix(sr, dr, alpha));
+        v_store(dstW + x, v_max(wn, wo));
+    }
+    vx_cleanup();
+#endif
+    for (; x < width; ++x) {
+        const int wn = srcW[x], wo = dstW[x];
+        const int a = cvRound(255.f * wn / std::max(wn + wo, 1));
+        for (int c = 0; c < 3; ++c) {
+            dst[3 * x + c] = blendScalar(src[3 * x + c], dst[3 * x + c], a);
+        }
+        dstW[x] = static_cast<uchar>(std::max(wn, wo));
+    }
+}
+
+cv::bill_stitching::FrameLayout
+cv::bill_stitching::computeLayout(const vector<Size> &sizes, const vector<Mat> &toPrev) {
+    CV_Assert(sizes.size() == toPrev.size() && !sizes.empty());
+    FrameLayout layout;
+    layout.toCanvas.resize(sizes.size());
+
+    // Nối các phép biến đổi cặp thành phép biến đổi toàn cục về hệ toạ độ frame đầu tiên
+    layout.toCanvas[0] = Mat::eye(3, 3, CV_64F);
+    Rect bounds(Point(0, 0), sizes[0]);
+    for (size_t i = 1; i < sizes.size(); ++i) {
+        Mat H;
+        toPrev[i].convertTo(H, CV_64F);
+        layout.toCanvas[i] = layout.toCanvas[i - 1] * H;
+        bounds |= Compositor::warpedBounds(sizes[i], layout.toCanvas[i]);
+    }
+
+    // Dời gốc toạ độ về góc trên trái của bounding box
+    for (auto &H: layout.toCanvas) {
+        H = (Mat_<double>(3, 3) << 1, 0, -bounds.x, 0, 1, -bounds.y, 0, 0, 1) * H;
+    }
+    layout.canvasSize = bounds.size();
+    return layout;
+}
+
+cv::bill_stitching::Compositor::Compositor(int featherRadius)
+        : featherRadius_(std::max(1, std::min(featherRadius, 255))) {}
+
+void cv::bill_stitching::Compositor::reset(const Size &size, const CanvasBudget &budget) {
+    canvas_.reset(size, budget);
+}
+
+Rect cv::bill_stitching::Compositor::warpedBounds(const Size &size, const Mat &H) {
+    vector<Point2d> corners = {Point2d(0, 0), Point2d(size.width, 0),
+                               Point2d(size.width, size.height), Point2d(0, size.height)};
+    perspectiveTransform(corners, corners, H);
+    vector<Point2f> cornersF(corners.begin(), corners.end());
+    return boundingRect(cornersF);
+}
+
+void cv::bill_stitching::Compositor::feed(const Mat &image, const Mat &toCanvas) {
+    CV_Assert(image.type() == CV_8UC3 && toCanvas.rows == 3 && toCanvas.cols == 3);
+    Mat H;
+    toCanvas.convertTo(H, CV_64F);
+    const Rect roi = warpedBounds(image.size(), H) & Rect(Point(), canvas_.size());
+    if (roi.empty()) {
+        return;
+    }
+
+    // Chỉ warp vào vùng (ROI) của frame thay vì cả canvas
+    Mat local = (Mat_<double>(3, 3) << 1, 0, -roi.x, 0, 1, -roi.y, 0, 0, 1) * H;
+    Mat warped, mask;
+    const Mat ones(image.size(), CV_8U, Scalar(255));
+    const bool affine = std::abs(local.at<double>(2, 0)) < 1e-12 && std::abs(local.at<double>(2, 1)) < 1e-12 &&
+                        std::abs(local.at<double>(2, 2) - 1) < 1e-12;
+    if (affine) {
+        warpAffine(image, warped, local.rowRange(0, 2), roi.size(), INTER_LINEAR, BORDER_CONSTANT);
+        warpAffine(ones, mask, local.rowRange(0, 2), roi.size(), INTER_NEAREST, BORDER_CONSTANT);
+    } else {
+        warpPerspective(image, warped, local, roi.size(), INTER_LINEAR, BORDER_CONSTANT);
+        warpPerspective(ones, mask, local, roi.size(), INTER_NEAREST, BORDER_CONSTANT);
+    }
+
+    feedWarped(warped, mask, roi.tl());
+}
+
+void cv::bill_stitching::Compositor::feedWarped(const Mat &warped, const Mat &mask, const Point &tl) {
+    CV_Assert(warped.type() == CV_8UC3 && mask.type() == CV_8UC1 && warped.size() == mask.size());
+    // Trọng số = khoảng cách tới mép frame, bão hoà ở featherRadius. Viền 1px để mép
+    // ROI trùng với mép frame cũng được tính là mép.
+    Mat padded, distance, weight;
+    copyMakeBorder(mask, padded, 1, 1, 1, 1, BORDER_CONSTANT, Scalar(0));
+    distanceTransform(padded, distance, DIST_L2, DIST_MASK_3);
+    distance(Rect(1, 1, mask.cols, mask.rows)).convertTo(weight, CV_8U, 255.0 / featherRadius_);
+
+    // Phần nằm ngoài canvas bị TiledCanvas cắt bỏ
+    canvas_.blend(warped, weight, tl);
+}
+
+Mat cv::bill_stitching::Compositor::result() {
+    return result(canvas_.covered());
+}
+
+Mat cv::bill_stitching::Compositor::result(const Rect &region) {
+    Mat out;
+    const Rect clipped = region & Rect(Point(), canvas_.size());
+    if (!clipped.empty()) {
+        canvas_.read(clipped, out);
+    }
+    logSpills(canvas_);
+    return out;
+}
+
+void cv::bill_stitching::Compositor::resultRGBA(const Rect &region, Mat &dst) {
+    const Rect clipped = region & Rect(Point(), canvas_.size());
+    if (clipped.empty()) {
+        dst.release();
+    } else {
+        canvas_.readRGBA(clipped, dst);
+    }
+    logSpills(canvas_);
+}
+
+bool cv::bill_stitching::Composite::empty() const {
+    return image.empty() && compositor.canvas().covered().empty();
+}
+
+Mat cv::bill_stitching::Composite::bgr() {
+    if (!image.empty()) {
+        return image;
+    }
+    return compositor.result(region.empty() ? compositor.canvas().covered() : region);
+}
+
+void cv::bill_stitching::Composite::readRGBA(Mat &dst) {
+    if (!image.empty()) {
+        cvtColor(image, dst, COLOR_BGR2RGBA);
+        image.release();
+        return;
+    }
+    compositor.resultRGBA(region.empty() ? compositor.canvas().covered() : region, dst);
+}
@@ -0,0 +1,86 @@
+#ifndef COMPOSITOR_HPP
+#define COMPOSITOR_HPP
+
+#include "opencv2/core/core.hpp"
+#include "tiled_canvas.hpp"
+#include <vector>
+
+namespace cv {
+    namespace bill_stitching {
+        // Bố cục toàn cục của một chuỗi frame: phép biến đổi của từng frame về canvas và
+        // kích thước canvas, tính một lần trước khi ghép.
+        struct FrameLayout {
+            std::vector<cv::Mat> toCanvas;   // 3x3 CV_64F per frame
+            cv::Size canvasSize;
+        };
+
+        // Chains the pairwise transforms (`toPrev[i]` maps frame i into frame i-1; the
+        // first entry is ignored) into canvas coordinates and computes the bounding box.
+        FrameLayout computeLayout(const std::vector<cv::Size> &sizes, const std::vector<cv::Mat> &toPrev);
+
+        // Ghép các frame đã warp vào một canvas BGR dựa trên mask phủ (coverage) tường
+        // minh được warp cùng frame, nên mực đen thật trên bill không bị coi là "trống".
+        // Vùng chồng lấp được trộn theo trọng số khoảng cách tới mép frame (feather), và
+        // mỗi lần feed chỉ đụng tới bounding box của frame vừa warp. Canvas là một
+        // TiledCanvas nên bill dài không giữ cả canvas trong RAM trong lúc ghép.
+        class Compositor {
+        public:
+            // featherRadius: distance from a frame edge (px) at which it reaches full weight.
+            explicit Compositor(int featherRadius = 32);
+
+            // Starts a black canvas of `size` with empty coverage. Tiles are allocated
+            // lazily and spill to disk beyond `budget`.
+            void reset(const cv::Size &size, const CanvasBudget &budget = defaultCanvasBudget());
+
+            // Warps `image` with the 3x3 transform `toCanvas` (affine or perspective) and
+            // blends it into the canvas. Parts outside the canvas are clipped.
+            void feed(const cv::Mat &image, const cv::Mat &toCanvas);
+
+            // Blends an image already warped by the caller (e.g. with a cv::detail warper).
+            // `mask` (CV_8U) marks the valid pixels of `warped`, `tl` is its canvas position.
+            void feedWarped(const cv::Mat &warped, const cv::Mat &mask, const cv::Point &tl);
+
+            // Bounding box of an image of `size` under the 3x3 transform `H`.
+            static cv::Rect warpedBounds(const cv::Size &size, const cv::Mat &H);
+
+            const TiledCanvas &canvas() const { return canvas_; }
+
+            // The canvas cropped to the covered area, assembled tile by tile into a
+            // single image (the only full-size allocation of the composition).
+            cv::Mat result();
+
+            // Only `region` (clipped to the canvas), e.g. a crop known in advance.
+            cv::Mat result(const cv::Rect &region);
+
+            // Like result(region), read tile by tile straight into `dst` as RGBA (CV_8UC4).
+            void resultRGBA(const cv::Rect &region, cv::Mat &dst);
+
+        private:
+            int featherRadius_;
+            TiledCanvas canvas_;
+        };
+
+        // Ảnh ghép chưa được đọc ra: vùng `region` của canvas dạng tile, hoặc một ảnh BGR đã
+        // ghép sẵn trong bộ nhớ (blender của cv::Stitcher). Chỉ đọc ra một lần, thẳng vào định
+        // dạng cần dùng (BGR để mã hoá ra file, RGBA cho StitchResult), để ảnh ghép không tồn
+        // tại hai lần ở kích thước đầy đủ.
+        struct Composite {
+            Compositor compositor;
+            cv::Rect region;              // canvas px; empty = covered area
+            cv::Mat image;                // BGR, set instead of the canvas when composed in memory
+
+            bool empty() const;
+
+            cv::Mat bgr();
+
+            // Reads the image into `dst` (CV_8UC4) and drops the in-memory BGR copy, if any.
+            void readRGBA(cv::Mat &dst);
+        };
+
+        // Blends one row: dst = (src * a + dst * (255 - a)) / 255 with a = 255 * srcW / (srcW + dstW),
+        // then dstW = max(srcW, dstW). BGR rows, `width` pixels.
+        void blendRow(const uchar *src, const uchar *srcW, uchar *dst, uchar *dstW, int width);
+    }
+}
+
+#endif //COMPOSITOR_HPP
@@ -0,0 +1,116 @@
+#include "opencv2/opencv.hpp"
+#include "opencv2/stitching/detail/matchers.hpp"
+#include "bill_stitching.hpp"
+#include "feature_benchmark.hpp"
+#include "keypoint_selection.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::detail;
+
+namespace {
+    const double kInlierTolerancePx = 3.0;
+
+    struct SyntheticPair {
+        Mat first, second;
+        Mat motion;                  // 2x3 CV_64F, first px -> second px
+    };
+
+    // Chuyển động của một lần quét xuống: nội dung trôi lên ~35% chiều cao, lệch ngang
+    // nhẹ và nghiêng trong khoảng [-2, 2] độ tuỳ theo ảnh
+    SyntheticPair synthesizePair(const Mat &image, int index) {
+        SyntheticPair pair;
+        pair.first = image;
+        const double angle = (index % 5) - 2.0;
+        const Point2f center(image.cols * 0.5f, image.rows * 0.5f);
+        pair.motion = getRotationMatrix2D(center, angle, 1.0);
+        pair.motion.at<double>(0, 2) += (index % 2 == 0 ? 0.02 : -0.02) * image.cols;
+        pair.motion.at<double>(1, 2) -= 0.35 * image.rows;
+        warpAffine(image, pair.second, pair.motion, image.size(), INTER_LINEAR, BORDER_CONSTANT);
+
+        // Frame sau thường sáng hơn/tối hơn một chút và có nhiễu cảm biến
+        Mat noise(pair.second.size(), CV_16SC(pair.second.channels()));
+        RNG rng(static_cast<uint64>(index) + 1);
+        rng.fill(noise, RNG::NORMAL, 0, 3);
+        Mat noisy;
+        pair.second.convertTo(noisy, CV_16S, 1.05, -4);
+        add(noisy, noise, noisy);
+        noisy.convertTo(pair.second, image.type());
+        return pair;
+    }
+
+    void findFeatures(const Ptr<Feature2D> &finder, const Mat &image, int index, ImageFeatures &features) {
+        features.img_idx = index;
+        features.img_size = image.size();
+        finder->detectAndCompute(image, noArray(), features.keypoints, features.descriptors);
+    }
+}
+
+vector<cv::bill_stitching::DetectorBenchmark>
+cv::bill_stitching::benchmarkDetectors(const vector<Mat> &images, const StitchConfig &config,
+                                       const vector<int> &detectors) {
+    // Cùng độ phân giải với bước tìm features của Stitcher
+    vector<SyntheticPair> pairs;
+    for (size_t i = 0; i < images.size(); ++i) {
+        if (images[i].empty()) {
+            continue;
+        }
+        Mat work = images[i];
+        const double scale = std::min(1.0, std::sqrt(config.registrationMegapix * 1e6 / images[i].total()));
+        if (scale < 1.0) {
+            resize(images[i], work, Size(), scale, scale, INTER_AREA);
+        }
+        pairs.push_back(synthesizePair(work, static_cast<int>(i)));
+    }
+
+    vector<DetectorBenchmark> results;
+    for (int detector: detectors) {
+        StitchConfig detectorConfig = config;
+        detectorConfig.detector = detector;
+        const Ptr<Feature2D> finder = makePtr<SelectiveFeatures>(createDetector(detectorConfig),
+                                                                 KeypointSelection{2.0f, config.maxFeatures});
+        AffineBestOf2NearestMatcher matcher(false, false, static_cast<float>(config.matchConfidence));
+
+        DetectorBenchmark result;
+        result.detector = detector;
+        int64 ticks = 0;
+        size_t keypoints = 0, matches = 0, agreeing = 0;
+        int registered = 0;
+        for (const auto &pair: pairs) {
+            ImageFeatures first, second;
+            const int64 start = getTickCount();
+            findFeatures(finder, pair.first, 0, first);
+            findFeatures(finder, pair.second, 1, second);
+            ticks += getTickCount() - start;
+            keypoints += first.keypoints.size() + second.keypoints.size();
+
+            MatchesInfo info;
+            matcher(first, second, info);
+            matcher.collectGarbage();
+            const Matx23d motion = pair.motion;
+            for (const auto &match: info.matches) {
+                const Point2f &p = first.keypoints[match.queryIdx].pt;
+                const Point2d expected(motion * Vec3d(p.x, p.y, 1));
+                if (norm(expected - Point2d(second.keypoints[match.trainIdx].pt)) <= kInlierTolerancePx) {
+                    ++agreeing;
+                }
+            }
+            matches += info.matches.size();
+            if (info.confidence >= config.panoConfidenceThresh) {
+                ++registered;
+            }
+        }
+        result.pairs = static_cast<int>(pairs.size());
+        if (result.pairs > 0) {
+            result.msPerFrame = ticks * 1000.0 / getTickFrequency() / (2.0 * result.pairs);
+            result.keypointsPerFrame = keypoints / (2.0 * result.pairs);
+            result.registeredRatio = static_cast<double>(registered) / result.pairs;
+        }
+        result.inlierRatio = matches > 0 ? static_cast<double>(agreeing) / matches : 0;
+        stitching_log("Benchmark detector %d: %.1f ms/frame, %.0f keypoints/frame, inliers %.1f%%, "
+                      "registered %d/%d pairs\n", detector, result.msPerFrame, result.keypointsPerFrame,
+                      result.inlierRatio * 100, registered, result.pairs);
+        results.push_back(result);
+    }
+    return results;
+}
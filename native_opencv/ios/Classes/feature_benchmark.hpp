@@ -0,0 +1,30 @@
+#ifndef FEATURE_BENCHMARK_HPP
+#define FEATURE_BENCHMARK_HPP
+
+#include "opencv2/core/core.hpp"
+#include "stitch_config.hpp"
+#include <vector>
+
+namespace cv {
+    namespace bill_stitching {
+        struct DetectorBenchmark {
+            int detector = 0;              // FeatureDetector
+            int pairs = 0;
+            double msPerFrame = 0;         // detectAndCompute + ANMS
+            double keypointsPerFrame = 0;
+            double inlierRatio = 0;        // matches agreeing with the known motion (3 px) / all matches
+            double registeredRatio = 0;    // pairs whose match confidence reaches panoConfidenceThresh
+        };
+
+        // So sánh các detector trên bộ cặp ảnh tổng hợp: mỗi ảnh bill được ghép với chính
+        // nó sau một chuyển động quét biết trước (tịnh tiến ~35% chiều cao, nghiêng vài độ,
+        // đổi độ sáng nhẹ và nhiễu), nên tỉ lệ inlier được đo theo chuyển động thật thay vì
+        // theo RANSAC của matcher. Ảnh được thu về registrationMegapix như khi ghép, mỗi
+        // detector đi qua cùng ANMS và AffineBestOf2NearestMatcher với ngưỡng của `config`.
+        std::vector<DetectorBenchmark> benchmarkDetectors(const std::vector<cv::Mat> &images,
+                                                          const StitchConfig &config,
+                                                          const std::vector<int> &detectors);
+    }
+}
+
+#endif //FEATURE_BENCHMARK_HPP
@@ -0,0 +1,75 @@
+#ifndef FEATURE_CACHE_HPP
+#define FEATURE_CACHE_HPP
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/features2d.hpp"
+#include "keypoint_selection.hpp"
+#include "stitch_config.hpp"
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace cv {
+    namespace bill_stitching {
+        // Cache features trên đĩa, đánh địa chỉ theo nội dung: khoá là hash của ảnh đưa
+        // vào detector cùng chữ ký tham số detector, nên chạy lại cùng bộ ảnh (thử lại với
+        // config khác, chạy lại dataset QA) không phải tìm lại features. Mỗi mục là một file
+        // nhị phân đọc lại bằng mmap; tổng dung lượng bị giới hạn, mục ít dùng nhất (LRU
+        // theo mtime, được cập nhật mỗi lần đọc trúng) bị xoá trước.
+        struct FeatureCacheSettings {
+            std::string dir;               // empty = cache disabled
+            size_t maxBytes = 64u << 20;
+        };
+
+        // Process-wide, set once from the app (e.g. a folder in its cache directory).
+        // The directory is created if needed.
+        void setFeatureCache(const FeatureCacheSettings &settings);
+
+        FeatureCacheSettings featureCache();
+
+        // 64-bit hash of the pixel bytes, size and type of `image`.
+        uint64_t hashImage(const cv::Mat &image);
+
+        // Tham số quyết định kết quả của detector, để config khác không đọc nhầm mục cache.
+        std::string featureSignature(const StitchConfig &config, const KeypointSelection &selection);
+
+        bool loadCachedFeatures(uint64_t key, std::vector<cv::KeyPoint> &keypoints, cv::Mat &descriptors);
+
+        // Writes atomically (temp file + rename), then evicts down to the size cap.
+        void storeCachedFeatures(uint64_t key, const std::vector<cv::KeyPoint> &keypoints,
+                                 const cv::Mat &descriptors);
+
+        // Feature2D tra cache trước khi gọi detectAndCompute của finder bọc bên trong.
+        // cv::detail::computeImageFeatures gọi detect() rồi compute() riêng: descriptor
+        // của lần detect được giữ lại cho lần compute ngay sau đó với cùng ảnh.
+        class CachedFeatures : public cv::Feature2D {
+        public:
+            CachedFeatures(const cv::Ptr<cv::Feature2D> &finder, const std::string &signature)
+                    : finder_(finder), signature_(signature) {}
+
+            void detectAndCompute(cv::InputArray image, cv::InputArray mask,
+                                  std::vector<cv::KeyPoint> &keypoints, cv::OutputArray descriptors,
+                                  bool useProvidedKeypoints) CV_OVERRIDE;
+
+            int descriptorSize() const CV_OVERRIDE { return finder_->descriptorSize(); }
+
+            int descriptorType() const CV_OVERRIDE { return finder_->descriptorType(); }
+
+            int defaultNorm() const CV_OVERRIDE { return finder_->defaultNorm(); }
+
+            bool empty() const CV_OVERRIDE { return finder_->empty(); }
+
+            cv::String getDefaultName() const CV_OVERRIDE { return finder_->getDefaultName(); }
+
+        private:
+            cv::Ptr<cv::Feature2D> finder_;
+            std::string signature_;
+            std::mutex pendingMutex_;
+            std::map<uint64_t, cv::Mat> pending_;   // descriptors found by detect(), by key
+        };
+    }
+}
+
+#endif //FEATURE_CACHE_HPP
@@ -0,0 +1,49 @@
+#include "opencv2/opencv.hpp"
+#include "frame_culling.hpp"
+#include "frame_registration.hpp"
+#include "bill_stitching.hpp"
+
+using namespace std;
+using namespace cv;
+
+cv::bill_stitching::CullResult
+cv::bill_stitching::cullRedundantFrames(const vector<Mat> &images, double minOverlap) {
+    const int n = static_cast<int>(images.size());
+    CullResult result;
+    if (n == 0) {
+        return result;
+    }
+
+    // Thumbnail (mức thô của phase correlation) cho mọi frame, song song trên các core
+    vector<PhaseImage> thumbs(n);
+    parallel_for_(Range(0, n), [&](const Range &range) {
+        for (int i = range.start; i < range.end; ++i) {
+            Mat gray;
+            if (images[i].channels() == 1) {
+                gray = images[i];
+            } else {
+                cvtColor(images[i], gray, COLOR_BGR2GRAY);
+            }
+            thumbs[i] = preparePhaseImage(gray, false);
+        }
+    });
+
+    int anchor = 0;
+    result.kept.push_back(0);
+    while (anchor < n - 1) {
+        // Frame xa nhất còn đủ chồng lấp; dừng ở frame đầu tiên không đạt để một khớp
+        // nhầm ở xa (dòng chữ lặp lại) không làm nhảy qua cả một đoạn bill
+        int next = anchor + 1;
+        for (int j = anchor + 1; j < n; ++j) {
+            if (estimateOverlap(thumbs[anchor], thumbs[j]) < minOverlap) {
+                break;
+            }
+            next = j;
+        }
+        result.dropped += next - anchor - 1;
+        result.kept.push_back(next);
+        anchor = next;
+    }
+    stitching_log("Culling: kept %lu of %d frames (min overlap %.2f)\n", result.kept.size(), n, minOverlap);
+    return result;
+}
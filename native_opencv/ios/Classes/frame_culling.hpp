@@ -0,0 +1,23 @@
+#ifndef FRAME_CULLING_HPP
+#define FRAME_CULLING_HPP
+
+#include "opencv2/core/core.hpp"
+#include <vector>
+
+namespace cv {
+    namespace bill_stitching {
+        struct CullResult {
+            std::vector<int> kept;             // indices into the input, in order
+            int dropped = 0;
+        };
+
+        // Loại các frame thừa (người dùng dừng lại giữa bill nên nhiều frame gần như trùng
+        // nhau) trước khi chạy pipeline ghép đắt đỏ. Từ mỗi frame được giữ, nhảy tới frame
+        // xa nhất vẫn còn chồng lấp >= minOverlap với nó; độ chồng lấp được ước lượng bằng
+        // phase correlation trên thumbnail. Frame đầu và cuối luôn được giữ.
+        // `images` are in capture order (BGR or gray).
+        CullResult cullRedundantFrames(const std::vector<cv::Mat> &images, double minOverlap);
+    }
+}
+
+#endif //FRAME_CULLING_HPP
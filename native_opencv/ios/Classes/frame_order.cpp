@@ -0,0 +1,99 @@
+#include "frame_order.hpp"
+#include <algorithm>
+#include <cctype>
+
+using namespace std;
+using namespace cv;
+
+namespace {
+    struct OrderKey {
+        int index = 0;
+        int64 timestampUs = 0;
+        vector<string> numbers;      // numeric runs of the file name, leading zeros stripped
+        size_t nameLength = 0;
+    };
+
+    OrderKey makeKey(int index, const std::string &path, int64 timestampUs) {
+        OrderKey key;
+        key.index = index;
+        key.timestampUs = timestampUs;
+
+        size_t slashPos = path.find_last_of('/');
+        const size_t start = slashPos == std::string::npos ? 0 : slashPos + 1;
+        key.nameLength = path.size() - start;
+        for (size_t pos = start; pos < path.size();) {
+            if (!std::isdigit(static_cast<unsigned char>(path[pos]))) {
+                ++pos;
+                continue;
+            }
+            while (pos + 1 < path.size() && path[pos] == '0' &&
+                   std::isdigit(static_cast<unsigned char>(path[pos + 1]))) {
+                ++pos;
+            }
+            size_t end = pos;
+            while (end < path.size() && std::isdigit(static_cast<unsigned char>(path[end]))) {
+                ++end;
+            }
+            key.numbers.push_back(path.substr(pos, end - pos));
+            pos = end;
+        }
+        return key;
+    }
+
+    // So sánh hai số dạng chuỗi (không có số 0 ở đầu), không giới hạn độ dài
+    int compareNumbers(const std::string &a, const std::string &b) {
+        if (a.size() != b.size()) {
+            return a.size() < b.size() ? -1 : 1;
+        }
+        return a.compare(b);
+    }
+
+    // Thứ tự số tự nhiên: so sánh lần lượt các cụm số; tên còn cụm số đứng trước,
+    // nếu bằng nhau thì tên ngắn hơn đứng trước
+    bool naturalLess(const OrderKey &a, const OrderKey &b) {
+        const size_t common = std::min(a.numbers.size(), b.numbers.size());
+        for (size_t i = 0; i < common; ++i) {
+            int cmp = compareNumbers(a.numbers[i], b.numbers[i]);
+            if (cmp != 0) {
+                return cmp < 0;
+            }
+        }
+        if (a.numbers.size() != b.numbers.size()) {
+            return a.numbers.size() > b.numbers.size();
+        }
+        return a.nameLength < b.nameLength;
+    }
+}
+
+vector<int> cv::bill_stitching::captureOrder(const vector<std::string> &imagePaths,
+                                             const vector<int64> &timestampsUs) {
+    const int n = static_cast<int>(imagePaths.size());
+    bool useTimestamps = static_cast<int>(timestampsUs.size()) == n && n > 0;
+    for (int i = 0; useTimestamps && i < n; ++i) {
+        useTimestamps = timestampsUs[i] > 0;
+    }
+    // Ảnh được sao chép vào cache (image_picker) thường có cùng thời gian sửa đổi
+    if (useTimestamps && std::all_of(timestampsUs.begin(), timestampsUs.end(),
+                                     [&](int64 t) { return t == timestampsUs[0]; })) {
+        useTimestamps = false;
+    }
+
+    vector<OrderKey> keys;
+    keys.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        keys.push_back(makeKey(i, imagePaths[i], useTimestamps ? timestampsUs[i] : 0));
+    }
+    std::stable_sort(keys.begin(), keys.end(), [](const OrderKey &a, const OrderKey &b) {
+        if (a.timestampUs != b.timestampUs) {
+            return a.timestampUs < b.timestampUs;
+        }
+        return naturalLess(a, b);
+    });
+
+    vector<int> order;
+    order.reserve(n);
+    for (const auto &key: keys) {
+        order.push_back(key.index);
+    }
+    return order;
+}
@@ -0,0 +1,21 @@
+#ifndef FRAME_ORDER_HPP
+#define FRAME_ORDER_HPP
+
+#include "opencv2/core/core.hpp"
+#include <string>
+#include <vector>
+
+namespace cv {
+    namespace bill_stitching {
+        // Thứ tự chụp của các ảnh đầu vào, trả về chỉ số ảnh theo thứ tự đó.
+        //
+        // Khi có timestamp (micro giây, > 0) và chúng không trùng hết nhau, ảnh được
+        // sắp xếp ổn định theo timestamp; ngược lại (hoặc khi hai ảnh trùng timestamp)
+        // dùng thứ tự số tự nhiên của tên file, ví dụ "img_2" đứng trước "img_10".
+        // Khoá sắp xếp được tính trước một lần cho mỗi ảnh, không tính trong comparator.
+        std::vector<int> captureOrder(const std::vector<std::string> &imagePaths,
+                                      const std::vector<int64> &timestampsUs);
+    }
+}
+
+#endif //FRAME_ORDER_HPP
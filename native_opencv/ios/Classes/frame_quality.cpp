@@ -0,0 +1,153 @@
+#include "opencv2/opencv.hpp"
+#include "frame_quality.hpp"
+#include "frame_registration.hpp"
+#include "bill_stitching.hpp"
+#include <algorithm>
+
+using namespace std;
+using namespace cv;
+
+namespace {
+    // Cạnh dài nhất của ảnh dùng để chấm điểm
+    const int kScoreMaxDim = 480;
+    const int kClipLevel = 250;
+
+    double tenengrad(const Mat &gray) {
+        Mat gx, gy;
+        Sobel(gray, gx, CV_32F, 1, 0);
+        Sobel(gray, gy, CV_32F, 0, 1);
+        return mean(gx.mul(gx) + gy.mul(gy))[0];
+    }
+
+    Mat grayFrame(const Mat &image) {
+        Mat gray;
+        if (image.channels() == 1) {
+            gray = image;
+        } else {
+            cvtColor(image, gray, COLOR_BGR2GRAY);
+        }
+        return gray;
+    }
+}
+
+cv::bill_stitching::FrameQuality
+cv::bill_stitching::scoreFrame(const Mat &image, const QualityThresholds &thresholds) {
+    CV_Assert(!image.empty() && image.depth() == CV_8U);
+    Mat gray = grayFrame(image);
+    const double scale = std::min(1.0, static_cast<double>(kScoreMaxDim) / std::max(gray.cols, gray.rows));
+    if (scale < 1.0) {
+        resize(gray, gray, Size(), scale, scale, INTER_AREA);
+    }
+
+    FrameQuality quality;
+    quality.meanLuma = mean(gray)[0];
+    quality.clippedRatio = static_cast<double>(countNonZero(gray >= kClipLevel)) / gray.total();
+    quality.tenengrad = tenengrad(gray);
+    Mat blurred;
+    GaussianBlur(gray, blurred, Size(5, 5), 1.0);
+    quality.sharpness = quality.tenengrad > 1e-6
+                        ? std::max(0.0, 1.0 - tenengrad(blurred) / quality.tenengrad) : 0;
+    quality.acceptable = quality.sharpness >= thresholds.minSharpness &&
+                         quality.clippedRatio <= thresholds.maxClipped &&
+                         quality.meanLuma >= thresholds.minMeanLuma &&
+                         quality.meanLuma <= thresholds.maxMeanLuma;
+    return quality;
+}
+
+cv::bill_stitching::QualitySelection
+cv::bill_stitching::selectQualityFrames(const vector<Mat> &images, const vector<FrameQuality> &qualities,
+                                        const QualityThresholds &thresholds, double minOverlap) {
+    CV_Assert(images.size() == qualities.size());
+    const int n = static_cast<int>(images.size());
+    QualitySelection selection;
+    if (n == 0) {
+        return selection;
+    }
+
+    // Ngưỡng tương đối theo độ nét trung vị: độ nét tuyệt đối phụ thuộc nội dung bill
+    vector<double> sharpness;
+    for (const auto &q: qualities) {
+        sharpness.push_back(q.sharpness);
+    }
+    nth_element(sharpness.begin(), sharpness.begin() + n / 2, sharpness.end());
+    const double minRelative = thresholds.relativeSharpness * sharpness[n / 2];
+
+    vector<bool> keep(n);
+    for (int i = 0; i < n; ++i) {
+        keep[i] = qualities[i].acceptable && qualities[i].sharpness >= minRelative;
+        if (!keep[i]) {
+            stitching_log("Quality: frame %d rejected (sharpness=%.2f, clipped=%.2f, mean=%.0f)\n", i,
+                          qualities[i].sharpness, qualities[i].clippedRatio, qualities[i].meanLuma);
+        }
+    }
+
+    // Frame đầu và cuối chứa mép trên/dưới của bill: nếu các frame ở đầu hoặc cuối chuỗi
+    // đều bị loại thì giữ lại frame tốt nhất trong số đó (như cull luôn giữ hai frame này).
+    // Làm trước bước nối khoảng trống để frame vừa giữ cũng được nối với phần còn lại.
+    const auto firstKept = std::find(keep.begin(), keep.end(), true);
+    if (firstKept != keep.end()) {
+        const int first = static_cast<int>(firstKept - keep.begin());
+        const int last = n - 1 - static_cast<int>(std::find(keep.rbegin(), keep.rend(), true) - keep.rbegin());
+        auto restoreBest = [&](int begin, int end) {
+            if (begin >= end) {
+                return;
+            }
+            int best = begin;
+            for (int j = begin + 1; j < end; ++j) {
+                if (qualities[j].sharpness > qualities[best].sharpness) {
+                    best = j;
+                }
+            }
+            keep[best] = true;
+            ++selection.restored;
+            stitching_log("Quality: frame %d restored to keep the end of the bill\n", best);
+        };
+        restoreBest(0, first);
+        restoreBest(last + 1, n);
+    }
+
+    // Ảnh phase chỉ được tính cho các frame cần ước lượng chồng lấp
+    vector<PhaseImage> phases(n);
+    auto phaseOf = [&](int i) -> const PhaseImage & {
+        if (phases[i].empty()) {
+            Mat gray = grayFrame(images[i]);
+            phases[i] = preparePhaseImage(gray, false);
+        }
+        return phases[i];
+    };
+
+    int prev = -1;
+    for (int i = 0; i < n; ++i) {
+        if (!keep[i]) {
+            continue;
+        }
+        if (prev >= 0 && i - prev > 1 && estimateOverlap(phaseOf(prev), phaseOf(i)) < minOverlap) {
+            // Giữ lại frame bị loại tốt nhất nằm giữa hai frame để không có khoảng trống
+            int best = prev + 1;
+            for (int j = prev + 2; j < i; ++j) {
+                if (qualities[j].sharpness > qualities[best].sharpness) {
+                    best = j;
+                }
+            }
+            keep[best] = true;
+            ++selection.restored;
+            stitching_log("Quality: frame %d restored to keep frames %d and %d connected\n", best, prev, i);
+        }
+        prev = i;
+    }
+    // Không frame nào đạt: giữ nguyên chuỗi, để bước ghép tự quyết định
+    if (prev < 0) {
+        for (int i = 0; i < n; ++i) {
+            keep[i] = true;
+        }
+    }
+
+    for (int i = 0; i < n; ++i) {
+        if (keep[i]) {
+            selection.kept.push_back(i);
+        } else {
+            ++selection.rejected;
+        }
+    }
+    return selection;
+}
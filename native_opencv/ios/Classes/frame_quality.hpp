@@ -0,0 +1,50 @@
+#ifndef FRAME_QUALITY_HPP
+#define FRAME_QUALITY_HPP
+
+#include "opencv2/core/core.hpp"
+#include <vector>
+
+namespace cv {
+    namespace bill_stitching {
+        struct QualityThresholds {
+            double minSharpness = 0.3;         // see FrameQuality::sharpness
+            double relativeSharpness = 0.6;    // batch: fraction of the sequence's median sharpness
+            double maxClipped = 0.3;           // fraction of pixels at or above 250
+            double minMeanLuma = 50;
+            double maxMeanLuma = 235;
+        };
+
+        struct FrameQuality {
+            // Tỉ lệ năng lượng gradient (Tenengrad) mất đi khi làm mờ nhẹ ảnh: ảnh nét mất
+            // nhiều, ảnh đã nhoè gần như không đổi. Không phụ thuộc độ tương phản, 0..1.
+            double sharpness = 0;
+            double tenengrad = 0;              // mean squared Sobel magnitude
+            double clippedRatio = 0;
+            double meanLuma = 0;
+            bool acceptable = false;
+        };
+
+        // Chấm điểm chất lượng một frame trên ảnh sáng (luma) thu nhỏ, vài mili giây.
+        // `image` may be BGR or single-channel 8-bit at any resolution.
+        FrameQuality scoreFrame(const cv::Mat &image, const QualityThresholds &thresholds = QualityThresholds());
+
+        struct QualitySelection {
+            std::vector<int> kept;             // indices into the input, in order
+            int rejected = 0;                  // frames finally left out
+            int restored = 0;                  // rejected frames put back to close a gap or keep an end
+        };
+
+        // Bộ lọc trước khi ghép: bỏ các frame mờ hoặc sai phơi sáng (so với ngưỡng tuyệt
+        // đối và so với độ nét trung vị của chuỗi). Nếu hai frame còn lại liền kề không
+        // đủ chồng lấp (< minOverlap), frame bị loại tốt nhất giữa chúng được giữ lại;
+        // tương tự, nếu các frame đầu (hoặc cuối) chuỗi bị loại, frame tốt nhất trong số đó
+        // được giữ lại để không mất mép trên/dưới của bill.
+        // `images` are in capture order; `qualities` must hold one score per image.
+        QualitySelection selectQualityFrames(const std::vector<cv::Mat> &images,
+                                             const std::vector<FrameQuality> &qualities,
+                                             const QualityThresholds &thresholds = QualityThresholds(),
+                                             double minOverlap = 0.2);
+    }
+}
+
+#endif //FRAME_QUALITY_HPP
@@ -0,0 +1,224 @@
+#include "opencv2/opencv.hpp"
+#include "opencv2/stitching/detail/matchers.hpp"
+#include "frame_registration.hpp"
+#include "bill_stitching.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::detail;
+
+namespace {
+    const int kMinInliers = 12;
+    const double kMinConfidence = 0.3;
+    // Bán kính chấp nhận tối thiểu so với dự đoán, theo cạnh lớn nhất của frame
+    const double kPriorMinRadius = 0.5;
+
+    // Phase correlation: cạnh dài nhất của mức thô, phần chồng lấp tối thiểu (theo tỉ lệ
+    // diện tích frame), ngưỡng NCC của vùng chồng lấp sau khi căn chỉnh và độ lệch tối đa
+    // (px) giữa hai nửa vùng chồng lấp trước khi coi là có xoay/co giãn
+    const int kCoarseMaxDim = 128;
+    const double kMinOverlap = 0.15;
+    const double kMinPhaseResponse = 0.02;
+    const double kMinOverlapNcc = 0.75;
+    const double kMaxHalfDisagreement = 1.5;
+    // estimateOverlap: NCC tối thiểu của vùng chồng lấp ở mức thô
+    const double kMinCoarseNcc = 0.5;
+
+    bool withinPrior(const Point2d &shift, const cv::bill_stitching::MotionPrior &prior) {
+        if (prior.valid && norm(shift - prior.shift) > prior.radius) {
+            stitching_log("Pair registration rejected: shift (%.0f, %.0f) too far from predicted (%.0f, %.0f)\n",
+                          shift.x, shift.y, prior.shift.x, prior.shift.y);
+            return false;
+        }
+        return true;
+    }
+
+    // Vùng chồng lấp trong hệ toạ độ của prev và của cur với phép tịnh tiến nguyên `t`
+    // (điểm p của cur nằm tại p + t trong prev).
+    bool overlapRects(const Size &size, const Point &t, Rect &inPrev, Rect &inCur) {
+        inPrev = Rect(Point(), size) & Rect(t, size);
+        inCur = inPrev - t;
+        return inPrev.area() >= kMinOverlap * size.area() && inPrev.width >= 32 && inPrev.height >= 32;
+    }
+
+    // Dịch chuyển của `cur` so với `prev` (cùng kích thước), có cửa sổ Hanning
+    Point2d correlate(const Mat &prev, const Mat &cur, double *response) {
+        Mat window;
+        createHanningWindow(window, prev.size(), CV_32F);
+        return phaseCorrelate(prev, cur, window, response);
+    }
+
+    // Loại bỏ các phép biến đổi suy biến hoặc lật ảnh
+    bool isAffineSane(const Mat &H) {
+        double det = H.at<double>(0, 0) * H.at<double>(1, 1) -
+                     H.at<double>(0, 1) * H.at<double>(1, 0);
+        // Giữa hai frame liên tiếp tỉ lệ gần như không đổi
+        return det > 0.25 && det < 4.0;
+    }
+}
+
+cv::bill_stitching::MotionPrior
+cv::bill_stitching::predictMotion(const Point2d &velocity, int64 dtUs, const Size &frameSize) {
+    MotionPrior prior;
+    if (dtUs <= 0) {
+        return prior;
+    }
+    prior.valid = true;
+    prior.shift = velocity * static_cast<double>(dtUs);
+    // Cửa sổ tìm kiếm lớn dần theo quãng đường dự đoán
+    prior.radius = kPriorMinRadius * std::max(frameSize.width, frameSize.height) + norm(prior.shift);
+    return prior;
+}
+
+cv::bill_stitching::PairRegistration
+cv::bill_stitching::registerPair(const ImageFeatures &prev, const ImageFeatures &cur,
+                                 FeaturesMatcher &matcher, const MotionPrior &prior) {
+    PairRegistration reg;
+    if (prev.keypoints.empty() || cur.keypoints.empty()) {
+        return reg;
+    }
+
+    // AffineBestOf2NearestMatcher ước lượng H từ features1 sang features2,
+    // nên truyền frame hiện tại trước để H đưa frame hiện tại về frame trước đó.
+    MatchesInfo info;
+    matcher(cur, prev, info);
+
+    reg.num_matches = static_cast<int>(info.matches.size());
+    reg.num_inliers = info.num_inliers;
+    reg.confidence = info.confidence;
+    if (info.H.empty() || reg.num_inliers < kMinInliers || reg.confidence < kMinConfidence) {
+        stitching_log("Pair registration rejected: matches=%d, inliers=%d, confidence=%f\n",
+                      reg.num_matches, reg.num_inliers, reg.confidence);
+        return reg;
+    }
+
+    info.H.convertTo(reg.H, CV_64F);
+    if (!isAffineSane(reg.H)) {
+        stitching_log("Pair registration rejected: degenerate transform\n");
+        return reg;
+    }
+    if (!withinPrior(Point2d(reg.H.at<double>(0, 2), reg.H.at<double>(1, 2)), prior)) {
+        return reg;
+    }
+    reg.ok = true;
+    return reg;
+}
+
+cv::bill_stitching::PhaseImage cv::bill_stitching::preparePhaseImage(const Mat &gray, bool withFine) {
+    CV_Assert(gray.type() == CV_8UC1);
+    PhaseImage phase;
+    const double s = std::min(1.0, static_cast<double>(kCoarseMaxDim) / std::max(gray.cols, gray.rows));
+    Mat coarse;
+    resize(gray, coarse, Size(), s, s, INTER_AREA);
+    coarse.convertTo(phase.coarse, CV_32F, 1.0 / 255);
+    phase.coarseScale = static_cast<double>(gray.cols) / phase.coarse.cols;
+    if (withFine) {
+        gray.convertTo(phase.fine, CV_32F, 1.0 / 255);
+    }
+    return phase;
+}
+
+double cv::bill_stitching::estimateOverlap(const PhaseImage &a, const PhaseImage &b) {
+    if (a.empty() || b.empty() || a.coarse.size() != b.coarse.size()) {
+        return 0;
+    }
+    const Size size = a.coarse.size();
+    const Point2d d = correlate(a.coarse, b.coarse, nullptr);
+
+    // Phép tương quan tuần hoàn không phân biệt được d với d - kích thước frame; chọn
+    // ứng viên có NCC vùng chồng lấp cao nhất
+    const double xs[] = {d.x, d.x - (d.x > 0 ? size.width : -size.width)};
+    const double ys[] = {d.y, d.y - (d.y > 0 ? size.height : -size.height)};
+    double best = 0, bestNcc = kMinCoarseNcc;
+    for (double dx: xs) {
+        for (double dy: ys) {
+            const Point t(cvRound(-dx), cvRound(-dy));
+            const Rect inA = Rect(Point(), size) & Rect(t, size);
+            if (inA.width < 8 || inA.height < 8) {
+                continue;
+            }
+            Mat ncc;
+            matchTemplate(a.coarse(inA), b.coarse(inA - t), ncc, TM_CCOEFF_NORMED);
+            if (ncc.at<float>(0, 0) > bestNcc) {
+                bestNcc = ncc.at<float>(0, 0);
+                best = static_cast<double>(inA.area()) / size.area();
+            }
+        }
+    }
+    return best;
+}
+
+cv::bill_stitching::PairRegistration
+cv::bill_stitching::registerTranslation(const PhaseImage &prev, const PhaseImage &cur,
+                                        const MotionPrior &prior, bool checkRotation) {
+    PairRegistration reg;
+    if (prev.fine.empty() || cur.fine.empty() || prev.fine.size() != cur.fine.size()) {
+        return reg;
+    }
+
+    // 1. Mức thô trên toàn frame: nội dung của cur dịch đi d so với prev, nên điểm
+    //    của cur nằm tại -d trong prev
+    double response = 0;
+    Point2d t = -correlate(prev.coarse, cur.coarse, &response) * prev.coarseScale;
+    if (prior.valid) {
+        // Phép tương quan là tuần hoàn: dịch chuyển quá nửa frame bị gập về phía bên kia,
+        // chọn bản gần với dự đoán nhất
+        const Point2d period(prev.fine.cols, prev.fine.rows);
+        Point2d best = t;
+        for (int ky = -1; ky <= 1; ++ky) {
+            for (int kx = -1; kx <= 1; ++kx) {
+                Point2d candidate(t.x + kx * period.x, t.y + ky * period.y);
+                if (norm(candidate - prior.shift) < norm(best - prior.shift)) {
+                    best = candidate;
+                }
+            }
+        }
+        t = best;
+    }
+
+    // 2. Mức tinh trên vùng chồng lấp đã căn chỉnh thô, phần dư còn lại nhỏ và
+    //    phaseCorrelate trả về giá trị sub-pixel (weighted centroid quanh đỉnh)
+    Rect inPrev, inCur;
+    Point coarseT(cvRound(t.x), cvRound(t.y));
+    if (!overlapRects(prev.fine.size(), coarseT, inPrev, inCur)) {
+        stitching_log("Phase registration rejected: overlap too small at (%d, %d)\n", coarseT.x, coarseT.y);
+        return reg;
+    }
+    const Mat prevOverlap = prev.fine(inPrev), curOverlap = cur.fine(inCur);
+    t = Point2d(coarseT) - correlate(prevOverlap, curOverlap, &response);
+
+    // 3. Hai nửa trái/phải của vùng chồng lấp phải cho cùng một phép tịnh tiến,
+    //    nếu không giữa hai frame có xoay hoặc co giãn và cần ghép bằng features
+    if (checkRotation && inPrev.width >= 64) {
+        const int half = inPrev.width / 2;
+        const Rect left(0, 0, half, inPrev.height), right(half, 0, half, inPrev.height);
+        const Point2d dl = correlate(prevOverlap(left), curOverlap(left), nullptr);
+        const Point2d dr = correlate(prevOverlap(right), curOverlap(right), nullptr);
+        if (norm(dl - dr) > kMaxHalfDisagreement) {
+            stitching_log("Phase registration rejected: halves disagree by (%.1f, %.1f)\n",
+                          dr.x - dl.x, dr.y - dl.y);
+            return reg;
+        }
+    }
+
+    // 4. Độ tin cậy: NCC của vùng chồng lấp sau khi căn chỉnh, để một đỉnh sai (ví dụ
+    //    do các dòng chữ lặp lại) không được chấp nhận chỉ vì đỉnh đủ nhọn
+    Point finalT(cvRound(t.x), cvRound(t.y));
+    if (!overlapRects(prev.fine.size(), finalT, inPrev, inCur)) {
+        return reg;
+    }
+    Mat ncc;
+    matchTemplate(prev.fine(inPrev), cur.fine(inCur), ncc, TM_CCOEFF_NORMED);
+    reg.confidence = ncc.at<float>(0, 0);
+    if (response < kMinPhaseResponse || reg.confidence < kMinOverlapNcc) {
+        stitching_log("Phase registration rejected: response=%f, ncc=%f\n", response, reg.confidence);
+        return reg;
+    }
+    if (!withinPrior(t, prior)) {
+        return reg;
+    }
+
+    reg.H = (Mat_<double>(3, 3) << 1, 0, t.x, 0, 1, t.y, 0, 0, 1);
+    reg.ok = true;
+    return reg;
+}
@@ -0,0 +1,67 @@
+#ifndef FRAME_REGISTRATION_HPP
+#define FRAME_REGISTRATION_HPP
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/stitching/detail/matchers.hpp"
+
+namespace cv {
+    namespace bill_stitching {
+        // Kết quả đăng ký (registration) giữa hai frame liên tiếp
+        struct PairRegistration {
+            cv::Mat H;            // 3x3 CV_64F affine, maps current frame into previous frame
+            int num_matches = 0;
+            int num_inliers = 0;
+            double confidence = 0;
+            bool ok = false;
+        };
+
+        // Dự đoán chuyển động giữa hai frame từ vận tốc của cặp trước và khoảng thời
+        // gian giữa hai lần chụp. Dùng để loại các phép ghép lệch xa so với dự đoán
+        // (ví dụ khớp nhầm giữa các dòng chữ giống nhau trên bill).
+        struct MotionPrior {
+            bool valid = false;
+            cv::Point2d shift;    // predicted translation of `cur` in `prev` coordinates, px
+            double radius = 0;    // accepted distance from `shift`, px
+        };
+
+        // Predicts the next shift from the last accepted one. `velocity` is in px per
+        // microsecond; `dtUs` is the time between the two captures.
+        MotionPrior predictMotion(const cv::Point2d &velocity, int64 dtUs, const cv::Size &frameSize);
+
+        // Matches `cur` against its predecessor `prev` and estimates the affine transform
+        // that brings `cur` into the coordinate frame of `prev`.
+        PairRegistration registerPair(const cv::detail::ImageFeatures &prev,
+                                      const cv::detail::ImageFeatures &cur,
+                                      cv::detail::FeaturesMatcher &matcher,
+                                      const MotionPrior &prior = MotionPrior());
+
+        // Ảnh sáng (luma) dạng float cho phase correlation: một bản thu nhỏ để ước
+        // lượng thô và bản ở độ phân giải làm việc để tinh chỉnh.
+        struct PhaseImage {
+            cv::Mat coarse;       // CV_32F, longest side <= 128 px
+            cv::Mat fine;         // CV_32F, working resolution
+            double coarseScale = 1;   // fine px per coarse px
+
+            bool empty() const { return coarse.empty(); }
+        };
+
+        // Without `withFine` only the coarse level is built, enough for estimateOverlap().
+        PhaseImage preparePhaseImage(const cv::Mat &gray, bool withFine = true);
+
+        // Ước lượng nhanh tỉ lệ diện tích chồng lấp giữa hai frame chỉ từ mức thô (vài
+        // trăm micro giây). Returns 0 when the frames cannot be aligned reliably.
+        double estimateOverlap(const PhaseImage &a, const PhaseImage &b);
+
+        // Người dùng di chuyển camera thẳng dọc theo bill (overlay hướng dẫn), nên chuyển
+        // động giữa hai frame gần như chỉ là tịnh tiến. Ước lượng tịnh tiến bằng phase
+        // correlation thô-đến-tinh (FFT), thay cho tìm và ghép features. With
+        // `checkRotation`, the overlap halves are correlated separately and any
+        // rotation/scale between them rejects the pair. `reg.ok` is false when the
+        // correlation is not trustworthy; callers then fall back to registerPair().
+        PairRegistration registerTranslation(const PhaseImage &prev, const PhaseImage &cur,
+                                             const MotionPrior &prior = MotionPrior(),
+                                             bool checkRotation = true);
+    }
+}
+
+#endif //FRAME_REGISTRATION_HPP
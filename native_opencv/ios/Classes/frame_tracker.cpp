@@ -0,0 +1,154 @@
+#include "opencv2/opencv.hpp"
+#include "opencv2/calib3d.hpp"
+#include "opencv2/video/tracking.hpp"
+#include "frame_tracker.hpp"
+#include "bill_stitching.hpp"
+
+using namespace std;
+using namespace cv;
+
+namespace {
+    const Size kWinSize(21, 21);
+    const int kMaxLevel = 3;
+    // Sai số RANSAC (px ở độ phân giải tracking) và khoảng cách tối thiểu giữa các góc
+    const double kRansacThreshold = 1.0;
+    const double kMinCornerDistance = 8;
+
+    // Tỉ lệ diện tích frame hiện tại (đã đưa về keyframe) nằm trong keyframe
+    double overlapFraction(const Size &size, const Mat &toKeyframe) {
+        vector<Point2f> corners = {Point2f(0, 0), Point2f(size.width, 0),
+                                   Point2f(size.width, size.height), Point2f(0, size.height)};
+        Mat M;
+        toKeyframe.rowRange(0, 2).convertTo(M, CV_32F);
+        transform(corners, corners, M);
+        vector<Point2f> frame = {Point2f(0, 0), Point2f(size.width, 0),
+                                 Point2f(size.width, size.height), Point2f(0, size.height)};
+        vector<Point2f> shared;
+        const float area = intersectConvexConvex(corners, frame, shared, true);
+        return std::max(0.f, area) / size.area();
+    }
+}
+
+cv::bill_stitching::FrameTracker::FrameTracker(const TrackerParams &params) : params_(params) {}
+
+void cv::bill_stitching::FrameTracker::reset() {
+    prevPyramid_.clear();
+    points_.clear();
+    toKeyframe_.release();
+}
+
+cv::bill_stitching::TrackResult
+cv::bill_stitching::FrameTracker::restart(const Mat &gray, vector<Mat> &pyramid, bool lost) {
+    points_.clear();
+    replenish(gray);
+    prevPyramid_.swap(pyramid);
+    toKeyframe_ = Mat::eye(3, 3, CV_64F);
+
+    // Không đo được chuyển động tới keyframe trước (frame đầu, đổi kích thước hoặc mất
+    // track): để trống toKeyframe thay vì trả về phép đồng nhất như thể frame đứng yên
+    TrackResult result;
+    result.keyframe = true;
+    result.lost = lost;
+    result.numTracks = static_cast<int>(points_.size());
+    return result;
+}
+
+cv::bill_stitching::TrackResult cv::bill_stitching::FrameTracker::track(const Mat &gray) {
+    CV_Assert(gray.type() == CV_8UC1);
+    vector<Mat> pyramid;
+    buildOpticalFlowPyramid(gray, pyramid, kWinSize, kMaxLevel);
+    if (prevPyramid_.empty() || prevPyramid_[0].size() != gray.size()) {
+        return restart(gray, pyramid, false);
+    }
+
+    vector<Point2f> next;
+    vector<uchar> status;
+    vector<float> err;
+    if (!points_.empty()) {
+        calcOpticalFlowPyrLK(prevPyramid_, pyramid, points_, next, status, err, kWinSize, kMaxLevel);
+    }
+    const Rect bounds(Point(), gray.size());
+    vector<Point2f> from, to;
+    for (size_t i = 0; i < next.size(); ++i) {
+        if (status[i] && bounds.contains(Point(cvFloor(next[i].x), cvFloor(next[i].y)))) {
+            from.push_back(points_[i]);
+            to.push_back(next[i]);
+        }
+    }
+    if (static_cast<int>(to.size()) < params_.minTracks) {
+        stitching_log("Tracker: lost (%lu tracks)\n", to.size());
+        return restart(gray, pyramid, true);
+    }
+
+    // Chuyển động frame hiện tại -> frame trước, chỉ giữ lại các track inlier
+    vector<uchar> inliers;
+    Mat M = estimateAffinePartial2D(to, from, inliers, RANSAC, kRansacThreshold);
+    if (M.empty()) {
+        stitching_log("Tracker: lost (no motion estimate)\n");
+        return restart(gray, pyramid, true);
+    }
+    points_.clear();
+    for (size_t i = 0; i < to.size(); ++i) {
+        if (inliers[i]) {
+            points_.push_back(to[i]);
+        }
+    }
+    if (static_cast<int>(points_.size()) < params_.minTracks) {
+        stitching_log("Tracker: lost (%lu inliers)\n", points_.size());
+        return restart(gray, pyramid, true);
+    }
+
+    Mat H = Mat::eye(3, 3, CV_64F);
+    M.copyTo(H.rowRange(0, 2));
+    toKeyframe_ = toKeyframe_ * H;
+
+    TrackResult result;
+    result.numTracks = static_cast<int>(points_.size());
+    result.overlap = overlapFraction(gray.size(), toKeyframe_);
+    result.toKeyframe = toKeyframe_.clone();
+    if (result.overlap < params_.keyframeOverlap) {
+        result.keyframe = true;
+        toKeyframe_ = Mat::eye(3, 3, CV_64F);
+    }
+    replenish(gray);
+    prevPyramid_.swap(pyramid);
+    return result;
+}
+
+void cv::bill_stitching::FrameTracker::replenish(const Mat &gray) {
+    const int cellW = std::max(1, gray.cols / params_.gridCols);
+    const int cellH = std::max(1, gray.rows / params_.gridRows);
+    vector<int> counts(params_.gridCols * params_.gridRows, 0);
+    for (const auto &p: points_) {
+        const int cx = std::min(params_.gridCols - 1, static_cast<int>(p.x) / cellW);
+        const int cy = std::min(params_.gridRows - 1, static_cast<int>(p.y) / cellH);
+        ++counts[cy * params_.gridCols + cx];
+    }
+
+    Mat mask;
+    for (int cy = 0; cy < params_.gridRows; ++cy) {
+        for (int cx = 0; cx < params_.gridCols; ++cx) {
+            const int have = counts[cy * params_.gridCols + cx];
+            if (2 * have >= params_.cornersPerCell) {
+                continue;
+            }
+            // Ô cuối cùng lấy luôn phần dư của ảnh
+            const Rect cell(cx * cellW, cy * cellH,
+                            cx == params_.gridCols - 1 ? gray.cols - cx * cellW : cellW,
+                            cy == params_.gridRows - 1 ? gray.rows - cy * cellH : cellH);
+            if (mask.empty()) {
+                // Không đặt góc mới sát các track còn sống
+                mask = Mat(gray.size(), CV_8U, Scalar(255));
+                for (const auto &p: points_) {
+                    circle(mask, p, cvRound(kMinCornerDistance), Scalar(0), FILLED);
+                }
+            }
+            vector<Point2f> corners;
+            goodFeaturesToTrack(gray(cell), corners, params_.cornersPerCell - have, 0.01,
+                                kMinCornerDistance, mask(cell));
+            for (const auto &c: corners) {
+                points_.push_back(c + Point2f(cell.tl()));
+            }
+        }
+    }
+}
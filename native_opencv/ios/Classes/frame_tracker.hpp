@@ -0,0 +1,55 @@
+#ifndef FRAME_TRACKER_HPP
+#define FRAME_TRACKER_HPP
+
+#include "opencv2/core/core.hpp"
+#include <vector>
+
+namespace cv {
+    namespace bill_stitching {
+        struct TrackerParams {
+            int gridCols = 6;
+            int gridRows = 8;
+            int cornersPerCell = 4;          // target tracked corners per grid cell
+            double keyframeOverlap = 0.6;    // emit a keyframe once overlap drops below this
+            int minTracks = 12;              // fewer surviving tracks means tracking is lost
+        };
+
+        struct TrackResult {
+            bool keyframe = false;
+            bool lost = false;               // tracking was lost and restarted
+            cv::Mat toKeyframe;              // 3x3 CV_64F, current frame into the last keyframe;
+                                             // empty after any restart (no motion measured)
+            double overlap = 1;              // area fraction shared with the last keyframe
+            int numTracks = 0;
+        };
+
+        // Theo dõi chuyển động giữa các frame preview liên tiếp (30 fps) bằng optical
+        // flow Lucas-Kanade dạng pyramid thay vì tìm lại features mỗi frame. Các góc
+        // được rải theo lưới và chỉ được bổ sung ở ô đã mất track; chuyển động từng frame
+        // là affine từng phần (xoay + tịnh tiến + tỉ lệ) được cộng dồn tới keyframe cuối.
+        // Khi phần chồng lấp với keyframe xuống dưới ngưỡng, frame hiện tại thành keyframe.
+        class FrameTracker {
+        public:
+            explicit FrameTracker(const TrackerParams &params = TrackerParams());
+
+            // `gray` is the CV_8U luma at tracking resolution; every call must use the same
+            // size. The first frame (and the frame after tracking is lost) is a keyframe.
+            TrackResult track(const cv::Mat &gray);
+
+            void reset();
+
+        private:
+            // Adds corners in grid cells that kept fewer than half their target tracks.
+            void replenish(const cv::Mat &gray);
+
+            TrackResult restart(const cv::Mat &gray, std::vector<cv::Mat> &pyramid, bool lost);
+
+            TrackerParams params_;
+            std::vector<cv::Mat> prevPyramid_;
+            std::vector<cv::Point2f> points_;
+            cv::Mat toKeyframe_;
+        };
+    }
+}
+
+#endif //FRAME_TRACKER_HPP
@@ -0,0 +1,307 @@
+#include "opencv2/opencv.hpp"
+#include "opencv2/core/hal/hal.hpp"
+#include "bill_stitching.hpp"
+#include "guided_matcher.hpp"
+#include "sequential_matcher.hpp"
+#include "stitch_control.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace std;
+using namespace cv;
+using namespace cv::detail;
+
+namespace {
+    const int kMinMatches = 6;                // như AffineBestOf2NearestMatcher
+    const double kReprojThresholdPx = 3.0;
+    // Prior giải thích được tỉ lệ này của các cặp thì bỏ qua bước lấy mẫu
+    const double kPriorInlierRatio = 0.8;
+    const int kMaxIters = 2000;
+    const double kEstimationConfidence = 0.995;
+    const int kRefineIters = 10;
+    const double kMinRadiusRatio = 0.04;      // of the longer frame side
+    const double kShiftUncertainty = 0.25;    // extra radius per px of predicted shift
+    // Ngoại suy xa hơn (ví dụ cặp cách nhiều frame) thì ghép toàn bộ
+    const double kMaxExtrapolation = 4.0;
+
+    // Keypoint của ảnh thứ hai xếp theo ô lưới (counting sort), ô vuông cạnh `cell` px
+    class KeypointGrid {
+    public:
+        KeypointGrid(const vector<KeyPoint> &keypoints, const Size &size, double cell)
+                : cell_(cell),
+                  cols_(std::max(1, static_cast<int>(std::ceil(size.width / cell)))),
+                  rows_(std::max(1, static_cast<int>(std::ceil(size.height / cell)))),
+                  start_(cols_ * rows_ + 1, 0), indices_(keypoints.size()) {
+            vector<int> cells(keypoints.size());
+            for (size_t i = 0; i < keypoints.size(); ++i) {
+                cells[i] = cellOf(keypoints[i].pt);
+                ++start_[cells[i] + 1];
+            }
+            for (size_t c = 1; c < start_.size(); ++c) {
+                start_[c] += start_[c - 1];
+            }
+            vector<int> next(start_.begin(), start_.end() - 1);
+            for (size_t i = 0; i < keypoints.size(); ++i) {
+                indices_[next[cells[i]]++] = static_cast<int>(i);
+            }
+        }
+
+        // Calls f(index) for every keypoint in the cells overlapping the square around `p`.
+        template<typename F>
+        void forEachNear(const Point2f &p, double radius, F f) const {
+            const int x0 = std::max(0, static_cast<int>(std::floor((p.x - radius) / cell_)));
+            const int x1 = std::min(cols_ - 1, static_cast<int>(std::floor((p.x + radius) / cell_)));
+            const int y0 = std::max(0, static_cast<int>(std::floor((p.y - radius) / cell_)));
+            const int y1 = std::min(rows_ - 1, static_cast<int>(std::floor((p.y + radius) / cell_)));
+            for (int y = y0; y <= y1; ++y) {
+                for (int x = x0; x <= x1; ++x) {
+                    const int c = y * cols_ + x;
+                    for (int k = start_[c]; k < start_[c + 1]; ++k) {
+                        f(indices_[k]);
+                    }
+                }
+            }
+        }
+
+    private:
+        int cellOf(const Point2f &p) const {
+            const int x = std::min(cols_ - 1, std::max(0, static_cast<int>(p.x / cell_)));
+            const int y = std::min(rows_ - 1, std::max(0, static_cast<int>(p.y / cell_)));
+            return y * cols_ + x;
+        }
+
+        double cell_;
+        int cols_, rows_;
+        vector<int> start_;
+        vector<int> indices_;
+    };
+
+    Point2f transformPoint(const Matx33d &M, const Point2f &p) {
+        return Point2f(static_cast<float>(M(0, 0) * p.x + M(0, 1) * p.y + M(0, 2)),
+                       static_cast<float>(M(1, 0) * p.x + M(1, 1) * p.y + M(1, 2)));
+    }
+
+    Mat toAffine3x3(const Mat &H) {
+        Mat M = Mat::eye(3, 3, CV_64F);
+        H.rowRange(0, 2).convertTo(M.rowRange(0, 2), CV_64F);
+        return M;
+    }
+
+    // Đánh dấu các cặp khớp với mô hình, trả về số inlier
+    int classify(const Matx33d &M, const vector<Point2f> &src, const vector<Point2f> &dst, vector<uchar> &mask) {
+        mask.assign(src.size(), 0);
+        int inliers = 0;
+        for (size_t k = 0; k < src.size(); ++k) {
+            const Point2f d = transformPoint(M, src[k]) - dst[k];
+            if (d.dot(d) <= kReprojThresholdPx * kReprojThresholdPx) {
+                mask[k] = 1;
+                ++inliers;
+            }
+        }
+        return inliers;
+    }
+
+    // Affine từng phần trên tập inlier: gần như không còn outlier nên RANSAC dừng sau
+    // vài lần lấy mẫu, phần còn lại là Levenberg-Marquardt
+    Mat refitPartial(const vector<Point2f> &src, const vector<Point2f> &dst, const vector<uchar> &mask) {
+        vector<Point2f> in, out;
+        for (size_t k = 0; k < src.size(); ++k) {
+            if (mask[k]) {
+                in.push_back(src[k]);
+                out.push_back(dst[k]);
+            }
+        }
+        if (static_cast<int>(in.size()) < kMinMatches) {
+            return Mat();
+        }
+        return estimateAffinePartial2D(in, out, noArray(), RANSAC, kReprojThresholdPx, 50, 0.99, kRefineIters);
+    }
+}
+
+cv::bill_stitching::GuidedMatcher::GuidedMatcher(const Ptr<FeaturesMatcher> &fallback, double matchConf,
+                                                 double confThresh)
+        : FeaturesMatcher(false), fallback_(fallback), matchConf_(static_cast<float>(matchConf)),
+          confThresh_(confThresh) {}
+
+void cv::bill_stitching::GuidedMatcher::recordMotion(int from, int to, const Mat &fromTo) {
+    if (fromTo.empty() || from == to) {
+        return;
+    }
+    Mat M = toAffine3x3(fromTo);
+    if (from > to) {
+        M = M.inv();
+        std::swap(from, to);
+    }
+    lastFrom_ = from;
+    lastTo_ = to;
+    lastMotion_ = M;
+}
+
+void cv::bill_stitching::GuidedMatcher::collectGarbage() {
+    if (guidedPairs_ + fallbackPairs_ > 0) {
+        stitching_log("Guided matcher: %d guided, %d exhaustive pairs\n", guidedPairs_, fallbackPairs_);
+    }
+    guidedPairs_ = 0;
+    fallbackPairs_ = 0;
+    lastFrom_ = lastTo_ = -1;
+    lastMotion_.release();
+    fallback_->collectGarbage();
+}
+
+bool cv::bill_stitching::GuidedMatcher::predict(int from, int to, const Size &size, Mat &H, double &radius) const {
+    if (lastMotion_.empty() || from < 0 || to <= from) {
+        return false;
+    }
+    // Khoảng thời gian giữa hai lần chụp nếu biết cả bốn timestamp, ngược lại coi các
+    // frame cách đều nhau
+    auto timed = [&](int index) {
+        return index < static_cast<int>(timestampsUs_.size()) && timestampsUs_[index] > 0;
+    };
+    double lastSpan = lastTo_ - lastFrom_, pairSpan = to - from;
+    if (timed(from) && timed(to) && timed(lastFrom_) && timed(lastTo_)) {
+        const double lastTime = static_cast<double>(timestampsUs_[lastTo_] - timestampsUs_[lastFrom_]);
+        const double pairTime = static_cast<double>(timestampsUs_[to] - timestampsUs_[from]);
+        // Timestamp trùng nhau (độ phân giải đồng hồ thô) hoặc lùi lại: giữ khoảng theo chỉ số
+        if (lastTime > 0 && pairTime > 0) {
+            lastSpan = lastTime;
+            pairSpan = pairTime;
+        }
+    }
+    if (!(lastSpan > 0) || !(pairSpan > 0) || pairSpan / lastSpan > kMaxExtrapolation) {
+        return false;
+    }
+
+    // Vận tốc không đổi: độ lệch của phép biến đổi so với đồng nhất tỉ lệ theo thời gian
+    const double r = pairSpan / lastSpan;
+    H = Mat::eye(3, 3, CV_64F);
+    for (int i = 0; i < 2; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            H.at<double>(i, j) += (lastMotion_.at<double>(i, j) - H.at<double>(i, j)) * r;
+        }
+    }
+    const Point2f center(size.width * 0.5f, size.height * 0.5f);
+    const double shift = norm(transformPoint(Matx33d(H), center) - center);
+    radius = std::max(kMinRadiusRatio * std::max(size.width, size.height), kShiftUncertainty * shift);
+    return true;
+}
+
+void cv::bill_stitching::GuidedMatcher::matchGuided(const ImageFeatures &features1,
+                                                    const ImageFeatures &features2,
+                                                    const Mat &H, double radius, MatchesInfo &info) const {
+    const Mat d1 = features1.descriptors.getMat(ACCESS_READ);
+    const Mat d2 = features2.descriptors.getMat(ACCESS_READ);
+    const bool binary = d1.type() == CV_8U;
+    if (!(radius > 0) || d1.empty() || d2.empty() || d1.type() != d2.type() || d1.cols != d2.cols ||
+        (!binary && d1.type() != CV_32F)) {
+        return;
+    }
+    auto distance = [&](int q, int t) {
+        return binary ? static_cast<float>(hal::normHamming(d1.ptr<uchar>(q), d2.ptr<uchar>(t), d1.cols))
+                      : std::sqrt(hal::normL2Sqr_(d1.ptr<float>(q), d2.ptr<float>(t), d1.cols));
+    };
+
+    // 2-NN trong cửa sổ quanh vị trí dự đoán, ratio test như BestOf2NearestMatcher, rồi
+    // chỉ giữ cặp mà query cũng là láng giềng gần nhất của train
+    const Matx33d M(H);
+    const KeypointGrid grid(features2.keypoints, features2.img_size, radius);
+    const float radius2 = static_cast<float>(radius * radius);
+    vector<pair<float, int>> bestQuery(features2.keypoints.size(), make_pair(FLT_MAX, -1));
+    vector<DMatch> candidates;
+    for (int q = 0; q < static_cast<int>(features1.keypoints.size()); ++q) {
+        const Point2f predicted = transformPoint(M, features1.keypoints[q].pt);
+        DMatch best(q, -1, FLT_MAX);
+        float second = FLT_MAX;
+        grid.forEachNear(predicted, radius, [&](int t) {
+            const Point2f d = features2.keypoints[t].pt - predicted;
+            if (d.dot(d) > radius2) {
+                return;
+            }
+            const float dist = distance(q, t);
+            if (dist < best.distance) {
+                second = best.distance;
+                best.trainIdx = t;
+                best.distance = dist;
+            } else if (dist < second) {
+                second = dist;
+            }
+        });
+        if (best.trainIdx < 0 || (second < FLT_MAX && best.distance >= (1.f - matchConf_) * second)) {
+            continue;
+        }
+        candidates.push_back(best);
+        if (best.distance < bestQuery[best.trainIdx].first) {
+            bestQuery[best.trainIdx] = make_pair(best.distance, q);
+        }
+    }
+    for (const auto &m: candidates) {
+        if (bestQuery[m.trainIdx].second == m.queryIdx) {
+            info.matches.push_back(m);
+        }
+    }
+    if (static_cast<int>(info.matches.size()) < kMinMatches) {
+        return;
+    }
+
+    vector<Point2f> src, dst;
+    src.reserve(info.matches.size());
+    dst.reserve(info.matches.size());
+    for (const auto &m: info.matches) {
+        src.push_back(features1.keypoints[m.queryIdx].pt);
+        dst.push_back(features2.keypoints[m.trainIdx].pt);
+    }
+    // Prior đã giải thích gần hết các cặp: chỉ làm mịn trên inlier của nó. Ngược lại
+    // MAGSAC++ (USAC), dừng sớm khi tỉ lệ inlier cao như thường thấy sau bước có hướng dẫn.
+    vector<uchar> mask;
+    Mat A;
+    if (classify(M, src, dst, mask) >= kPriorInlierRatio * src.size()) {
+        A = refitPartial(src, dst, mask);
+    } else if (!estimateAffine2D(src, dst, mask, USAC_MAGSAC, kReprojThresholdPx, kMaxIters,
+                                 kEstimationConfidence, kRefineIters).empty()) {
+        // Mô hình cuối vẫn là affine từng phần như AffineBestOf2NearestMatcher(false)
+        A = refitPartial(src, dst, mask);
+    }
+    if (A.empty()) {
+        return;
+    }
+    info.H = toAffine3x3(A);
+    info.num_inliers = classify(Matx33d(info.H), src, dst, info.inliers_mask);
+    // Cùng hệ số với matcher của OpenCV (Brown & Lowe)
+    info.confidence = info.num_inliers / (8 + 0.3 * info.matches.size());
+}
+
+void cv::bill_stitching::GuidedMatcher::match(const ImageFeatures &features1, const ImageFeatures &features2,
+                                              MatchesInfo &matches_info) {
+    matches_info = MatchesInfo();
+    Mat H;
+    double radius = 0;
+    bool guided = predict(features1.img_idx, features2.img_idx, features1.img_size, H, radius);
+    if (guided) {
+        matchGuided(features1, features2, H, radius, matches_info);
+        // Prior sai (đổi tốc độ quét, khớp nhầm ở cặp trước): ghép lại toàn bộ
+        guided = matches_info.confidence >= confThresh_;
+    }
+    if (guided) {
+        ++guidedPairs_;
+    } else {
+        matches_info = MatchesInfo();
+        (*fallback_)(features1, features2, matches_info);
+        ++fallbackPairs_;
+    }
+    if (matches_info.confidence >= confThresh_ && !matches_info.H.empty()) {
+        recordMotion(features1.img_idx, features2.img_idx, matches_info.H);
+    }
+}
+
+void cv::bill_stitching::setMatchTimestamps(const Ptr<Stitcher> &stitcher, const vector<int64> &timestampsUs) {
+    Ptr<FeaturesMatcher> matcher = stitcher->featuresMatcher();
+    if (auto sequential = matcher.dynamicCast<SequentialMatcher>()) {
+        matcher = sequential->inner();
+    }
+    if (auto controlled = matcher.dynamicCast<ControlledMatcher>()) {
+        matcher = controlled->inner();
+    }
+    if (auto guided = matcher.dynamicCast<GuidedMatcher>()) {
+        guided->setTimestamps(timestampsUs);
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef GUIDED_MATCHER_HPP
+#define GUIDED_MATCHER_HPP
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/stitching.hpp"
+#include "opencv2/stitching/detail/matchers.hpp"
+#include <vector>
+
+namespace cv {
+    namespace bill_stitching {
+        // Ghép cặp có hướng dẫn theo chuyển động: khi quét đều tay, phép biến đổi của cặp
+        // trước (nội suy theo khoảng thời gian giữa hai lần chụp) dự đoán rất sát vị trí
+        // của mỗi keypoint trong ảnh kia. Mỗi keypoint chỉ được so descriptor với các
+        // keypoint trong cửa sổ quanh vị trí dự đoán (lưới không gian), thay vì với mọi
+        // keypoint. Ước lượng bền vững: nếu prior đã giải thích gần hết các cặp thì chỉ
+        // làm mịn trên inlier của nó, ngược lại dùng USAC_MAGSAC (dừng sớm theo tỉ lệ
+        // inlier). Mô hình cuối là affine từng phần (4 bậc tự do) như
+        // AffineBestOf2NearestMatcher, với cùng cách tính confidence.
+        //
+        // Cặp không có prior, hoặc kết quả có hướng dẫn yếu, được ghép lại bằng `fallback`
+        // (ghép toàn bộ). Matcher giữ trạng thái giữa các cặp nên không thread-safe: các
+        // cặp (i, j), i < j, được ghép theo thứ tự và mỗi kết quả đạt `confThresh` trở
+        // thành prior của cặp sau. collectGarbage() xoá trạng thái.
+        class GuidedMatcher : public cv::detail::FeaturesMatcher {
+        public:
+            GuidedMatcher(const cv::Ptr<cv::detail::FeaturesMatcher> &fallback, double matchConf,
+                          double confThresh);
+
+            // Capture times by image index (img_idx); empty = evenly spaced frames.
+            void setTimestamps(const std::vector<int64> &timestampsUs) { timestampsUs_ = timestampsUs; }
+
+            // Chuyển động của một cặp đã đăng ký bằng cách khác (ví dụ phase correlation):
+            // `fromTo` (3x3) đưa điểm của ảnh `from` sang ảnh `to`.
+            void recordMotion(int from, int to, const cv::Mat &fromTo);
+
+            void collectGarbage() CV_OVERRIDE;
+
+        protected:
+            using FeaturesMatcher::match;
+
+            void match(const cv::detail::ImageFeatures &features1,
+                       const cv::detail::ImageFeatures &features2,
+                       cv::detail::MatchesInfo &matches_info) CV_OVERRIDE;
+
+        private:
+            // Predicted 3x3 transform from image `from` into image `to` and the search radius.
+            bool predict(int from, int to, const cv::Size &size, cv::Mat &H, double &radius) const;
+
+            void matchGuided(const cv::detail::ImageFeatures &features1,
+                             const cv::detail::ImageFeatures &features2,
+                             const cv::Mat &H, double radius, cv::detail::MatchesInfo &info) const;
+
+            cv::Ptr<cv::detail::FeaturesMatcher> fallback_;
+            float matchConf_;
+            double confThresh_;
+            std::vector<int64> timestampsUs_;
+            int lastFrom_ = -1;
+            int lastTo_ = -1;
+            cv::Mat lastMotion_;        // 3x3 CV_64F, lastFrom_ -> lastTo_
+            int guidedPairs_ = 0;
+            int fallbackPairs_ = 0;
+        };
+
+        // Gives the GuidedMatcher inside `stitcher` (under SequentialMatcher and
+        // ControlledMatcher) the capture times of the images about to be stitched.
+        void setMatchTimestamps(const cv::Ptr<cv::Stitcher> &stitcher, const std::vector<int64> &timestampsUs);
+    }
+}
+
+#endif //GUIDED_MATCHER_HPP
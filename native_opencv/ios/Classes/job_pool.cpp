@@ -0,0 +1,98 @@
+#include "job_pool.hpp"
+#include "bill_stitching.hpp"
+
+using namespace std;
+using namespace cv;
+
+cv::bill_stitching::JobPool &cv::bill_stitching::JobPool::instance() {
+    // Một nửa số core cho pool, phần còn lại để OpenCV song song hoá bên trong mỗi job
+    static JobPool pool(std::max(2, static_cast<int>(std::thread::hardware_concurrency()) / 2));
+    return pool;
+}
+
+cv::bill_stitching::JobPool::JobPool(int numThreads) {
+    numThreads = std::max(2, numThreads);
+    workers_.reserve(numThreads);
+    for (int i = 0; i < numThreads; ++i) {
+        workers_.emplace_back(&JobPool::workerLoop, this, i);
+    }
+    stitching_log("Job pool started with %d workers\n", numThreads);
+}
+
+cv::bill_stitching::JobPool::~JobPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    queueChanged_.notify_all();
+    for (auto &worker: workers_) {
+        worker.join();
+    }
+}
+
+int64_t cv::bill_stitching::JobPool::submit(JobPriority priority, Work work, ProgressCallback progress) {
+    int64_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = nextId_++;
+        auto control = std::make_shared<StitchControl>(id, progress);
+        controls_[id] = control;
+        auto &queue = priority == JOB_PRIORITY_INTERACTIVE ? interactive_ : background_;
+        queue.push_back(Job{id, std::move(work), control});
+    }
+    queueChanged_.notify_all();
+    return id;
+}
+
+void cv::bill_stitching::JobPool::cancel(int64_t jobId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = controls_.find(jobId);
+    if (it != controls_.end()) {
+        it->second->cancel();
+    }
+}
+
+void cv::bill_stitching::JobPool::workerLoop(int index) {
+    WorkerContext context;
+    context.index = index;
+    // Worker 0 được dành riêng cho các job interactive
+    const bool interactiveOnly = index == 0;
+
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            queueChanged_.wait(lock, [&] {
+                return stopping_ || !interactive_.empty() ||
+                       (!interactiveOnly && !background_.empty());
+            });
+            if (stopping_) {
+                return;
+            }
+            auto &queue = !interactive_.empty() ? interactive_ : background_;
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        int64 start = getTickCount();
+        context.jobId = job.id;
+        context.control = job.control.get();
+        try {
+            job.work(context);
+        } catch (const StitchCancelled &) {
+            stitching_log("Job %lld cancelled\n", (long long) job.id);
+        } catch (const cv::Exception &e) {
+            stitching_log("Job %lld: OpenCV error: %s\n", (long long) job.id, e.what());
+        } catch (const std::exception &e) {
+            stitching_log("Job %lld: error: %s\n", (long long) job.id, e.what());
+        } catch (...) {
+            stitching_log("Job %lld: unknown error\n", (long long) job.id);
+        }
+        stitching_log("Job %lld finished on worker %d in %.0f ms\n", (long long) job.id, index,
+                      (getTickCount() - start) * 1000.0 / getTickFrequency());
+
+        context.control = nullptr;
+        std::lock_guard<std::mutex> lock(mutex_);
+        controls_.erase(job.id);
+    }
+}
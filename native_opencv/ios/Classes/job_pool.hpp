@@ -0,0 +1,90 @@
+#ifndef JOB_POOL_HPP
+#define JOB_POOL_HPP
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/stitching.hpp"
+#include "stitch_config.hpp"
+#include "stitch_control.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cv {
+    namespace bill_stitching {
+        enum JobStatus {
+            JOB_OK = 0,
+            JOB_FAILED = 1,
+            JOB_CANCELLED = 2,
+        };
+
+        enum JobPriority {
+            JOB_PRIORITY_INTERACTIVE = 0,   // preview, user is waiting
+            JOB_PRIORITY_BACKGROUND = 1,    // final composites, batch re-exports
+        };
+
+        // Đối tượng sống cùng worker thread, được tạo một lần và dùng lại cho mọi job
+        // (tránh Stitcher::create / ORB::create cho mỗi lần ghép).
+        struct WorkerContext {
+            int index = 0;
+            int64_t jobId = 0;              // job currently running on this worker
+            const StitchControl *control = nullptr;
+            cv::Ptr<cv::Stitcher> stitcher;
+            StitchConfig stitcherConfig = defaultStitchConfig();   // setup `stitcher` was built with
+        };
+
+        // Completion is reported from a worker thread, e.g. to a Dart
+        // NativeCallable.listener. `result` ownership passes to the receiver.
+        typedef void (*JobCompletionCallback)(int64_t jobId, int32_t status, void *result);
+
+        // Pool cố định các worker thread với hàng đợi hai mức ưu tiên. Worker đầu tiên
+        // chỉ nhận job interactive để preview không phải chờ các job nền chạy lâu.
+        class JobPool {
+        public:
+            typedef std::function<void(WorkerContext &)> Work;
+
+            static JobPool &instance();
+
+            explicit JobPool(int numThreads);
+
+            ~JobPool();
+
+            JobPool(const JobPool &) = delete;
+
+            JobPool &operator=(const JobPool &) = delete;
+
+            // Non-blocking. Returns the id of the queued job. `work` must report its own
+            // completion: exceptions escaping it are only logged.
+            int64_t submit(JobPriority priority, Work work, ProgressCallback progress = nullptr);
+
+            // Cancels a queued or running job. A queued job still runs, but stops at
+            // its first checkpoint and reports JOB_CANCELLED.
+            void cancel(int64_t jobId);
+
+        private:
+            struct Job {
+                int64_t id;
+                Work work;
+                std::shared_ptr<StitchControl> control;
+            };
+
+            void workerLoop(int index);
+
+            std::deque<Job> interactive_;
+            std::deque<Job> background_;
+            std::map<int64_t, std::shared_ptr<StitchControl>> controls_;
+            int64_t nextId_ = 1;
+            bool stopping_ = false;
+            std::mutex mutex_;
+            std::condition_variable queueChanged_;
+            std::vector<std::thread> workers_;
+        };
+    }
+}
+
+#endif //JOB_POOL_HPP
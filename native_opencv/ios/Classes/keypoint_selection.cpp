@@ -0,0 +1,159 @@
+#include "keypoint_selection.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+using namespace std;
+using namespace cv;
+
+namespace {
+    // Số vòng tìm nhị phân bán kính cho ANMS
+    const int kAnmsIterations = 16;
+
+    // Spatial hash với ô vuông cạnh `radius`
+    class SpatialHash {
+    public:
+        SpatialHash(float radius, size_t expected) : radius_(radius), cellSize_(std::max(radius, 1e-3f)) {
+            cells_.reserve(expected);
+        }
+
+        // Returns true if no kept point lies within `radius` of `pt`.
+        bool isFree(const Point2f &pt, const vector<KeyPoint> &keypoints) const {
+            const int cx = cellOf(pt.x), cy = cellOf(pt.y);
+            const float radiusSq = radius_ * radius_;
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    auto it = cells_.find(key(cx + dx, cy + dy));
+                    if (it == cells_.end()) {
+                        continue;
+                    }
+                    for (int index: it->second) {
+                        Point2f d = keypoints[index].pt - pt;
+                        if (d.x * d.x + d.y * d.y < radiusSq) {
+                            return false;
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+
+        void insert(int index, const Point2f &pt) {
+            cells_[key(cellOf(pt.x), cellOf(pt.y))].push_back(index);
+        }
+
+    private:
+        int cellOf(float v) const { return static_cast<int>(std::floor(v / cellSize_)); }
+
+        static int64 key(int cx, int cy) {
+            return (static_cast<int64>(cx) << 32) ^ static_cast<uint32_t>(cy);
+        }
+
+        float radius_;
+        float cellSize_;
+        std::unordered_map<int64, vector<int>> cells_;
+    };
+
+    // Giữ điểm mạnh nhất trước, bỏ các điểm cách điểm đã giữ ít hơn `radius`.
+    // Dừng sớm khi đã giữ quá `limit` điểm (dùng khi tìm nhị phân).
+    vector<int> suppress(const vector<KeyPoint> &keypoints, const vector<int> &byResponse, float radius,
+                         size_t limit) {
+        vector<int> kept;
+        if (radius <= 0) {
+            kept = byResponse;
+            return kept;
+        }
+        SpatialHash hash(radius, byResponse.size());
+        for (int index: byResponse) {
+            const Point2f &pt = keypoints[index].pt;
+            if (hash.isFree(pt, keypoints)) {
+                hash.insert(index, pt);
+                kept.push_back(index);
+                if (kept.size() > limit) {
+                    break;
+                }
+            }
+        }
+        return kept;
+    }
+}
+
+vector<int> cv::bill_stitching::selectKeypoints(const vector<KeyPoint> &keypoints,
+                                                const KeypointSelection &selection) {
+    vector<int> byResponse(keypoints.size());
+    std::iota(byResponse.begin(), byResponse.end(), 0);
+    std::stable_sort(byResponse.begin(), byResponse.end(), [&](int a, int b) {
+        return keypoints[a].response > keypoints[b].response;
+    });
+
+    vector<int> kept = suppress(keypoints, byResponse, selection.dedupRadius, keypoints.size());
+
+    const size_t target = static_cast<size_t>(std::max(0, selection.targetCount));
+    if (target > 0 && kept.size() > target) {
+        // Tìm bán kính lớn nhất vẫn giữ được ít nhất `target` điểm
+        Point2f tl(FLT_MAX, FLT_MAX), br(-FLT_MAX, -FLT_MAX);
+        for (int index: kept) {
+            const Point2f &pt = keypoints[index].pt;
+            tl = Point2f(std::min(tl.x, pt.x), std::min(tl.y, pt.y));
+            br = Point2f(std::max(br.x, pt.x), std::max(br.y, pt.y));
+        }
+        float lo = std::max(selection.dedupRadius, 0.f);
+        float hi = std::max(br.x - tl.x, br.y - tl.y);
+        vector<int> best = kept;
+        for (int i = 0; i < kAnmsIterations && hi - lo > 0.5f; ++i) {
+            const float mid = 0.5f * (lo + hi);
+            vector<int> candidate = suppress(keypoints, kept, mid, target);
+            if (candidate.size() >= target) {
+                best.swap(candidate);
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        kept.swap(best);
+        // Các điểm được giữ theo thứ tự response nên chỉ cần cắt bớt phần dư
+        if (kept.size() > target) {
+            kept.resize(target);
+        }
+    }
+
+    std::sort(kept.begin(), kept.end());
+    return kept;
+}
+
+void cv::bill_stitching::applySelection(const vector<int> &indices, vector<KeyPoint> &keypoints,
+                                        OutputArray descriptors) {
+    vector<KeyPoint> selected;
+    selected.reserve(indices.size());
+    for (int index: indices) {
+        selected.push_back(keypoints[index]);
+    }
+    keypoints.swap(selected);
+
+    if (!descriptors.needed() || descriptors.empty()) {
+        return;
+    }
+    Mat rows;
+    {
+        // Descriptor của cv::Stitcher là UMat: phải bỏ ánh xạ trước khi gán lại
+        Mat all = descriptors.getMat();
+        rows.create(static_cast<int>(indices.size()), all.cols, all.type());
+        for (size_t i = 0; i < indices.size(); ++i) {
+            all.row(indices[i]).copyTo(rows.row(static_cast<int>(i)));
+        }
+    }
+    descriptors.assign(rows);
+}
+
+void cv::bill_stitching::SelectiveFeatures::detectAndCompute(InputArray image, InputArray mask,
+                                                             vector<KeyPoint> &keypoints,
+                                                             OutputArray descriptors,
+                                                             bool useProvidedKeypoints) {
+    finder_->detectAndCompute(image, mask, keypoints, descriptors, useProvidedKeypoints);
+    // Feature2D::compute() truyền các keypoint đã chọn ở lần detect() trước
+    if (!useProvidedKeypoints) {
+        applySelection(selectKeypoints(keypoints, selection_), keypoints, descriptors);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef KEYPOINT_SELECTION_HPP
+#define KEYPOINT_SELECTION_HPP
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/features2d.hpp"
+#include <vector>
+
+namespace cv {
+    namespace bill_stitching {
+        struct KeypointSelection {
+            float dedupRadius = 0;   // drop points closer than this to a stronger one (0 = off)
+            int targetCount = 0;     // adaptive non-maximal suppression target (0 = off)
+        };
+
+        // Chọn keypoint theo thứ tự response giảm dần trên một spatial hash có kích thước
+        // ô bằng bán kính, nên mỗi điểm chỉ so với các điểm trong 3x3 ô lân cận.
+        //
+        // dedupRadius loại các điểm trùng lặp quanh điểm mạnh hơn. targetCount bật ANMS:
+        // tìm nhị phân bán kính triệt tiêu lớn nhất vẫn giữ đủ targetCount điểm, để các
+        // điểm được rải đều trên ảnh thay vì dồn vào vùng nhiều chữ. Độ phức tạp gần
+        // tuyến tính (O(n log n) cho ANMS). Trả về chỉ số các điểm được giữ, tăng dần.
+        std::vector<int> selectKeypoints(const std::vector<cv::KeyPoint> &keypoints,
+                                         const KeypointSelection &selection);
+
+        // Giữ lại các keypoint đã chọn cùng với đúng các dòng descriptor tương ứng.
+        void applySelection(const std::vector<int> &indices, std::vector<cv::KeyPoint> &keypoints,
+                            cv::OutputArray descriptors);
+
+        // Feature2D bọc một detector và áp dụng selectKeypoints cho kết quả, để dùng được
+        // cả trong cv::Stitcher lẫn các engine tự viết.
+        class SelectiveFeatures : public cv::Feature2D {
+        public:
+            SelectiveFeatures(const cv::Ptr<cv::Feature2D> &finder, const KeypointSelection &selection)
+                    : finder_(finder), selection_(selection) {}
+
+            void detectAndCompute(cv::InputArray image, cv::InputArray mask,
+                                  std::vector<cv::KeyPoint> &keypoints, cv::OutputArray descriptors,
+                                  bool useProvidedKeypoints) CV_OVERRIDE;
+
+            int descriptorSize() const CV_OVERRIDE { return finder_->descriptorSize(); }
+
+            int descriptorType() const CV_OVERRIDE { return finder_->descriptorType(); }
+
+            int defaultNorm() const CV_OVERRIDE { return finder_->defaultNorm(); }
+
+            bool empty() const CV_OVERRIDE { return finder_->empty(); }
+
+            cv::String getDefaultName() const CV_OVERRIDE { return finder_->getDefaultName(); }
+
+        private:
+            cv::Ptr<cv::Feature2D> finder_;
+            KeypointSelection selection_;
+        };
+    }
+}
+
+#endif //KEYPOINT_SELECTION_HPP
@@ -2,7 +2,25 @@
 #include "chrono"
 #include "vector"
 #include "bill_stitching.hpp"
+#include "feature_benchmark.hpp"
+#include "feature_cache.hpp"
+#include "frame_culling.hpp"
+#include "frame_order.hpp"
+#include "frame_quality.hpp"
+#include "guided_matcher.hpp"
+#include "native_opencv.hpp"
+#include "job_pool.hpp"
+#include "keypoint_selection.hpp"
+#include "registration_store.hpp"
+#include "sequential_matcher.hpp"
+#include "stitch_config.hpp"
+#include "stitch_control.hpp"
+#include "stitch_result.hpp"
+#include "scan_guidance.hpp"
+#include "stitch_session.hpp"
+#include "tiled_canvas.hpp"
 #include <algorithm>
+#include <atomic>
 #include <ctime>
 #include <string>
 
@@ -31,56 +49,6 @@ void platform_log(const char *fmt, ...) {
     va_end(args);
 }
 
-// Hàm so sánh để sắp xếp tên file theo thứ tự số tự nhiên
-bool compareNatural(const std::string &a, const std::string &b) {
-    // Tìm vị trí của dấu '/' cuối cùng trong đường dẫn
-    size_t aSlashPos = a.find_last_of('/');
-    size_t bSlashPos = b.find_last_of('/');
-
-    // Lấy tên file từ đường dẫn
-    std::string aFileName = a.substr(aSlashPos + 1);
-    std::string bFileName = b.substr(bSlashPos + 1);
-
-    std::string aNumber, bNumber;
-    size_t aPos = 0, bPos = 0;
-
-    while (aPos < aFileName.size() || bPos < bFileName.size()) {
-        // Lấy phần số từ vị trí hiện tại đến khi gặp ký tự không phải số
-        while (aPos < aFileName.size() && std::isdigit(aFileName[aPos])) {
-            aNumber += aFileName[aPos++];
-        }
-        while (bPos < bFileName.size() && std::isdigit(bFileName[bPos])) {
-            bNumber += bFileName[bPos++];
-        }
-
-        // So sánh phần số
-        if (!aNumber.empty() && !bNumber.empty()) {
-            if (std::stoi(aNumber) != std::stoi(bNumber)) {
-                return std::stoi(aNumber) < std::stoi(bNumber);
-            }
-        } else if (!aNumber.empty()) { // a có số, b không có số
-            return true;
-        } else if (!bNumber.empty()) { // b có số, a không có số
-            return false;
-        }
-
-        // Reset phần số
-        aNumber.clear();
-        bNumber.clear();
-
-        // Chỉ tăng aPos hoặc bPos nếu chưa đến cuối chuỗi
-        if (aPos < aFileName.size()) {
-            aPos++;
-        }
-        if (bPos < bFileName.size()) {
-            bPos++;
-        }
-    }
-
-    // Nếu tất cả các phần số đều bằng nhau, so sánh độ dài chuỗi
-    return aFileName.size() < bFileName.size();
-}
-
 Mat preprocess(Mat img) {
     platform_log("Bắt đầu tiền xử lý ảnh...\n");
     // 1. Cân bằng sáng (CLAHE)
@@ -106,63 +74,326 @@ Mat preprocess(Mat img) {
     return img;
 }
 
-extern "C" {
-const char *version() {
-    return CV_VERSION;
+// Chọn hệ số giảm lớn nhất (8, 4, 2) mà vẫn giữ ảnh giải mã >= độ phân giải làm việc,
+// để JPEG được giải mã thẳng ở kích thước nhỏ (trong miền DCT) thay vì full-res
+static void reduced_decode_mode(double scale, int &flags, int &factor) {
+    static const int kFactors[] = {8, 4, 2};
+    static const int kFlags[] = {IMREAD_REDUCED_COLOR_8, IMREAD_REDUCED_COLOR_4, IMREAD_REDUCED_COLOR_2};
+    for (int i = 0; i < 3; ++i) {
+        if (1.0 / kFactors[i] >= scale) {
+            flags = kFlags[i];
+            factor = kFactors[i];
+            return;
+        }
+    }
+    flags = IMREAD_COLOR;
+    factor = 1;
 }
 
-void stitch_images(const char **imagePaths, int numImages, char *outputImagePath) {
+Mat load_work_image(const std::string &imagePath, double workScale) {
+    int flags, factor;
+    reduced_decode_mode(workScale, flags, factor);
+    cv::Mat img = cv::imread(imagePath, flags);
+    platform_log("Đã tải hình ảnh tại đường dẫn: %s\n", imagePath.c_str());
+    if (img.empty()) {
+        platform_log("Không thể tải hình ảnh tại đường dẫn: %s\n", imagePath.c_str());
+        return img;
+    }
+    Mat resized;
+    platform_log("Kích thước ảnh giải mã (1/%d): %dx%d\n", factor, img.cols, img.rows);
+    // Phần còn lại của tỉ lệ sau khi đã giảm lúc giải mã
+    const double remaining = workScale * factor;
+    resize(img, resized, Size(), remaining, remaining, INTER_AREA);
+    platform_log("Kích thước ảnh sau khi giảm: %dx%d\n", resized.cols, resized.rows);
+    return resized;
+}
 
-    std::vector<std::string> imagePathsVector(imagePaths, imagePaths + numImages);
+Mat load_image(const std::string &imagePath) {
+    Mat img = load_work_image(imagePath);
+    // Tiền xử lý ảnh
+    return img.empty() ? img : preprocess(img);
+}
+
+// Khởi tạo Stitcher với cấu hình dùng cho bill (config đã được kiểm tra). Worker trong
+// job pool giữ lại đối tượng này giữa các job thay vì tạo mới mỗi lần ghép.
+Ptr<Stitcher> create_stitcher(const bill_stitching::StitchConfig &config) {
+    // 1. Khởi tạo Stitcher
+    Ptr<Stitcher> stitcher = Stitcher::create(Stitcher::SCANS);
+    // 2. Tùy chỉnh các tham số
+    stitcher->setRegistrationResol(config.registrationMegapix);
+    stitcher->setSeamEstimationResol(config.seamMegapix);
+    stitcher->setCompositingResol(config.composeMegapix);
+    stitcher->setPanoConfidenceThresh(config.panoConfidenceThresh);  // Tăng lên để loại bỏ ghép nối sai
+    stitcher->setFeaturesFinder(bill_stitching::createDetector(config));
+    // Rải đều features bằng ANMS: ORB dồn điểm vào các vùng chữ dày đặc
+    const bill_stitching::KeypointSelection selection{2.0f, config.maxFeatures};
+    stitcher->setFeaturesFinder(makePtr<bill_stitching::SelectiveFeatures>(stitcher->featuresFinder(), selection));
+    // Ảnh đã tìm features với cùng tham số được đọc lại từ cache thay vì tìm lại
+    stitcher->setFeaturesFinder(makePtr<bill_stitching::CachedFeatures>(
+            stitcher->featuresFinder(), bill_stitching::featureSignature(config, selection)));
+    // Ghép có hướng dẫn theo chuyển động của cặp trước, cặp chưa có prior thì ghép toàn bộ
+    stitcher->setFeaturesMatcher(makePtr<bill_stitching::GuidedMatcher>(
+            makePtr<AffineBestOf2NearestMatcher>(false, false, static_cast<float>(config.matchConfidence)),
+            config.matchConfidence, config.panoConfidenceThresh));
+    // Bỏ qua ExposureCompensator vì ánh sáng khi scan thường đồng đều
+    // stitcher->setExposureCompensator(ExposureCompensator::createDefault(ExposureCompensator::GAIN_BLOCKS));
+    stitcher->setBlender(bill_stitching::createBlender(config));
+    // Bọc các stage để báo tiến độ và cho phép huỷ giữa chừng
+    bill_stitching::wrapStitcherStages(stitcher);
+    // Chỉ ghép các ảnh lân cận theo thứ tự chụp thay vì mọi cặp ảnh (O(n) thay vì O(n²)),
+    // cặp nào không đạt ngưỡng tin cậy thì thử lại với cửa sổ rộng hơn
+    stitcher->setFeaturesMatcher(makePtr<bill_stitching::SequentialMatcher>(
+            stitcher->featuresMatcher(), config.matchWindow, true, config.panoConfidenceThresh));
+    return stitcher;
+}
+
+// Dùng cấu hình mặc định khi config là nullptr; trả về false nếu config không hợp lệ
+static bool resolve_config(const bill_stitching::StitchConfig *config, bill_stitching::StitchConfig &out) {
+    if (config == nullptr) {
+        out = bill_stitching::defaultStitchConfig();
+        return true;
+    }
+    // Chỉ đọc các trường khác khi bố cục khớp với phiên bản của bản build này
+    if (config->version != bill_stitching::kStitchConfigVersion ||
+        bill_stitching::validateConfig(*config) != bill_stitching::CONFIG_OK) {
+        platform_log("Cấu hình ghép ảnh không hợp lệ\n");
+        return false;
+    }
+    out = *config;
+    return true;
+}
 
-    // Sắp xếp tên ảnh theo thứ tự tăng dần
-    platform_log("Đang sắp xếp tên ảnh theo thứ tự tăng dần...\n");
-    std::sort(imagePathsVector.begin(), imagePathsVector.end(), compareNatural);
-    platform_log("Sắp xếp tên ảnh xong.\n");
+// Registration tính trên ảnh proxy (pixel ở workScale) được đổi sang pixel của ảnh gốc,
+// để có thể dựng lại ở bất kỳ tỉ lệ nào. framePaths theo thứ tự của toCanvas.
+static void finish_registration(bill_stitching::Registration &registration,
+                                const std::vector<std::string> &framePaths,
+                                const bill_stitching::StitchConfig &config) {
+    registration.engine = config.engine;
+    registration.paths = framePaths;
+    // Chưa engine nào bù phơi sáng theo frame
+    registration.gains.assign(framePaths.size(), 1.0);
+    bill_stitching::scaleRegistration(registration, 1 / config.workScale);
+}
+
+// Ghép ảnh bằng engine được chọn trong config, trả về false nếu không ghép được hoặc bị
+// huỷ. stitcher chỉ được dùng với ENGINE_STITCHER_SCANS. registration (có thể là nullptr)
+// nhận kết quả đăng ký để dựng lại ảnh ghép sau này. Ảnh ghép nằm trong result cho tới
+// khi được đọc ra (mã hoá ra file hoặc vào StitchResult).
+bool stitch_images_to_composite(const std::vector<std::string> &imagePaths, const std::vector<int64> &timestampsUs,
+                                const bill_stitching::StitchConfig &config, const Ptr<Stitcher> &stitcher,
+                                bill_stitching::Composite &result, const bill_stitching::StitchControl *control,
+                                bill_stitching::FrameCounts *counts = nullptr,
+                                bill_stitching::Registration *registration = nullptr) {
+    const bill_stitching::StitchControl noControl;
+    const bill_stitching::StitchControl &ctl = control != nullptr ? *control : noControl;
+
+    // Sắp xếp ảnh theo thứ tự chụp (timestamp, hoặc tên file nếu không có timestamp)
+    platform_log("Đang sắp xếp ảnh theo thứ tự chụp...\n");
+    std::vector<std::string> imagePathsVector;
+    std::vector<int64> timesVector;     // 0 khi không có timestamp
+    imagePathsVector.reserve(imagePaths.size());
+    for (int index: bill_stitching::captureOrder(imagePaths, timestampsUs)) {
+        imagePathsVector.push_back(imagePaths[index]);
+        timesVector.push_back(index < static_cast<int>(timestampsUs.size()) ? timestampsUs[index] : 0);
+    }
+    platform_log("Sắp xếp ảnh xong.\n");
+    const int numImages = static_cast<int>(imagePathsVector.size());
+    std::vector<cv::Mat> loaded(numImages);
+    std::vector<bill_stitching::FrameQuality> qualities(numImages);
     std::vector<cv::Mat> images;
-    images.reserve(numImages); // Giữ chỗ trước cho images để tối ưu hiệu suất
+    images.reserve(imagePathsVector.size()); // Giữ chỗ trước cho images để tối ưu hiệu suất
 
-    for (const auto &imagePath: imagePathsVector) {
-        cv::Mat img = cv::imread(imagePath);
-        platform_log("Đã tải hình ảnh tại đường dẫn: %s\n", imagePath.c_str());
-        if (img.empty()) {
-            platform_log("Không thể tải hình ảnh tại đường dẫn: %s\n", imagePath.c_str());
+    try {
+        // Giải mã + tiền xử lý song song trên các core, mỗi ảnh ghi vào đúng vị trí
+        // của nó nên thứ tự sau khi sắp xếp được giữ nguyên
+        long long int loadStart = get_now();
+        std::atomic<int> numLoaded{0};
+        ctl.progress(bill_stitching::STAGE_DECODE, 0, numImages);
+        parallel_for_(Range(0, numImages), [&](const Range &range) {
+            for (int i = range.start; i < range.end; ++i) {
+                // Không throw trong parallel_for_, chỉ bỏ qua phần việc còn lại
+                if (ctl.cancelled()) {
+                    return;
+                }
+                // Chấm điểm trên ảnh gốc, trước khi CLAHE làm thay đổi độ sáng
+                Mat img = load_work_image(imagePathsVector[i], config.workScale);
+                if (!img.empty()) {
+                    if (config.qualityPrefilter) {
+                        qualities[i] = bill_stitching::scoreFrame(img);
+                    }
+                    loaded[i] = preprocess(img);
+                }
+                ctl.report(bill_stitching::STAGE_PREPROCESS, ++numLoaded, numImages);
+            }
+        }, numImages);
+        ctl.checkpoint();
+        platform_log("Tải %d ảnh mất %lld ms\n", numImages, get_now() - loadStart);
+    } catch (const bill_stitching::StitchCancelled &) {
+        platform_log("Đã huỷ ghép ảnh khi đang tải ảnh.\n");
+        return false;
+    } catch (const cv::Exception &e) {
+        platform_log("Lỗi OpenCV khi tải ảnh: %s\n", e.what());
+        return false;
+    }
+    std::vector<bill_stitching::FrameQuality> loadedQualities;
+    // Đường dẫn của từng ảnh trong images, để đọc lại ảnh gốc khi ghép ở độ phân giải cao
+    std::vector<std::string> sourcePaths;
+    // Thời điểm chụp của từng ảnh trong images, cho prior chuyển động khi ghép cặp
+    std::vector<int64> sourceTimes;
+    for (int i = 0; i < numImages; ++i) {
+        if (loaded[i].empty()) {
             // Xử lý lỗi khi không load được ảnh, ví dụ: bỏ qua ảnh lỗi và tiếp tục
             continue;
         }
-        Mat resized;
-        platform_log("Kích thước ảnh gốc: %dx%d\n", img.cols, img.rows);
-        resize(img, resized, Size(), 0.3, 0.3);
-        platform_log("Kích thước ảnh sau khi giảm: %dx%d\n", resized.cols, resized.rows);
-        // Tiền xử lý ảnh
-        resized = preprocess(resized);
-//        img = preprocess(img);
-        images.push_back(resized);
+        images.push_back(loaded[i]);
+        loadedQualities.push_back(qualities[i]);
+        sourcePaths.push_back(imagePathsVector[i]);
+        sourceTimes.push_back(timesVector[i]);
+    }
+    loaded.clear();
+
+    bill_stitching::FrameCounts frameCounts;
+    frameCounts.input = static_cast<int>(images.size());
+    if (config.qualityPrefilter && images.size() > 2) {
+        try {
+            bill_stitching::QualitySelection selection =
+                    bill_stitching::selectQualityFrames(images, loadedQualities);
+            std::vector<cv::Mat> kept;
+            std::vector<std::string> keptPaths;
+            std::vector<int64> keptTimes;
+            for (int index: selection.kept) {
+                kept.push_back(images[index]);
+                keptPaths.push_back(sourcePaths[index]);
+                keptTimes.push_back(sourceTimes[index]);
+            }
+            images.swap(kept);
+            sourcePaths.swap(keptPaths);
+            sourceTimes.swap(keptTimes);
+            platform_log("Lọc chất lượng: bỏ %d ảnh, giữ lại %d ảnh để lấp khoảng trống\n",
+                         selection.rejected, selection.restored);
+            frameCounts.rejected = selection.rejected;
+        } catch (const cv::Exception &e) {
+            platform_log("Lỗi OpenCV khi lọc chất lượng: %s\n", e.what());
+        }
+    }
+    if (config.cullMinOverlap > 0 && images.size() > 2) {
+        try {
+            long long int cullStart = get_now();
+            bill_stitching::CullResult culled = bill_stitching::cullRedundantFrames(images, config.cullMinOverlap);
+            std::vector<cv::Mat> kept;
+            std::vector<std::string> keptPaths;
+            std::vector<int64> keptTimes;
+            for (int index: culled.kept) {
+                kept.push_back(images[index]);
+                keptPaths.push_back(sourcePaths[index]);
+                keptTimes.push_back(sourceTimes[index]);
+            }
+            images.swap(kept);
+            sourcePaths.swap(keptPaths);
+            sourceTimes.swap(keptTimes);
+            frameCounts.culled = culled.dropped;
+            platform_log("Loại %d ảnh thừa trong %lld ms\n", culled.dropped, get_now() - cullStart);
+        } catch (const cv::Exception &e) {
+            platform_log("Lỗi OpenCV khi loại ảnh thừa: %s\n", e.what());
+        }
+    }
+    frameCounts.stitched = static_cast<int>(images.size());
+    if (counts != nullptr) {
+        *counts = frameCounts;
+    }
+
+    // Đăng ký trên ảnh proxy (workScale), ghép từ ảnh gốc đọc lại ở composeScale
+    const bool composeFromSources = config.composeScale > config.workScale * 1.01;
+    bill_stitching::ComposeSource source;
+    source.scale = config.composeScale / config.workScale;
+    source.load = [&](int index) {
+        Mat img = load_work_image(sourcePaths[index], config.composeScale);
+        return img.empty() ? img : preprocess(img);
+    };
+
+    if (config.engine != bill_stitching::ENGINE_STITCHER_SCANS) {
+        try {
+            long long int start = get_now();
+            ctl.checkpoint();
+            platform_log("Đang ghép %lu ảnh theo chuỗi...\n", images.size());
+            const bool stitched = bill_stitching::stitchBills(images, result, config,
+                                                              composeFromSources ? &source : nullptr,
+                                                              registration, sourceTimes);
+            platform_log("Ghép mất %lld ms\n", get_now() - start);
+            if (!stitched) {
+                return false;
+            }
+            if (registration != nullptr) {
+                finish_registration(*registration, sourcePaths, config);
+            }
+            return true;
+        } catch (const bill_stitching::StitchCancelled &) {
+            platform_log("Đã huỷ ghép ảnh.\n");
+        } catch (const cv::Exception &e) {
+            platform_log("Lỗi OpenCV: %s\n", e.what());
+        } catch (const std::exception &e) {
+            platform_log("Lỗi: %s\n", e.what());
+        } catch (...) {
+            platform_log("Đã xảy ra lỗi không xác định.\n");
+        }
+        return false;
     }
 
     try {
         long long int start = get_now();
 
-        // 1. Khởi tạo Stitcher
-        Ptr<Stitcher> stitcher = Stitcher::create(Stitcher::SCANS);
-        // 2. Tùy chỉnh các tham số
-//        stitcher->setRegistrationResol(0.75);    // Giảm nhẹ để tăng tốc độ, có thể thử nghiệm từ 0.6 - 0.8
-//        stitcher->setSeamEstimationResol(0.75); // Giống RegistrationResol
-        stitcher->setCompositingResol(1);      // Giữ nguyên để đảm bảo độ phân giải ảnh kết quả
-        stitcher->setPanoConfidenceThresh(0.92);  // Tăng lên để loại bỏ ghép nối sai, giá trị thử nghiệm từ 0.7 - 0.9
-//        stitcher->setFeaturesFinder(SIFT::create());
-        stitcher->setFeaturesFinder(ORB::create(8000)); // Giảm số lượng features để tăng tốc độ, thử nghiệm từ 3000 - 8000
-        // Ngoài ra, có thể thử nghiệm với các features khác như SIFT, BRISK, AKAZE
-        // Bỏ qua ExposureCompensator vì ánh sáng khi scan thường đồng đều
-        // stitcher->setExposureCompensator(ExposureCompensator::createDefault(ExposureCompensator::GAIN_BLOCKS));
-        stitcher->setBlender(Blender::createDefault(Blender::MULTI_BAND,
-                                                    false)); // Giữ nguyên, vẫn cần blender cho kết quả tốt nhất
-
         // 3. Thực hiện ghép nối tất cả ảnh cùng lúc
-        cv::Mat result;
         platform_log("Đang ghép %lu ảnh...\n", images.size());
-        Stitcher::Status status = stitcher->stitch(images, result);
+        // Tách stitch() thành hai bước để kiểm tra huỷ giữa ước lượng và ghép
+        bill_stitching::attachControl(stitcher, &ctl, static_cast<int>(images.size()));
+        bill_stitching::setMatchTimestamps(stitcher, sourceTimes);
+        Stitcher::Status status = stitcher->estimateTransform(images);
+        ctl.progress(bill_stitching::STAGE_ESTIMATION, 1, 1);
+        std::vector<cv::Size> inputSizes;
+        for (const auto &image: images) {
+            inputSizes.push_back(image.size());
+        }
+        if (status == Stitcher::OK && registration != nullptr) {
+            bill_stitching::stitcherRegistration(*stitcher, inputSizes, *registration);
+            std::vector<std::string> framePaths;
+            for (int index: stitcher->component()) {
+                framePaths.push_back(sourcePaths[index]);
+            }
+            finish_registration(*registration, framePaths, config);
+        }
+        // Blender FEATHER (tuỳ chọn, không có seam finder) ghép vào canvas dạng tile với bộ
+        // nhớ có giới hạn, từ ảnh làm việc đang có trong bộ nhớ nếu không cần đọc lại ảnh
+        // gốc. Các blender khác của cv::Stitcher trộn cả panorama trong RAM.
+        bool composed = true;
+        if (status == Stitcher::OK &&
+            (composeFromSources || config.blender == bill_stitching::BLENDER_FEATHER)) {
+            // Cùng độ phân giải ghép như Stitcher::composePanorama (composeMegapix, -1 = giữ nguyên)
+            const double scale = config.composeMegapix > 0
+                                 ? std::min(1.0, std::sqrt(config.composeMegapix * 1e6 / images[0].total())) : 1.0;
+            bill_stitching::ComposeSource inMemory;
+            inMemory.scale = scale;
+            inMemory.load = [&images, scale](int index) {
+                // Mỗi ảnh làm việc được nhả ngay sau khi ghép
+                Mat img = images[index];
+                images[index].release();
+                if (scale < 1) {
+                    resize(img, img, Size(), scale, scale, INTER_AREA);
+                }
+                return img;
+            };
+            composed = bill_stitching::composeStitcherFromSources(*stitcher, inputSizes,
+                                                                   composeFromSources ? source : inMemory,
+                                                                   ctl, result);
+        } else if (status == Stitcher::OK) {
+            status = stitcher->composePanorama(result.image);
+            composed = !result.image.empty();
+        }
+        bill_stitching::attachControl(stitcher, nullptr, 0);
         platform_log("Kết thúc ghép ảnh.\n");
+        if (status == Stitcher::OK && !composed) {
+            platform_log("Không thể ghép lại từ ảnh gốc.\n");
+            return false;
+        }
 
         // 4. Kiểm tra kết quả
         if (status != Stitcher::OK) {
@@ -182,16 +413,331 @@ void stitch_images(const char **imagePaths, int numImages, char *outputImagePath
                     break;
             }
             platform_log("Không thể ghép ảnh: %s\n", errorMessage.c_str());
+            return false;
+        }
+
+        long long int end = get_now();
+        platform_log("Ghép mất %lld ms\n", end - start);
+        return true;
+
+    } catch (const bill_stitching::StitchCancelled &) {
+        platform_log("Đã huỷ ghép ảnh.\n");
+    } catch (const cv::Exception &e) {
+        platform_log("Lỗi OpenCV: %s\n", e.what());
+    } catch (const std::exception &e) {
+        platform_log("Lỗi: %s\n", e.what());
+    } catch (...) {
+        platform_log("Đã xảy ra lỗi không xác định.\n");
+    }
+    bill_stitching::attachControl(stitcher, nullptr, 0);
+    return false;
+}
+
+// Dựng lại ảnh ghép từ file registration ở tỉ lệ `scale` so với ảnh gốc, bỏ qua toàn bộ
+// bước tìm features, ghép cặp và ước lượng. Trả về false nếu không đọc được registration
+// hoặc một ảnh nguồn, hoặc bị huỷ.
+static bool render_registration_to_composite(const std::string &registrationPath, double scale,
+                                             const bill_stitching::StitchControl &control,
+                                             bill_stitching::Composite &result,
+                                             bill_stitching::Registration &registration) {
+    if (!(scale > 0 && scale <= 1)) {
+        platform_log("Tỉ lệ dựng lại không hợp lệ: %f\n", scale);
+        return false;
+    }
+    if (!bill_stitching::readRegistration(registrationPath, registration)) {
+        platform_log("Không thể đọc registration: %s\n", registrationPath.c_str());
+        return false;
+    }
+    // Tiền xử lý giống lúc ghép để ảnh dựng lại trùng với ảnh ghép ban đầu
+    const bool chain = registration.engine != bill_stitching::ENGINE_STITCHER_SCANS;
+    auto load = [chain](const std::string &path, double loadScale) {
+        Mat img = load_work_image(path, loadScale);
+        if (img.empty()) {
+            return img;
+        }
+        img = preprocess(img);
+        return chain ? bill_stitching::preprocessBill(img) : img;
+    };
+    long long int start = get_now();
+    bool rendered;
+    try {
+        rendered = bill_stitching::renderRegistration(registration, scale, load, control, result);
+    } catch (const bill_stitching::StitchCancelled &) {
+        platform_log("Đã huỷ dựng lại ảnh ghép.\n");
+        return false;
+    } catch (const cv::Exception &e) {
+        platform_log("Lỗi OpenCV: %s\n", e.what());
+        return false;
+    } catch (const std::exception &e) {
+        platform_log("Lỗi: %s\n", e.what());
+        return false;
+    } catch (...) {
+        platform_log("Đã xảy ra lỗi không xác định.\n");
+        return false;
+    }
+    platform_log("Dựng lại %lu ảnh mất %lld ms\n", registration.paths.size(), get_now() - start);
+    return rendered;
+}
+
+static std::vector<int64> to_timestamps(const int64_t *timestampsUs, int numImages) {
+    if (timestampsUs == nullptr) {
+        return {};
+    }
+    return std::vector<int64>(timestampsUs, timestampsUs + numImages);
+}
+
+extern "C" {
+const char *version() {
+    return CV_VERSION;
+}
+
+// Ngân sách bộ nhớ cho canvas ghép ảnh; tile vượt quá được spill vào scratchDir
+// (thư mục cache của app). budgetBytes <= 0 giữ giá trị mặc định.
+void stitch_set_canvas_budget(int64_t budgetBytes, const char *scratchDir) {
+    bill_stitching::CanvasBudget budget = bill_stitching::defaultCanvasBudget();
+    if (budgetBytes > 0) {
+        budget.bytes = static_cast<size_t>(budgetBytes);
+    }
+    budget.scratchDir = scratchDir != nullptr ? scratchDir : "";
+    bill_stitching::setDefaultCanvasBudget(budget);
+}
+
+// Cache features trên đĩa cho các lần ghép lại cùng ảnh; dir rỗng (hoặc nullptr) tắt
+// cache. maxBytes <= 0 giữ giới hạn mặc định.
+void stitch_set_feature_cache(const char *dir, int64_t maxBytes) {
+    bill_stitching::FeatureCacheSettings settings;
+    if (maxBytes > 0) {
+        settings.maxBytes = static_cast<size_t>(maxBytes);
+    }
+    settings.dir = dir != nullptr ? dir : "";
+    bill_stitching::setFeatureCache(settings);
+}
+
+// Ghi cấu hình mặc định của phiên bản `version` vào out. Phía Dart gọi hàm này để
+// khởi tạo struct rồi chỉ sửa các trường cần thiết.
+int stitch_config_defaults(bill_stitching::StitchConfig *out, int32_t version) {
+    if (out == nullptr || version != bill_stitching::kStitchConfigVersion) {
+        return bill_stitching::CONFIG_ERR_VERSION;
+    }
+    *out = bill_stitching::defaultStitchConfig();
+    return bill_stitching::CONFIG_OK;
+}
+
+// Trả về ConfigStatus, để lỗi cấu hình được báo ngay khi tạo thay vì lúc ghép
+int stitch_config_validate(const bill_stitching::StitchConfig *config) {
+    if (config == nullptr) {
+        return bill_stitching::CONFIG_ERR_VERSION;
+    }
+    return bill_stitching::validateConfig(*config);
+}
+
+// timestampsUs (có thể là nullptr) là thời điểm chụp của từng ảnh, dùng để sắp xếp.
+// config có thể là nullptr (cấu hình mặc định); kết quả được mã hoá theo config.
+void stitch_images(const char **imagePaths, const int64_t *timestampsUs, int numImages,
+                   char *outputImagePath, const bill_stitching::StitchConfig *config) {
+    bill_stitching::StitchConfig resolved;
+    if (!resolve_config(config, resolved)) {
+        return;
+    }
+    bill_stitching::Composite result;
+    bill_stitching::Registration registration;
+    Ptr<Stitcher> stitcher = resolved.engine == bill_stitching::ENGINE_STITCHER_SCANS
+                             ? create_stitcher(resolved) : Ptr<Stitcher>();
+    if (!stitch_images_to_composite(std::vector<std::string>(imagePaths, imagePaths + numImages),
+                                    to_timestamps(timestampsUs, numImages), resolved, stitcher, result,
+                                    nullptr, nullptr, &registration)) {
+        return;
+    }
+    try {
+        if (!bill_stitching::writeEncoded(outputImagePath, result.bgr(), bill_stitching::outputExtension(resolved),
+                                          resolved.outputQuality)) {
+            platform_log("Không thể lưu ảnh ghép tại: %s\n", outputImagePath);
             return;
         }
+        platform_log("Hình ảnh ghép được lưu tại: %s\n", outputImagePath);
+        // Sidecar để xuất lại ảnh ở tỉ lệ khác mà không phải ghép lại từ đầu
+        const std::string registrationPath = bill_stitching::registrationSidecarPath(outputImagePath);
+        if (!bill_stitching::writeRegistration(registrationPath, registration)) {
+            platform_log("Không thể lưu registration tại: %s\n", registrationPath.c_str());
+        }
+    } catch (const cv::Exception &e) {
+        platform_log("Lỗi OpenCV: %s\n", e.what());
+    } catch (const std::exception &e) {
+        platform_log("Lỗi: %s\n", e.what());
+    } catch (...) {
+        platform_log("Đã xảy ra lỗi không xác định.\n");
+    }
+}
+
+// Giống stitch_images nhưng giữ kết quả trong bộ nhớ và trả về handle (nullptr nếu lỗi).
+// Handle phải được giải phóng bằng stitch_result_release.
+void *stitch_images_result(const char **imagePaths, const int64_t *timestampsUs, int numImages,
+                           const bill_stitching::StitchConfig *config) {
+    bill_stitching::StitchConfig resolved;
+    if (!resolve_config(config, resolved)) {
+        return nullptr;
+    }
+    bill_stitching::Composite result;
+    bill_stitching::FrameCounts counts;
+    bill_stitching::Registration registration;
+    Ptr<Stitcher> stitcher = resolved.engine == bill_stitching::ENGINE_STITCHER_SCANS
+                             ? create_stitcher(resolved) : Ptr<Stitcher>();
+    if (!stitch_images_to_composite(std::vector<std::string>(imagePaths, imagePaths + numImages),
+                                    to_timestamps(timestampsUs, numImages), resolved, stitcher, result,
+                                    nullptr, &counts, &registration)) {
+        return nullptr;
+    }
+    try {
+        auto *handle = new bill_stitching::StitchResult(result, counts);
+        handle->setRegistration(registration);
+        return handle;
+    } catch (const cv::Exception &e) {
+        platform_log("Lỗi OpenCV: %s\n", e.what());
+    } catch (const std::exception &e) {
+        // Ví dụ std::bad_alloc khi cấp bộ đệm RGBA cho bill dài
+        platform_log("Lỗi: %s\n", e.what());
+    } catch (...) {
+        platform_log("Đã xảy ra lỗi không xác định.\n");
+    }
+    return nullptr;
+}
 
+// Dựng lại ảnh ghép từ sidecar registration (xem registrationSidecarPath) ở tỉ lệ scale
+// so với ảnh gốc, (0, 1]. Trả về handle StitchResult, nullptr nếu lỗi.
+void *stitch_render_registration(const char *registrationPath, double scale) {
+    const bill_stitching::StitchControl noControl;
+    bill_stitching::Composite result;
+    bill_stitching::Registration registration;
+    if (!render_registration_to_composite(registrationPath, scale, noControl, result, registration)) {
+        return nullptr;
+    }
+    try {
+        auto *handle = new bill_stitching::StitchResult(result);
+        handle->setRegistration(registration);
+        return handle;
+    } catch (const cv::Exception &e) {
+        platform_log("Lỗi OpenCV: %s\n", e.what());
+    } catch (const std::exception &e) {
+        platform_log("Lỗi: %s\n", e.what());
+    } catch (...) {
+        platform_log("Đã xảy ra lỗi không xác định.\n");
+    }
+    return nullptr;
+}
 
-        imwrite(outputImagePath, result);
+// Phiên ghép ảnh tăng dần: các frame được đăng ký ngay trong lúc người dùng đang quét
+void *stitch_session_create() {
+    return new bill_stitching::StitchSession();
+}
 
-        long long int end = get_now();
-        platform_log("Ghép mất %lld ms\n", end - start);
+// timestampUs là thời điểm chụp (0 nếu không biết)
+void stitch_session_push_frame(void *session, const char *imagePath, int64_t timestampUs) {
+    if (session == nullptr || imagePath == nullptr) {
+        return;
+    }
+    static_cast<bill_stitching::StitchSession *>(session)->pushFrame(imagePath, timestampUs);
+}
+
+// Ảnh được mã hoá theo outputFormat/outputQuality của config (nullptr = mặc định) như
+// stitch_images, không phụ thuộc đuôi của outputImagePath.
+int stitch_session_finalize(void *session, char *outputImagePath, const bill_stitching::StitchConfig *config) {
+    if (session == nullptr || outputImagePath == nullptr) {
+        return bill_stitching::SESSION_ERR_INVALID;
+    }
+    bill_stitching::StitchConfig resolved;
+    if (!resolve_config(config, resolved)) {
+        return bill_stitching::SESSION_ERR_INVALID;
+    }
+    try {
+        bill_stitching::Composite result;
+        bill_stitching::SessionStatus status =
+                static_cast<bill_stitching::StitchSession *>(session)->finalize(result);
+        if (status != bill_stitching::SESSION_OK) {
+            platform_log("Không thể ghép ảnh của phiên: %d\n", status);
+            return status;
+        }
+        if (!bill_stitching::writeEncoded(outputImagePath, result.bgr(), bill_stitching::outputExtension(resolved),
+                                          resolved.outputQuality)) {
+            platform_log("Không thể lưu ảnh ghép tại: %s\n", outputImagePath);
+            return bill_stitching::SESSION_ERR_WRITE_FAIL;
+        }
         platform_log("Hình ảnh ghép được lưu tại: %s\n", outputImagePath);
+        return bill_stitching::SESSION_OK;
+    } catch (const cv::Exception &e) {
+        platform_log("Lỗi OpenCV: %s\n", e.what());
+    } catch (const std::exception &e) {
+        platform_log("Lỗi: %s\n", e.what());
+    } catch (...) {
+        platform_log("Đã xảy ra lỗi không xác định.\n");
+    }
+    return bill_stitching::SESSION_ERR_INVALID;
+}
 
+void stitch_session_push_yuv420(void *session,
+                                const uint8_t *yPlane, const uint8_t *uPlane, const uint8_t *vPlane,
+                                int width, int height, int yRowStride, int uvRowStride,
+                                int uvPixelStride, int rotation, int64_t timestampUs) {
+    if (session == nullptr) {
+        return;
+    }
+    bill_stitching::Yuv420Planes planes;
+    planes.y = yPlane;
+    planes.u = uPlane;
+    planes.v = vPlane;
+    planes.width = width;
+    planes.height = height;
+    planes.yRowStride = yRowStride;
+    planes.uvRowStride = uvRowStride;
+    planes.uvPixelStride = uvPixelStride;
+    planes.rotation = rotation;
+    planes.timestampUs = timestampUs;
+    try {
+        static_cast<bill_stitching::StitchSession *>(session)->pushYuv420(planes);
+    } catch (const cv::Exception &e) {
+        platform_log("Lỗi OpenCV: %s\n", e.what());
+    }
+}
+
+// Chế độ quét trực tiếp: gọi với mọi frame preview, frame chỉ được đưa vào phiên khi
+// tracker quyết định nó là keyframe. Trả về 1 nếu frame được đưa vào, 0 nếu không.
+int stitch_session_track_yuv420(void *session,
+                                const uint8_t *yPlane, const uint8_t *uPlane, const uint8_t *vPlane,
+                                int width, int height, int yRowStride, int uvRowStride,
+                                int uvPixelStride, int rotation, int64_t timestampUs) {
+    if (session == nullptr) {
+        return 0;
+    }
+    bill_stitching::Yuv420Planes planes;
+    planes.y = yPlane;
+    planes.u = uPlane;
+    planes.v = vPlane;
+    planes.width = width;
+    planes.height = height;
+    planes.yRowStride = yRowStride;
+    planes.uvRowStride = uvRowStride;
+    planes.uvPixelStride = uvPixelStride;
+    planes.rotation = rotation;
+    planes.timestampUs = timestampUs;
+    try {
+        return static_cast<bill_stitching::StitchSession *>(session)->trackYuv420(planes) ? 1 : 0;
+    } catch (const cv::Exception &e) {
+        platform_log("Lỗi OpenCV: %s\n", e.what());
+    }
+    return 0;
+}
+
+// Như stitch_session_finalize nhưng trả về handle kết quả trong bộ nhớ (nullptr nếu lỗi)
+void *stitch_session_finalize_result(void *session) {
+    if (session == nullptr) {
+        return nullptr;
+    }
+    try {
+        bill_stitching::Composite result;
+        if (static_cast<bill_stitching::StitchSession *>(session)->finalize(result) !=
+            bill_stitching::SESSION_OK) {
+            return nullptr;
+        }
+        return new bill_stitching::StitchResult(result);
     } catch (const cv::Exception &e) {
         platform_log("Lỗi OpenCV: %s\n", e.what());
     } catch (const std::exception &e) {
@@ -199,5 +745,341 @@ void stitch_images(const char **imagePaths, int numImages, char *outputImagePath
     } catch (...) {
         platform_log("Đã xảy ra lỗi không xác định.\n");
     }
+    return nullptr;
+}
+
+void stitch_session_destroy(void *session) {
+    delete static_cast<bill_stitching::StitchSession *>(session);
+}
+
+// Chấm điểm chất lượng frame khi chụp. out nhận 4 giá trị: độ nét (0..1), Tenengrad,
+// tỉ lệ điểm cháy sáng và độ sáng trung bình. Trả về 1 nếu frame đạt.
+int frame_quality_score(const uint8_t *yPlane, int width, int height, int yRowStride, double *out) {
+    if (yPlane == nullptr || out == nullptr) {
+        return 0;
+    }
+    try {
+        cv::Mat luma(height, width, CV_8UC1, const_cast<uint8_t *>(yPlane), yRowStride);
+        bill_stitching::FrameQuality q = bill_stitching::scoreFrame(luma);
+        out[0] = q.sharpness;
+        out[1] = q.tenengrad;
+        out[2] = q.clippedRatio;
+        out[3] = q.meanLuma;
+        return q.acceptable ? 1 : 0;
+    } catch (const cv::Exception &e) {
+        platform_log("Lỗi OpenCV: %s\n", e.what());
+    }
+    return 0;
+}
+
+// So sánh ORB, SIFT và UPRIGHT trên các cặp ảnh tổng hợp từ ảnh bill (xem
+// benchmarkDetectors), với cấu hình mặc định. out nhận 6 giá trị cho mỗi detector theo
+// thứ tự đó: detector, số cặp, ms/frame, keypoint/frame, tỉ lệ inlier, tỉ lệ cặp ghép
+// được. Trả về số detector đã đo (0 nếu lỗi). Chặn luồng gọi trong vài giây.
+int feature_benchmark(const char **imagePaths, int numImages, double *out) {
+    if (imagePaths == nullptr || out == nullptr) {
+        return 0;
+    }
+    const bill_stitching::StitchConfig config = bill_stitching::defaultStitchConfig();
+    try {
+        std::vector<cv::Mat> images;
+        for (int i = 0; i < numImages; ++i) {
+            Mat img = load_work_image(imagePaths[i], config.workScale);
+            if (!img.empty()) {
+                images.push_back(preprocess(img));
+            }
+        }
+        const std::vector<bill_stitching::DetectorBenchmark> results = bill_stitching::benchmarkDetectors(
+                images, config, {bill_stitching::DETECTOR_ORB, bill_stitching::DETECTOR_SIFT,
+                                 bill_stitching::DETECTOR_UPRIGHT});
+        for (size_t i = 0; i < results.size(); ++i) {
+            double *row = out + i * 6;
+            row[0] = results[i].detector;
+            row[1] = results[i].pairs;
+            row[2] = results[i].msPerFrame;
+            row[3] = results[i].keypointsPerFrame;
+            row[4] = results[i].inlierRatio;
+            row[5] = results[i].registeredRatio;
+        }
+        return static_cast<int>(results.size());
+    } catch (const cv::Exception &e) {
+        platform_log("Lỗi OpenCV: %s\n", e.what());
+    }
+    return 0;
+}
+
+// Hướng dẫn quét trực tiếp: đánh giá từng frame preview để biết khi nào nên chụp
+void *scan_guide_create() {
+    return new bill_stitching::ScanGuide();
+}
+
+// out nhận 7 giá trị: dịch chuyển x, y và vận tốc x, y từ lần chụp cuối (theo tỉ lệ
+// frame), độ chồng lấp, nguy cơ nhoè và độ tin cậy. Trả về 1 nếu nên chụp ngay.
+int scan_guide_update(void *guide, const uint8_t *yPlane, int width, int height, int yRowStride,
+                      int rotation, int64_t timestampUs, double *out) {
+    if (guide == nullptr || yPlane == nullptr || out == nullptr) {
+        return 0;
+    }
+    try {
+        cv::Mat luma(height, width, CV_8UC1, const_cast<uint8_t *>(yPlane), yRowStride);
+        bill_stitching::Guidance g = static_cast<bill_stitching::ScanGuide *>(guide)->update(
+                luma, rotation, timestampUs);
+        out[0] = g.displacement.x;
+        out[1] = g.displacement.y;
+        out[2] = g.velocity.x;
+        out[3] = g.velocity.y;
+        out[4] = g.overlap;
+        out[5] = g.blurRisk;
+        out[6] = g.confidence;
+        return g.captureNow ? 1 : 0;
+    } catch (const cv::Exception &e) {
+        platform_log("Lỗi OpenCV: %s\n", e.what());
+    }
+    return 0;
+}
+
+void scan_guide_mark_captured(void *guide) {
+    if (guide != nullptr) {
+        static_cast<bill_stitching::ScanGuide *>(guide)->markCaptured();
+    }
+}
+
+void scan_guide_destroy(void *guide) {
+    delete static_cast<bill_stitching::ScanGuide *>(guide);
+}
+
+// Truy cập kết quả ghép trong bộ nhớ; handle nullptr cho giá trị rỗng (0, nullptr)
+int stitch_result_width(void *result) {
+    if (result == nullptr) {
+        return 0;
+    }
+    return static_cast<bill_stitching::StitchResult *>(result)->pixels().cols;
+}
+
+int stitch_result_height(void *result) {
+    if (result == nullptr) {
+        return 0;
+    }
+    return static_cast<bill_stitching::StitchResult *>(result)->pixels().rows;
+}
+
+int stitch_result_stride(void *result) {
+    if (result == nullptr) {
+        return 0;
+    }
+    return static_cast<int>(static_cast<bill_stitching::StitchResult *>(result)->pixels().step[0]);
+}
+
+int stitch_result_format(void *) {
+    return bill_stitching::RESULT_FORMAT_RGBA8888;
+}
+
+uint8_t *stitch_result_pixels(void *result) {
+    if (result == nullptr) {
+        return nullptr;
+    }
+    return static_cast<bill_stitching::StitchResult *>(result)->pixels().data;
+}
+
+// Mã hoá kết quả (".jpg", ".png", ".webp"); bộ đệm thuộc về handle và chỉ hợp lệ
+// đến lần encode tiếp theo. Trả về nullptr nếu lỗi.
+const uint8_t *stitch_result_encode(void *result, const char *ext, int quality, int *length) {
+    if (length == nullptr) {
+        return nullptr;
+    }
+    *length = 0;
+    if (result == nullptr || ext == nullptr) {
+        return nullptr;
+    }
+    auto *stitchResult = static_cast<bill_stitching::StitchResult *>(result);
+    try {
+        if (!stitchResult->encode(ext, quality)) {
+            return nullptr;
+        }
+    } catch (const cv::Exception &e) {
+        platform_log("Lỗi OpenCV: %s\n", e.what());
+        return nullptr;
+    }
+    *length = static_cast<int>(stitchResult->encoded().size());
+    return stitchResult->encoded().data();
+}
+
+int stitch_result_write(void *result, const char *outputImagePath, int quality) {
+    if (result == nullptr || outputImagePath == nullptr) {
+        return 0;
+    }
+    try {
+        return static_cast<bill_stitching::StitchResult *>(result)->write(outputImagePath, quality)
+               ? 1 : 0;
+    } catch (const cv::Exception &e) {
+        platform_log("Lỗi OpenCV: %s\n", e.what());
+    }
+    return 0;
+}
+
+// counts nhận 4 giá trị: số ảnh đã tải, bị loại vì chất lượng, bị loại vì thừa và được ghép
+void stitch_result_frame_counts(void *result, int *counts) {
+    if (counts == nullptr) {
+        return;
+    }
+    if (result == nullptr) {
+        std::fill(counts, counts + 4, 0);
+        return;
+    }
+    const bill_stitching::FrameCounts &c = static_cast<bill_stitching::StitchResult *>(result)->frameCounts();
+    counts[0] = c.input;
+    counts[1] = c.rejected;
+    counts[2] = c.culled;
+    counts[3] = c.stitched;
+}
+
+void stitch_result_retain(void *result) {
+    if (result == nullptr) {
+        return;
+    }
+    static_cast<bill_stitching::StitchResult *>(result)->retain();
+}
+
+// Dùng làm NativeFinalizer phía Dart
+void stitch_result_release(void *result) {
+    if (result != nullptr) {
+        static_cast<bill_stitching::StitchResult *>(result)->release();
+    }
+}
+
+// Job pool: gửi job không chặn, kết quả được báo qua callback (NativeCallable.listener
+// phía Dart) từ worker thread. status là JobStatus, result là handle StitchResult
+// (nullptr nếu lỗi) và thuộc quyền sở hữu của bên nhận. progress và config có thể là
+// nullptr. Trả về 0 (không tạo job) nếu tham số hoặc config không hợp lệ.
+int64_t stitch_job_submit_images(const char **imagePaths, const int64_t *timestampsUs, int numImages,
+                                 int priority,
+                                 bill_stitching::JobCompletionCallback callback,
+                                 bill_stitching::ProgressCallback progress,
+                                 const bill_stitching::StitchConfig *config) {
+    bill_stitching::StitchConfig resolved;
+    if (!resolve_config(config, resolved)) {
+        return 0;
+    }
+    // Sao chép đường dẫn trước khi trả về vì bộ nhớ phía Dart được giải phóng ngay
+    std::vector<std::string> paths(imagePaths, imagePaths + numImages);
+    std::vector<int64> timestamps = to_timestamps(timestampsUs, numImages);
+    return bill_stitching::JobPool::instance().submit(
+            static_cast<bill_stitching::JobPriority>(priority),
+            [paths, timestamps, resolved, callback](bill_stitching::WorkerContext &context) {
+                const bill_stitching::StitchControl &control = *context.control;
+                bill_stitching::Composite result;
+                bill_stitching::FrameCounts counts;
+                bill_stitching::Registration registration;
+                bill_stitching::StitchResult *handle = nullptr;
+                try {
+                    // Stitcher của worker chỉ được tạo lại khi cấu hình của nó thay đổi
+                    if (resolved.engine == bill_stitching::ENGINE_STITCHER_SCANS &&
+                        (!context.stitcher ||
+                         !bill_stitching::sameStitcherSetup(context.stitcherConfig, resolved))) {
+                        context.stitcher = create_stitcher(resolved);
+                        context.stitcherConfig = resolved;
+                    }
+                    if (stitch_images_to_composite(paths, timestamps, resolved, context.stitcher, result,
+                                                   &control, &counts, &registration)) {
+                        control.progress(bill_stitching::STAGE_ENCODE, 0, 1);
+                        handle = new bill_stitching::StitchResult(result, counts);
+                        handle->setRegistration(registration);
+                        control.report(bill_stitching::STAGE_ENCODE, 1, 1);
+                    }
+                } catch (const bill_stitching::StitchCancelled &) {
+                } catch (const cv::Exception &e) {
+                    platform_log("Lỗi OpenCV: %s\n", e.what());
+                } catch (const std::exception &e) {
+                    // Ví dụ std::bad_alloc với bill dài: vẫn phải báo kết quả cho phía Dart
+                    platform_log("Lỗi: %s\n", e.what());
+                } catch (...) {
+                    platform_log("Đã xảy ra lỗi không xác định.\n");
+                }
+                int status = handle != nullptr ? bill_stitching::JOB_OK
+                           : control.cancelled() ? bill_stitching::JOB_CANCELLED
+                           : bill_stitching::JOB_FAILED;
+                callback(context.jobId, status, handle);
+            },
+            progress);
+}
+
+// Kết thúc phiên trong job pool; session phải còn sống tới khi callback được gọi
+int64_t stitch_job_submit_session(void *session, int priority,
+                                  bill_stitching::JobCompletionCallback callback,
+                                  bill_stitching::ProgressCallback progress) {
+    if (session == nullptr) {
+        return 0;
+    }
+    return bill_stitching::JobPool::instance().submit(
+            static_cast<bill_stitching::JobPriority>(priority),
+            [session, callback](bill_stitching::WorkerContext &context) {
+                const bill_stitching::StitchControl &control = *context.control;
+                bill_stitching::Composite result;
+                void *handle = nullptr;
+                try {
+                    if (static_cast<bill_stitching::StitchSession *>(session)->finalize(result, &control) ==
+                        bill_stitching::SESSION_OK) {
+                        control.progress(bill_stitching::STAGE_ENCODE, 0, 1);
+                        handle = new bill_stitching::StitchResult(result);
+                        control.report(bill_stitching::STAGE_ENCODE, 1, 1);
+                    }
+                } catch (const bill_stitching::StitchCancelled &) {
+                } catch (const cv::Exception &e) {
+                    platform_log("Lỗi OpenCV: %s\n", e.what());
+                } catch (const std::exception &e) {
+                    // Ví dụ std::bad_alloc với bill dài: vẫn phải báo kết quả cho phía Dart
+                    platform_log("Lỗi: %s\n", e.what());
+                } catch (...) {
+                    platform_log("Đã xảy ra lỗi không xác định.\n");
+                }
+                int status = handle != nullptr ? bill_stitching::JOB_OK
+                           : control.cancelled() ? bill_stitching::JOB_CANCELLED
+                           : bill_stitching::JOB_FAILED;
+                callback(context.jobId, status, handle);
+            },
+            progress);
+}
+
+// Như stitch_render_registration nhưng chạy trong job pool, kết quả báo qua callback
+int64_t stitch_job_submit_render(const char *registrationPath, double scale, int priority,
+                                 bill_stitching::JobCompletionCallback callback,
+                                 bill_stitching::ProgressCallback progress) {
+    if (registrationPath == nullptr) {
+        return 0;
+    }
+    std::string path(registrationPath);
+    return bill_stitching::JobPool::instance().submit(
+            static_cast<bill_stitching::JobPriority>(priority),
+            [path, scale, callback](bill_stitching::WorkerContext &context) {
+                const bill_stitching::StitchControl &control = *context.control;
+                bill_stitching::Composite result;
+                bill_stitching::Registration registration;
+                bill_stitching::StitchResult *handle = nullptr;
+                try {
+                    if (render_registration_to_composite(path, scale, control, result, registration)) {
+                        control.progress(bill_stitching::STAGE_ENCODE, 0, 1);
+                        handle = new bill_stitching::StitchResult(result);
+                        handle->setRegistration(registration);
+                        control.report(bill_stitching::STAGE_ENCODE, 1, 1);
+                    }
+                } catch (const bill_stitching::StitchCancelled &) {
+                } catch (const cv::Exception &e) {
+                    platform_log("Lỗi OpenCV: %s\n", e.what());
+                } catch (const std::exception &e) {
+                    platform_log("Lỗi: %s\n", e.what());
+                } catch (...) {
+                    platform_log("Đã xảy ra lỗi không xác định.\n");
+                }
+                int status = handle != nullptr ? bill_stitching::JOB_OK
+                           : control.cancelled() ? bill_stitching::JOB_CANCELLED
+                           : bill_stitching::JOB_FAILED;
+                callback(context.jobId, status, handle);
+            },
+            progress);
+}
+
+// Huỷ job đang chờ hoặc đang chạy; job sẽ báo JOB_CANCELLED qua callback
+void stitch_job_cancel(int64_t jobId) {
+    bill_stitching::JobPool::instance().cancel(jobId);
 }
 }
@@ -0,0 +1,24 @@
+#ifndef NATIVE_OPENCV_HPP
+#define NATIVE_OPENCV_HPP
+
+#include "opencv2/core/core.hpp"
+#include <string>
+
+// Tỉ lệ thu nhỏ ảnh trước khi ghép (độ phân giải làm việc)
+const double kWorkScale = 0.3;
+
+// Các hàm tiện ích dùng chung, được định nghĩa trong native_opencv.cpp
+long long int get_now();
+
+void platform_log(const char *fmt, ...);
+
+cv::Mat preprocess(cv::Mat img);
+
+// Đọc ảnh từ file và giảm kích thước về độ phân giải làm việc, chưa tiền xử lý.
+// Trả về Mat rỗng nếu không đọc được ảnh.
+cv::Mat load_work_image(const std::string &imagePath, double workScale = kWorkScale);
+
+// Như load_work_image, sau đó tiền xử lý.
+cv::Mat load_image(const std::string &imagePath);
+
+#endif //NATIVE_OPENCV_HPP
@@ -0,0 +1,135 @@
+#include "opencv2/opencv.hpp"
+#include "registration_store.hpp"
+#include "bill_stitching.hpp"
+#include "compositor.hpp"
+
+using namespace std;
+using namespace cv;
+
+namespace {
+    Mat scaleMatrix(double s) {
+        return (Mat_<double>(3, 3) << s, 0, 0, 0, s, 0, 0, 0, 1);
+    }
+}
+
+void cv::bill_stitching::scaleRegistration(Registration &registration, double factor) {
+    // Điểm p ở đơn vị cũ là p * factor ở đơn vị mới: H' = S * H * S^-1
+    const Mat S = scaleMatrix(factor), Sinv = scaleMatrix(1.0 / factor);
+    for (auto &H: registration.toCanvas) {
+        H = S * H * Sinv;
+    }
+    registration.canvasSize = Size(cvCeil(registration.canvasSize.width * factor),
+                                   cvCeil(registration.canvasSize.height * factor));
+    if (!registration.crop.empty()) {
+        const Point tl(cvFloor(registration.crop.x * factor), cvFloor(registration.crop.y * factor));
+        const Point br(cvCeil(registration.crop.br().x * factor), cvCeil(registration.crop.br().y * factor));
+        registration.crop = Rect(tl, br) & Rect(Point(), registration.canvasSize);
+    }
+}
+
+std::string cv::bill_stitching::registrationSidecarPath(const std::string &outputPath) {
+    return outputPath + ".reg.yml.gz";
+}
+
+bool cv::bill_stitching::writeRegistration(const std::string &path, const Registration &registration) {
+    CV_Assert(registration.paths.size() == registration.toCanvas.size() &&
+              registration.gains.size() == registration.toCanvas.size());
+    bool opened = false;
+    try {
+        FileStorage fs(path, FileStorage::WRITE);
+        if (!fs.isOpened()) {
+            stitching_log("Cannot open registration %s for writing\n", path.c_str());
+            return false;
+        }
+        opened = true;
+        fs << "version" << kRegistrationVersion;
+        fs << "engine" << registration.engine;
+        fs << "canvas" << registration.canvasSize;
+        fs << "crop" << registration.crop;
+        fs << "frames" << "[";
+        for (size_t i = 0; i < registration.toCanvas.size(); ++i) {
+            fs << "{" << "path" << registration.paths[i] << "H" << registration.toCanvas[i]
+               << "gain" << registration.gains[i] << "}";
+        }
+        fs << "]";
+        fs.release();
+
+        // release() không báo lỗi khi ghi hoặc nén thất bại (ví dụ hết dung lượng), nên
+        // đọc lại để chắc chắn sidecar dùng được trước khi báo thành công
+        Registration written;
+        if (readRegistration(path, written) && written.toCanvas.size() == registration.toCanvas.size()) {
+            return true;
+        }
+    } catch (const cv::Exception &e) {
+        stitching_log("Cannot write registration %s: %s\n", path.c_str(), e.what());
+    }
+    // Không để lại sidecar hỏng cho lần dựng lại sau
+    if (opened) {
+        std::remove(path.c_str());
+    }
+    return false;
+}
+
+bool cv::bill_stitching::readRegistration(const std::string &path, Registration &registration) {
+    FileStorage fs(path, FileStorage::READ);
+    if (!fs.isOpened() || static_cast<int>(fs["version"]) != kRegistrationVersion) {
+        stitching_log("Registration %s missing or of another version\n", path.c_str());
+        return false;
+    }
+    Registration loaded;
+    fs["engine"] >> loaded.engine;
+    fs["canvas"] >> loaded.canvasSize;
+    fs["crop"] >> loaded.crop;
+    const FileNode frames = fs["frames"];
+    for (auto it = frames.begin(); it != frames.end(); ++it) {
+        std::string framePath;
+        Mat H;
+        double gain = 1;
+        (*it)["path"] >> framePath;
+        (*it)["H"] >> H;
+        (*it)["gain"] >> gain;
+        if (framePath.empty() || H.rows != 3 || H.cols != 3) {
+            stitching_log("Registration %s has a malformed frame\n", path.c_str());
+            return false;
+        }
+        loaded.paths.push_back(framePath);
+        H.convertTo(H, CV_64F);
+        loaded.toCanvas.push_back(H);
+        loaded.gains.push_back(gain);
+    }
+    if (loaded.empty() || loaded.canvasSize.empty()) {
+        return false;
+    }
+    registration = loaded;
+    return true;
+}
+
+bool cv::bill_stitching::renderRegistration(const Registration &registration, double scale,
+                                            const std::function<Mat(const std::string &, double)> &load,
+                                            const StitchControl &control, Composite &result) {
+    Registration scaled = registration;
+    scaleRegistration(scaled, scale);
+    const int n = static_cast<int>(scaled.toCanvas.size());
+    stitching_log("Rendering %d frames at %.2fx into %dx%d\n", n, scale, scaled.canvasSize.width,
+                  scaled.canvasSize.height);
+
+    Compositor &compositor = result.compositor;
+    compositor.reset(scaled.canvasSize);
+    result.region = scaled.crop;
+    result.image.release();
+    control.progress(STAGE_BLENDING, 0, n);
+    for (int i = 0; i < n; ++i) {
+        control.checkpoint();
+        Mat image = load(scaled.paths[i], scale);
+        if (image.empty()) {
+            stitching_log("Source %s could not be reloaded\n", scaled.paths[i].c_str());
+            return false;
+        }
+        if (std::abs(scaled.gains[i] - 1) > 1e-3) {
+            image.convertTo(image, -1, scaled.gains[i]);
+        }
+        compositor.feed(image, scaled.toCanvas[i]);
+        control.report(STAGE_BLENDING, i + 1, n);
+    }
+    return !result.empty();
+}
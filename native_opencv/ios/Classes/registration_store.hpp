@@ -0,0 +1,52 @@
+#ifndef REGISTRATION_STORE_HPP
+#define REGISTRATION_STORE_HPP
+
+#include "opencv2/core/core.hpp"
+#include "compositor.hpp"
+#include "stitch_control.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace cv {
+    namespace bill_stitching {
+        const int kRegistrationVersion = 1;
+
+        // Kết quả đăng ký của một lần ghép, đủ để dựng lại ảnh ghép mà không phải tìm và
+        // ghép features lại: phép biến đổi toàn cục của từng frame, thứ tự frame, vùng cắt
+        // và hệ số phơi sáng. Toạ độ tính theo pixel ở một tỉ lệ chung cho cả frame và
+        // canvas (sau khi lưu: tỉ lệ 1 = độ phân giải của ảnh gốc).
+        struct Registration {
+            int engine = 0;                    // StitchEngine that produced it
+            cv::Size canvasSize;
+            cv::Rect crop;                     // in canvas px; empty = covered area
+            std::vector<std::string> paths;    // source photos, in composition order
+            std::vector<cv::Mat> toCanvas;     // 3x3 CV_64F, frame px -> canvas px
+            std::vector<double> gains;         // exposure gain per frame, 1 = unchanged
+
+            bool empty() const { return toCanvas.empty(); }
+        };
+
+        // Đổi đơn vị toạ độ: mọi toạ độ (frame và canvas) được nhân với `factor`.
+        void scaleRegistration(Registration &registration, double factor);
+
+        // "<output>.reg.yml.gz": FileStorage, gzip-compressed.
+        std::string registrationSidecarPath(const std::string &outputPath);
+
+        // Returns false, leaving no file behind, if the sidecar could not be written and
+        // read back.
+        bool writeRegistration(const std::string &path, const Registration &registration);
+
+        // Returns false if the file is missing, malformed or of another version.
+        bool readRegistration(const std::string &path, Registration &registration);
+
+        // Dựng lại ảnh ghép ở tỉ lệ `scale` so với ảnh gốc: chỉ đọc lại, warp và trộn từng
+        // frame vào `result`. `load(path, scale)` decodes and preprocesses one source photo.
+        // Returns false if a source fails to load.
+        bool renderRegistration(const Registration &registration, double scale,
+                                const std::function<cv::Mat(const std::string &, double)> &load,
+                                const StitchControl &control, Composite &result);
+    }
+}
+
+#endif //REGISTRATION_STORE_HPP
@@ -0,0 +1,140 @@
+#include "opencv2/opencv.hpp"
+#include "scan_guidance.hpp"
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+using namespace cv;
+
+namespace {
+    // Cạnh dài nhất của ảnh dùng để tính profile và dịch chuyển lớn nhất giữa hai frame
+    // preview liên tiếp được tìm kiếm (theo tỉ lệ frame)
+    const int kProfileMaxDim = 160;
+    const double kMaxStepFraction = 0.33;
+    // Thời gian phơi sáng giả định của preview và độ nhoè (px ở độ phân giải đầy đủ)
+    // được coi là chắc chắn mờ
+    const double kAssumedExposureS = 1.0 / 60;
+    const double kMaxBlurPx = 4.0;
+    // Dưới ngưỡng này profile quá phẳng (giấy trắng), dùng vận tốc để ngoại suy
+    const double kMinConfidence = 0.3;
+
+    // Đạo hàm của profile cường độ trung bình theo hàng (dim = 1) hoặc theo cột
+    // (dim = 0); đạo hàm không bị ảnh hưởng bởi thay đổi phơi sáng chậm
+    Mat profileGradient(const Mat &luma, int dim) {
+        Mat profile;
+        reduce(luma, profile, dim, REDUCE_AVG, CV_32F);
+        profile = profile.reshape(1, 1);
+        Mat gradient = profile.colRange(1, profile.cols) - profile.colRange(0, profile.cols - 1);
+        return gradient;
+    }
+
+    // Tìm s sao cho cur[i + s] ~ prev[i] (nội dung dịch đi s mẫu), tinh chỉnh sub-sample
+    // bằng parabol qua ba chi phí quanh cực tiểu. confidence so sánh chi phí tốt nhất
+    // với chi phí trung vị.
+    double alignProfiles(const Mat &prev, const Mat &cur, int maxShift, double &confidence) {
+        const float *a = prev.ptr<float>(), *b = cur.ptr<float>();
+        const int n = prev.cols;
+        vector<double> costs(2 * maxShift + 1);
+        for (int s = -maxShift; s <= maxShift; ++s) {
+            const int from = std::max(0, -s), to = std::min(n, n - s);
+            double sum = 0;
+            for (int i = from; i < to; ++i) {
+                const double d = a[i] - b[i + s];
+                sum += d * d;
+            }
+            costs[s + maxShift] = sum / std::max(1, to - from);
+        }
+
+        const int best = static_cast<int>(min_element(costs.begin(), costs.end()) - costs.begin());
+        vector<double> sorted = costs;
+        nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+        const double median = sorted[sorted.size() / 2];
+        confidence = median > 1e-9 ? std::max(0.0, 1.0 - costs[best] / median) : 0;
+
+        double shift = best - maxShift;
+        if (best > 0 && best < static_cast<int>(costs.size()) - 1) {
+            const double l = costs[best - 1], c = costs[best], r = costs[best + 1];
+            const double denom = l - 2 * c + r;
+            if (denom > 1e-12) {
+                shift += 0.5 * (l - r) / denom;
+            }
+        }
+        return shift;
+    }
+}
+
+cv::bill_stitching::ScanGuide::ScanGuide(const GuidanceParams &params) : params_(params) {}
+
+void cv::bill_stitching::ScanGuide::reset() {
+    prevRows_.release();
+    prevCols_.release();
+    sinceCapture_ = Point2d();
+    velocity_ = Point2d();
+    prevTimestampUs_ = 0;
+    hasReference_ = false;
+}
+
+void cv::bill_stitching::ScanGuide::markCaptured() {
+    sinceCapture_ = Point2d();
+    hasReference_ = true;
+}
+
+cv::bill_stitching::Guidance cv::bill_stitching::ScanGuide::update(const Mat &luma, int rotation, int64 timestampUs) {
+    CV_Assert(luma.type() == CV_8UC1 && !luma.empty());
+    const double scale = std::min(1.0, static_cast<double>(kProfileMaxDim) / std::max(luma.cols, luma.rows));
+    Mat small;
+    if (scale < 1.0) {
+        resize(luma, small, Size(), scale, scale, INTER_AREA);
+    } else {
+        small = luma;
+    }
+    if (rotation != 0) {
+        rotate(small, small, rotation == 90 ? ROTATE_90_CLOCKWISE
+                           : rotation == 180 ? ROTATE_180
+                           : ROTATE_90_COUNTERCLOCKWISE);
+    }
+    Mat rows = profileGradient(small, 1), cols = profileGradient(small, 0);
+
+    Guidance guidance;
+    guidance.confidence = 1;
+    if (!prevRows_.empty() && prevRows_.size() == rows.size() && prevCols_.size() == cols.size()) {
+        double confidenceY = 0, confidenceX = 0;
+        const double dy = alignProfiles(prevRows_, rows, cvRound(kMaxStepFraction * rows.cols), confidenceY);
+        const double dx = alignProfiles(prevCols_, cols, cvRound(kMaxStepFraction * cols.cols), confidenceX);
+        guidance.confidence = std::min(confidenceX, confidenceY);
+
+        const double dtS = timestampUs > prevTimestampUs_ ? (timestampUs - prevTimestampUs_) * 1e-6 : 0;
+        const Point2d predicted = velocity_ * dtS;
+        const Point2d step(confidenceX >= kMinConfidence ? dx / small.cols : predicted.x,
+                           confidenceY >= kMinConfidence ? dy / small.rows : predicted.y);
+        if (dtS > 0) {
+            velocity_ = step / dtS;
+        }
+        sinceCapture_ += step;
+    } else {
+        velocity_ = Point2d();
+        sinceCapture_ = Point2d();
+    }
+    prevRows_ = rows;
+    prevCols_ = cols;
+    prevTimestampUs_ = timestampUs;
+    fullSize_ = rotation == 90 || rotation == 270 ? Size(luma.rows, luma.cols) : luma.size();
+
+    guidance.displacement = sinceCapture_;
+    guidance.velocity = velocity_;
+    guidance.overlap = hasReference_
+                       ? std::max(0.0, 1 - std::abs(sinceCapture_.x)) * std::max(0.0, 1 - std::abs(sinceCapture_.y))
+                       : 0;
+    const double speedPx = norm(Point2d(velocity_.x * fullSize_.width, velocity_.y * fullSize_.height));
+    guidance.blurRisk = std::min(1.0, speedPx * kAssumedExposureS / kMaxBlurPx);
+
+    const bool sharp = guidance.blurRisk <= params_.maxBlurRisk;
+    if (!hasReference_) {
+        guidance.captureNow = sharp;
+    } else {
+        // Đủ xa lần chụp trước thì chụp khi ảnh nét; sắp hết chồng lấp thì chụp luôn
+        guidance.captureNow = guidance.overlap <= params_.minOverlap ||
+                              (guidance.overlap <= params_.captureOverlap && sharp);
+    }
+    return guidance;
+}
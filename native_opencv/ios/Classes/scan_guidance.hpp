@@ -0,0 +1,55 @@
+#ifndef SCAN_GUIDANCE_HPP
+#define SCAN_GUIDANCE_HPP
+
+#include "opencv2/core/core.hpp"
+
+namespace cv {
+    namespace bill_stitching {
+        struct GuidanceParams {
+            double captureOverlap = 0.5;     // chụp khi độ chồng lấp với lần chụp cuối giảm tới mức này
+            double minOverlap = 0.25;        // dưới mức này thì chụp cả khi frame có thể bị mờ
+            double maxBlurRisk = 0.5;        // trên mức này thì chờ người dùng di chuyển chậm lại
+        };
+
+        // Kết quả cho một frame preview. Dịch chuyển và vận tốc tính theo tỉ lệ kích thước
+        // frame (1.0 = cả frame), dương là nội dung trôi sang phải/xuống dưới.
+        struct Guidance {
+            cv::Point2d displacement;        // dịch chuyển nội dung từ frame chụp cuối
+            cv::Point2d velocity;            // frame mỗi giây
+            double overlap = 0;              // tỉ lệ diện tích chung với frame chụp cuối
+            double blurRisk = 0;             // 0..1, theo chuyển động trong một lần phơi sáng
+            double confidence = 0;           // 0..1, độ khớp của bước căn chỉnh gần nhất
+            bool captureNow = false;
+        };
+
+        // Hướng dẫn quét trực tiếp từ frame preview: ước lượng dịch chuyển giữa các frame
+        // liên tiếp bằng cách so khớp projection profile theo hàng và cột (1-D) của ảnh
+        // sáng đã thu nhỏ, cộng dồn từ lần chụp cuối để biết độ chồng lấp còn lại và
+        // quyết định thời điểm chụp. Mỗi lần gọi chỉ tốn vài trăm micro giây.
+        class ScanGuide {
+        public:
+            explicit ScanGuide(const GuidanceParams &params = GuidanceParams());
+
+            // `luma` là ảnh sáng CV_8U của preview (kích thước bất kỳ, được thu nhỏ bên trong),
+            // `rotation` là số độ xoay theo chiều kim đồng hồ (0, 90, 180, 270) để ảnh đứng
+            // thẳng. Trước lần markCaptured() đầu tiên, mọi frame đủ nét đều yêu cầu chụp.
+            Guidance update(const cv::Mat &luma, int rotation, int64 timestampUs);
+
+            // Frame của lần update() gần nhất đã được chụp và trở thành frame tham chiếu.
+            void markCaptured();
+
+            void reset();
+
+        private:
+            GuidanceParams params_;
+            cv::Mat prevRows_, prevCols_;   // gradient của profile theo hàng/cột, CV_32F
+            cv::Size fullSize_;
+            cv::Point2d sinceCapture_;
+            cv::Point2d velocity_;
+            int64 prevTimestampUs_ = 0;
+            bool hasReference_ = false;
+        };
+    }
+}
+
+#endif //SCAN_GUIDANCE_HPP
@@ -0,0 +1,97 @@
+#include "opencv2/opencv.hpp"
+#include "sequential_matcher.hpp"
+#include "bill_stitching.hpp"
+#include "stitch_control.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::detail;
+
+namespace {
+    // Mask n x n cho các cặp (i, j) với from <= j - i <= to, giao với mask của Stitcher
+    Mat bandMask(int n, int from, int to, const UMat &userMask) {
+        Mat mask = Mat::zeros(n, n, CV_8U);
+        for (int i = 0; i < n; ++i) {
+            for (int j = i + from; j <= std::min(n - 1, i + to); ++j) {
+                mask.at<uchar>(i, j) = 1;
+            }
+        }
+        if (!userMask.empty()) {
+            Mat user = userMask.getMat(ACCESS_READ);
+            mask &= user != 0;
+        }
+        return mask;
+    }
+}
+
+cv::bill_stitching::SequentialMatcher::SequentialMatcher(const Ptr<FeaturesMatcher> &matcher, int window,
+                                                        bool verify, double confThresh)
+        : FeaturesMatcher(matcher->isThreadSafe()), matcher_(matcher), window_(window), verify_(verify),
+          confThresh_(confThresh) {}
+
+int cv::bill_stitching::SequentialMatcher::numPairs(int numImages) const {
+    if (window_ <= 0 || window_ >= numImages) {
+        return numImages * (numImages - 1) / 2;
+    }
+    // n-1 cặp kề nhau, n-2 cặp cách một ảnh, ...
+    return window_ * numImages - window_ * (window_ + 1) / 2;
+}
+
+void cv::bill_stitching::SequentialMatcher::match(const ImageFeatures &features1,
+                                                  const ImageFeatures &features2,
+                                                  MatchesInfo &matches_info) {
+    (*matcher_)(features1, features2, matches_info);
+}
+
+void cv::bill_stitching::SequentialMatcher::match(const vector<ImageFeatures> &features,
+                                                  vector<MatchesInfo> &pairwise_matches,
+                                                  const UMat &mask) {
+    const int n = static_cast<int>(features.size());
+    if (window_ <= 0 || window_ >= n - 1) {
+        (*matcher_)(features, pairwise_matches, mask);
+        return;
+    }
+
+    // Lần 1: chỉ các cặp trong cửa sổ. Mat phải sống lâu hơn UMat lấy từ nó.
+    Mat band = bandMask(n, 1, window_, mask);
+    (*matcher_)(features, pairwise_matches, band.getUMat(ACCESS_READ));
+    if (!verify_) {
+        return;
+    }
+
+    // Lần 2: ảnh không ghép được với ảnh nào phía sau trong cửa sổ thì nới rộng cửa sổ
+    Mat retry = Mat::zeros(n, n, CV_8U);
+    Mat widened = bandMask(n, window_ + 1, 2 * window_, mask);
+    int numRetries = 0;
+    for (int i = 0; i < n - 1; ++i) {
+        double best = 0;
+        for (int j = i + 1; j <= std::min(n - 1, i + window_); ++j) {
+            best = std::max(best, pairwise_matches[i * n + j].confidence);
+        }
+        if (best < confThresh_ && countNonZero(widened.row(i)) > 0) {
+            widened.row(i).copyTo(retry.row(i));
+            ++numRetries;
+        }
+    }
+    if (numRetries == 0) {
+        return;
+    }
+    stitching_log("Sequential matcher: widening window for %d images\n", numRetries);
+    // Tiến độ ghép cặp tính cả các cặp thử lại, để không vượt quá 100%
+    if (auto controlled = matcher_.dynamicCast<ControlledMatcher>()) {
+        controlled->extend(countNonZero(retry));
+    }
+
+    vector<MatchesInfo> extra;
+    (*matcher_)(features, extra, retry.getUMat(ACCESS_READ));
+    for (int i = 0; i < n; ++i) {
+        for (int j = i + 1; j < n; ++j) {
+            if (retry.at<uchar>(i, j) == 0) {
+                continue;
+            }
+            // Giữ cả hai chiều (i, j) và (j, i) như matcher gốc trả về
+            pairwise_matches[i * n + j] = extra[i * n + j];
+            pairwise_matches[j * n + i] = extra[j * n + i];
+        }
+    }
+}
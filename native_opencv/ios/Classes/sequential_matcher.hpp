@@ -0,0 +1,47 @@
+#ifndef SEQUENTIAL_MATCHER_HPP
+#define SEQUENTIAL_MATCHER_HPP
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/stitching/detail/matchers.hpp"
+
+namespace cv {
+    namespace bill_stitching {
+        // Matcher chỉ ghép các ảnh lân cận theo thứ tự chụp: cặp (i, i+1..i+window).
+        // Bill được quét từ trên xuống nên ảnh chỉ chồng lên các ảnh kề nó, và số cặp
+        // cần ghép tăng tuyến tính theo số ảnh thay vì O(n²).
+        //
+        // Khi bật verify, ảnh nào không có cặp nào trong cửa sổ đạt `confThresh` sẽ
+        // được ghép thêm với `window` ảnh kế tiếp ngoài cửa sổ (ví dụ khi một frame
+        // bị mờ nằm giữa hai frame tốt).
+        class SequentialMatcher : public cv::detail::FeaturesMatcher {
+        public:
+            // window <= 0 matches every pair, like the wrapped matcher.
+            SequentialMatcher(const cv::Ptr<cv::detail::FeaturesMatcher> &matcher, int window,
+                              bool verify = true, double confThresh = 1.0);
+
+            const cv::Ptr<cv::detail::FeaturesMatcher> &inner() const { return matcher_; }
+
+            // Number of pairs matched by the first pass for `numImages` images.
+            int numPairs(int numImages) const;
+
+            void collectGarbage() CV_OVERRIDE { matcher_->collectGarbage(); }
+
+        protected:
+            void match(const cv::detail::ImageFeatures &features1,
+                       const cv::detail::ImageFeatures &features2,
+                       cv::detail::MatchesInfo &matches_info) CV_OVERRIDE;
+
+            void match(const std::vector<cv::detail::ImageFeatures> &features,
+                       std::vector<cv::detail::MatchesInfo> &pairwise_matches,
+                       const cv::UMat &mask) CV_OVERRIDE;
+
+        private:
+            cv::Ptr<cv::detail::FeaturesMatcher> matcher_;
+            int window_;
+            bool verify_;
+            double confThresh_;
+        };
+    }
+}
+
+#endif //SEQUENTIAL_MATCHER_HPP
@@ -0,0 +1,112 @@
+#include "opencv2/opencv.hpp"
+#include "opencv2/stitching/detail/util.hpp"
+#include "source_compose.hpp"
+#include "bill_stitching.hpp"
+#include "compositor.hpp"
+#include <algorithm>
+
+using namespace std;
+using namespace cv;
+using namespace cv::detail;
+
+namespace {
+    // Warper, camera và vùng canvas của `stitcher` ở `scale` px trên mỗi px ảnh đầu vào
+    struct StitcherWarp {
+        Ptr<RotationWarper> warper;
+        vector<int> component;
+        vector<Mat> K, R;
+        vector<Size> sizes;       // input image sizes at `scale`
+        Rect dst;
+    };
+
+    StitcherWarp setupWarp(const Stitcher &stitcher, const vector<Size> &inputSizes, double scale) {
+        StitcherWarp warp;
+        warp.component = stitcher.component();
+        vector<CameraParams> cameras = stitcher.cameras();
+        const int n = static_cast<int>(warp.component.size());
+        CV_Assert(static_cast<int>(cameras.size()) == n && n > 0);
+
+        // Tỉ lệ warp: trung vị tiêu cự ở độ phân giải làm việc, như Stitcher
+        vector<double> focals;
+        for (const auto &camera: cameras) {
+            focals.push_back(camera.focal);
+        }
+        std::sort(focals.begin(), focals.end());
+        const double warpedScale = n % 2 == 1 ? focals[n / 2] : (focals[n / 2 - 1] + focals[n / 2]) * 0.5;
+
+        // Camera được ước lượng ở workScale của stitcher, nhân lên tới tỉ lệ cần ghép
+        const double aspect = scale / stitcher.workScale();
+        warp.warper = stitcher.warper()->create(static_cast<float>(warpedScale * aspect));
+        warp.K.resize(n);
+        warp.R.resize(n);
+        warp.sizes.resize(n);
+        vector<Point> corners(n);
+        vector<Size> roiSizes(n);
+        for (int i = 0; i < n; ++i) {
+            cameras[i].focal *= aspect;
+            cameras[i].ppx *= aspect;
+            cameras[i].ppy *= aspect;
+            cameras[i].K().convertTo(warp.K[i], CV_32F);
+            cameras[i].R.convertTo(warp.R[i], CV_32F);
+            const Size &input = inputSizes[warp.component[i]];
+            warp.sizes[i] = Size(cvRound(input.width * scale), cvRound(input.height * scale));
+            const Rect roi = warp.warper->warpRoi(warp.sizes[i], warp.K[i], warp.R[i]);
+            corners[i] = roi.tl();
+            roiSizes[i] = roi.size();
+        }
+        warp.dst = resultRoi(corners, roiSizes);
+        return warp;
+    }
+}
+
+bool cv::bill_stitching::composeStitcherFromSources(Stitcher &stitcher, const vector<Size> &inputSizes,
+                                                    const ComposeSource &source, const StitchControl &control,
+                                                    Composite &result) {
+    const StitcherWarp warp = setupWarp(stitcher, inputSizes, source.scale);
+    const int n = static_cast<int>(warp.component.size());
+    stitching_log("Composing %d sources at %.2fx into %dx%d\n", n, source.scale, warp.dst.width,
+                  warp.dst.height);
+
+    Compositor &compositor = result.compositor;
+    compositor.reset(warp.dst.size());
+    result.region = Rect();
+    result.image.release();
+    control.progress(STAGE_BLENDING, 0, n);
+    for (int i = 0; i < n; ++i) {
+        control.checkpoint();
+        Mat image = source.load(warp.component[i]);
+        if (image.empty()) {
+            stitching_log("Source %d could not be reloaded\n", warp.component[i]);
+            return false;
+        }
+        Mat warped, mask;
+        const Point tl = warp.warper->warp(image, warp.K[i], warp.R[i], INTER_LINEAR, BORDER_REFLECT, warped);
+        warp.warper->warp(Mat(image.size(), CV_8U, Scalar(255)), warp.K[i], warp.R[i], INTER_NEAREST,
+                          BORDER_CONSTANT, mask);
+        image.release();
+        compositor.feedWarped(warped, mask, tl - warp.dst.tl());
+        control.report(STAGE_BLENDING, i + 1, n);
+    }
+    return !result.empty();
+}
+
+void cv::bill_stitching::stitcherRegistration(const Stitcher &stitcher, const vector<Size> &inputSizes,
+                                              Registration &registration) {
+    const StitcherWarp warp = setupWarp(stitcher, inputSizes, 1.0);
+    const int n = static_cast<int>(warp.component.size());
+    registration.canvasSize = warp.dst.size();
+    registration.crop = Rect();
+    registration.toCanvas.clear();
+    for (int i = 0; i < n; ++i) {
+        // Warper của SCANS (affine) là một phép chiếu phẳng, nên 4 góc xác định đúng nó
+        const Size &size = warp.sizes[i];
+        const Point2f corners[4] = {Point2f(0, 0), Point2f(static_cast<float>(size.width), 0),
+                                    Point2f(static_cast<float>(size.width), static_cast<float>(size.height)),
+                                    Point2f(0, static_cast<float>(size.height))};
+        Point2f mapped[4];
+        for (int c = 0; c < 4; ++c) {
+            mapped[c] = warp.warper->warpPoint(corners[c], warp.K[i], warp.R[i]) - Point2f(warp.dst.tl());
+        }
+        registration.toCanvas.push_back(getPerspectiveTransform(corners, mapped));
+    }
+}
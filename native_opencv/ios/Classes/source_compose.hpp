@@ -0,0 +1,39 @@
+#ifndef SOURCE_COMPOSE_HPP
+#define SOURCE_COMPOSE_HPP
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/stitching.hpp"
+#include "compositor.hpp"
+#include "registration_store.hpp"
+#include "stitch_control.hpp"
+#include <functional>
+#include <vector>
+
+namespace cv {
+    namespace bill_stitching {
+        // Ảnh nguồn để ghép ở độ phân giải cao hơn độ phân giải đã dùng để đăng ký.
+        // `load(i)` đọc lại frame thứ i (theo thứ tự đã đưa vào bước đăng ký), đã tiền
+        // xử lý, với kích thước xấp xỉ `scale` lần ảnh đã đăng ký. Mỗi frame chỉ được
+        // đọc khi tới lượt ghép và giải phóng ngay sau đó.
+        struct ComposeSource {
+            std::function<cv::Mat(int index)> load;
+            double scale = 1;              // compose px per registration-input px
+        };
+
+        // Ghép lại panorama của `stitcher` (đã estimateTransform trên các ảnh proxy có kích
+        // thước `inputSizes`) từ ảnh nguồn: camera được nhân tỉ lệ như trong
+        // Stitcher::composePanorama, mỗi ảnh được warp bằng warper của stitcher và trộn vào
+        // canvas dạng tile của `result`. Returns false if a source fails to load.
+        bool composeStitcherFromSources(cv::Stitcher &stitcher, const std::vector<cv::Size> &inputSizes,
+                                        const ComposeSource &source, const StitchControl &control,
+                                        Composite &result);
+
+        // Registration của `stitcher` (đã estimateTransform) theo pixel của ảnh đầu vào: một
+        // phép biến đổi 3x3 cho mỗi frame trong stitcher.component(), theo thứ tự đó.
+        // Canvas là vùng panorama; crop để trống (= vùng đã phủ).
+        void stitcherRegistration(const cv::Stitcher &stitcher, const std::vector<cv::Size> &inputSizes,
+                                  Registration &registration);
+    }
+}
+
+#endif //SOURCE_COMPOSE_HPP
@@ -0,0 +1,18 @@
+#include "stage_pipeline.hpp"
+
+using namespace std;
+using namespace cv;
+
+void cv::bill_stitching::logStageStats(const char *label, const vector<StageStats> &stats) {
+    size_t bottleneck = 0;
+    for (size_t i = 0; i < stats.size(); ++i) {
+        if (stats[i].busyMs > stats[bottleneck].busyMs) {
+            bottleneck = i;
+        }
+    }
+    for (size_t i = 0; i < stats.size(); ++i) {
+        stitching_log("%s: stage %-10s %3d items, busy %6.0f ms, utilization %3.0f%%%s\n", label,
+                      stats[i].name.c_str(), stats[i].items, stats[i].busyMs,
+                      stats[i].utilization * 100.0, i == bottleneck ? " (bottleneck)" : "");
+    }
+}
@@ -0,0 +1,245 @@
+#ifndef STAGE_PIPELINE_HPP
+#define STAGE_PIPELINE_HPP
+
+#include "opencv2/core/core.hpp"
+#include "bill_stitching.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cv {
+    namespace bill_stitching {
+        // Hàng đợi có giới hạn giữa hai stage: push chặn khi đầy (backpressure),
+        // pop chặn khi rỗng cho đến khi hàng đợi bị đóng.
+        template<typename T>
+        class BoundedQueue {
+        public:
+            explicit BoundedQueue(size_t capacity) : capacity_(std::max<size_t>(1, capacity)) {}
+
+            // Trả về false nếu hàng đợi bị đóng trước khi item được đưa vào.
+            bool push(T &&item) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                notFull_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+                if (closed_) {
+                    return false;
+                }
+                items_.push_back(std::move(item));
+                notEmpty_.notify_one();
+                return true;
+            }
+
+            // Trả về false khi hàng đợi đã đóng và không còn item.
+            bool pop(T &item) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                notEmpty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+                if (items_.empty()) {
+                    return false;
+                }
+                item = std::move(items_.front());
+                items_.pop_front();
+                notFull_.notify_one();
+                return true;
+            }
+
+            // Bỏ mọi item đang chờ, trả về số item đã bỏ.
+            size_t clear() {
+                std::lock_guard<std::mutex> lock(mutex_);
+                size_t dropped = items_.size();
+                items_.clear();
+                notFull_.notify_all();
+                return dropped;
+            }
+
+            void close() {
+                std::lock_guard<std::mutex> lock(mutex_);
+                closed_ = true;
+                notEmpty_.notify_all();
+                notFull_.notify_all();
+            }
+
+        private:
+            const size_t capacity_;
+            std::deque<T> items_;
+            bool closed_ = false;
+            std::mutex mutex_;
+            std::condition_variable notEmpty_;
+            std::condition_variable notFull_;
+        };
+
+        struct StageStats {
+            std::string name;
+            int items = 0;              // số item đã rời stage
+            double busyMs = 0;          // thời gian chạy trong hàm của stage
+            double utilization = 0;     // busyMs / thời gian chạy của pipeline
+        };
+
+        // Ghi log mỗi stage một dòng; stage bận nhất là stage giới hạn thông lượng.
+        void logStageStats(const char *label, const std::vector<StageStats> &stats);
+
+        // Pipeline nhiều stage, mỗi stage một thread với hàng đợi riêng, để frame k+1
+        // được giải mã trong khi frame k đang tìm features và cặp (k-1, k) đang được
+        // ghép. Mỗi stage xử lý tuần tự nên thứ tự frame được giữ nguyên và stage có
+        // thể giữ trạng thái (ví dụ frame trước đó). Bộ nhớ bị chặn bởi độ sâu hàng đợi.
+        template<typename T>
+        class StagePipeline {
+        public:
+            // Trả về false để bỏ item (ví dụ frame không đọc được hoặc không đăng ký được);
+            // item làm hàm của stage ném exception cũng được ghi log và bỏ đi.
+            typedef std::function<bool(T &)> StageFn;
+
+            StagePipeline() = default;
+
+            ~StagePipeline() { stop(); }
+
+            StagePipeline(const StagePipeline &) = delete;
+
+            StagePipeline &operator=(const StagePipeline &) = delete;
+
+            // Gọi trước start(). `capacity` giới hạn hàng đợi đầu vào của stage.
+            void addStage(const std::string &name, StageFn fn, size_t capacity = 2) {
+                CV_Assert(threads_.empty());
+                auto stage = std::make_shared<Stage>(capacity);
+                stage->name = name;
+                stage->fn = std::move(fn);
+                stages_.push_back(stage);
+            }
+
+            void start() {
+                CV_Assert(threads_.empty() && !stages_.empty());
+                start_ = getTickCount();
+                for (size_t i = 0; i < stages_.size(); ++i) {
+                    threads_.emplace_back(&StagePipeline::run, this, i);
+                }
+            }
+
+            // Chặn khi hàng đợi của stage đầu tiên đầy.
+            void push(T item) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    ++inFlight_;
+                }
+                if (!stages_.front()->input.push(std::move(item))) {
+                    finish(1);
+                }
+            }
+
+            // Chờ tới khi mọi item đã push rời khỏi pipeline.
+            void waitIdle() {
+                std::unique_lock<std::mutex> lock(mutex_);
+                idle_.wait(lock, [this] { return inFlight_ == 0; });
+            }
+
+            // Như waitIdle() nhưng có timeout; trả về true nếu đã rảnh.
+            template<typename Rep, typename Period>
+            bool waitIdleFor(const std::chrono::duration<Rep, Period> &timeout) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                return idle_.wait_for(lock, timeout, [this] { return inFlight_ == 0; });
+            }
+
+            // Bỏ các item đang chờ; item đang nằm trong hàm của stage vẫn chạy xong.
+            void discard() {
+                for (auto &stage: stages_) {
+                    finish(stage->input.clear());
+                }
+            }
+
+            // Đóng các hàng đợi và join thread của các stage; item đang chờ bị bỏ.
+            void stop() {
+                if (threads_.empty()) {
+                    return;
+                }
+                discard();
+                for (auto &stage: stages_) {
+                    stage->input.close();
+                }
+                for (auto &thread: threads_) {
+                    thread.join();
+                }
+                threads_.clear();
+            }
+
+            std::vector<StageStats> stats() const {
+                const double wallMs = (getTickCount() - start_) * 1000.0 / getTickFrequency();
+                std::vector<StageStats> result;
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (const auto &stage: stages_) {
+                    StageStats s;
+                    s.name = stage->name;
+                    s.items = stage->items;
+                    s.busyMs = stage->busyMs;
+                    s.utilization = wallMs > 0 ? stage->busyMs / wallMs : 0;
+                    result.push_back(s);
+                }
+                return result;
+            }
+
+        private:
+            struct Stage {
+                explicit Stage(size_t capacity) : input(capacity) {}
+
+                std::string name;
+                StageFn fn;
+                BoundedQueue<T> input;
+                int items = 0;
+                double busyMs = 0;
+            };
+
+            void run(size_t index) {
+                Stage &stage = *stages_[index];
+                Stage *next = index + 1 < stages_.size() ? stages_[index + 1].get() : nullptr;
+                T item;
+                while (stage.input.pop(item)) {
+                    int64 start = getTickCount();
+                    bool keep = false;
+                    try {
+                        keep = stage.fn(item);
+                    } catch (const cv::Exception &e) {
+                        stitching_log("Pipeline stage %s: OpenCV error: %s\n", stage.name.c_str(), e.what());
+                    } catch (const std::exception &e) {
+                        // Ví dụ std::bad_alloc: không để exception thoát khỏi thread, bỏ item
+                        stitching_log("Pipeline stage %s: error: %s\n", stage.name.c_str(), e.what());
+                    } catch (...) {
+                        stitching_log("Pipeline stage %s: unknown error\n", stage.name.c_str());
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        stage.busyMs += (getTickCount() - start) * 1000.0 / getTickFrequency();
+                        ++stage.items;
+                    }
+                    if (!keep || next == nullptr || !next->input.push(std::move(item))) {
+                        finish(1);
+                    }
+                    item = T();
+                }
+            }
+
+            void finish(size_t count) {
+                if (count == 0) {
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(mutex_);
+                inFlight_ -= static_cast<int>(count);
+                if (inFlight_ == 0) {
+                    idle_.notify_all();
+                }
+            }
+
+            std::vector<std::shared_ptr<Stage>> stages_;
+            std::vector<std::thread> threads_;
+            int64 start_ = 0;
+            int inFlight_ = 0;
+            mutable std::mutex mutex_;
+            std::condition_variable idle_;
+        };
+    }
+}
+
+#endif //STAGE_PIPELINE_HPP
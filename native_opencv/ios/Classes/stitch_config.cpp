@@ -0,0 +1,133 @@
+#include "opencv2/opencv.hpp"
+#include "stitch_config.hpp"
+#include "bill_stitching.hpp"
+#include "native_opencv.hpp"
+#include "upright_features.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::detail;
+
+cv::bill_stitching::StitchConfig cv::bill_stitching::defaultStitchConfig() {
+    StitchConfig config;
+    config.version = kStitchConfigVersion;
+    config.engine = ENGINE_STITCHER_SCANS;
+    // ORB nhanh hơn SIFT nhiều; ANMS sau đó rải đều features trên các vùng chữ dày đặc
+    config.detector = DETECTOR_ORB;
+    config.detectorFeatures = 8000;
+    config.maxFeatures = 4000;
+    // Mỗi ảnh chỉ được ghép với matchWindow ảnh kế tiếp theo thứ tự chụp
+    config.matchWindow = 2;
+    config.workScale = kWorkScale;
+    config.registrationMegapix = 0.6;
+    config.seamMegapix = 0.1;
+    config.composeMegapix = 1;
+    config.matchConfidence = 0.3;
+    // Ngưỡng tin cậy để giữ một ảnh trong panorama (cũng dùng để kiểm tra lại cặp ảnh)
+    config.panoConfidenceThresh = 0.92;
+    config.blender = BLENDER_MULTI_BAND;
+    config.outputFormat = OUTPUT_JPEG;
+    config.outputQuality = 95;
+    config.qualityPrefilter = 1;
+    config.cullMinOverlap = 0.35;
+    config.composeScale = kWorkScale;
+    return config;
+}
+
+cv::bill_stitching::ConfigStatus cv::bill_stitching::validateConfig(const StitchConfig &config) {
+    if (config.version != kStitchConfigVersion) {
+        stitching_log("Config rejected: version %d, expected %d\n", config.version, kStitchConfigVersion);
+        return CONFIG_ERR_VERSION;
+    }
+    if (config.engine < ENGINE_STITCHER_SCANS || config.engine > ENGINE_TRANSLATION) {
+        stitching_log("Config rejected: unknown engine %d\n", config.engine);
+        return CONFIG_ERR_ENGINE;
+    }
+    if (config.detector < DETECTOR_ORB || config.detector > DETECTOR_UPRIGHT ||
+        config.detectorFeatures < 0 || config.maxFeatures <= 0) {
+        stitching_log("Config rejected: detector %d, budget %d, max features %d\n", config.detector,
+                      config.detectorFeatures, config.maxFeatures);
+        return CONFIG_ERR_DETECTOR;
+    }
+    if (!(config.workScale > 0 && config.workScale <= 1) || !(config.registrationMegapix > 0) ||
+        !(config.seamMegapix > 0) || !(config.composeMegapix > 0 || config.composeMegapix == -1) ||
+        !(config.composeScale > 0 && config.composeScale <= 1)) {
+        stitching_log("Config rejected: work scale %f, registration %f, seam %f, compose %f, compose scale %f\n",
+                      config.workScale, config.registrationMegapix, config.seamMegapix,
+                      config.composeMegapix, config.composeScale);
+        return CONFIG_ERR_RESOLUTION;
+    }
+    // matchWindow <= 0 nghĩa là ghép mọi cặp (SequentialMatcher), không phải lỗi
+    if (!(config.matchConfidence > 0 && config.matchConfidence < 1) ||
+        !(config.panoConfidenceThresh >= 0)) {
+        stitching_log("Config rejected: match confidence %f, pano threshold %f\n",
+                      config.matchConfidence, config.panoConfidenceThresh);
+        return CONFIG_ERR_MATCHING;
+    }
+    if (config.blender < BLENDER_NONE || config.blender > BLENDER_MULTI_BAND) {
+        stitching_log("Config rejected: unknown blender %d\n", config.blender);
+        return CONFIG_ERR_BLENDER;
+    }
+    if (config.outputFormat < OUTPUT_JPEG || config.outputFormat > OUTPUT_WEBP ||
+        config.outputQuality < 1 || config.outputQuality > 100) {
+        stitching_log("Config rejected: output format %d, quality %d\n", config.outputFormat,
+                      config.outputQuality);
+        return CONFIG_ERR_OUTPUT;
+    }
+    if ((config.qualityPrefilter != 0 && config.qualityPrefilter != 1) || !(config.cullMinOverlap < 1)) {
+        stitching_log("Config rejected: quality prefilter %d, cull overlap %f\n", config.qualityPrefilter,
+                      config.cullMinOverlap);
+        return CONFIG_ERR_FILTER;
+    }
+    return CONFIG_OK;
+}
+
+Ptr<Feature2D> cv::bill_stitching::createDetector(const StitchConfig &config) {
+    switch (config.detector) {
+        case DETECTOR_SIFT:
+            return SIFT::create(config.detectorFeatures);
+        case DETECTOR_AKAZE:
+            return AKAZE::create();
+        case DETECTOR_BRISK:
+            return BRISK::create();
+        case DETECTOR_UPRIGHT: {
+            cv::bill_stitching::UprightParams params;
+            if (config.detectorFeatures > 0) {
+                params.maxFeatures = config.detectorFeatures;
+            }
+            return UprightFeatures::create(params);
+        }
+        default:
+            return config.detectorFeatures > 0 ? ORB::create(config.detectorFeatures) : ORB::create();
+    }
+}
+
+Ptr<Blender> cv::bill_stitching::createBlender(const StitchConfig &config) {
+    switch (config.blender) {
+        case BLENDER_NONE:
+            return Blender::createDefault(Blender::NO, false);
+        case BLENDER_FEATHER:
+            return Blender::createDefault(Blender::FEATHER, false);
+        default:
+            return Blender::createDefault(Blender::MULTI_BAND, false);
+    }
+}
+
+std::string cv::bill_stitching::outputExtension(const StitchConfig &config) {
+    switch (config.outputFormat) {
+        case OUTPUT_PNG:
+            return ".png";
+        case OUTPUT_WEBP:
+            return ".webp";
+        default:
+            return ".jpg";
+    }
+}
+
+bool cv::bill_stitching::sameStitcherSetup(const StitchConfig &a, const StitchConfig &b) {
+    return a.detector == b.detector && a.detectorFeatures == b.detectorFeatures &&
+           a.maxFeatures == b.maxFeatures && a.matchWindow == b.matchWindow &&
+           a.registrationMegapix == b.registrationMegapix && a.seamMegapix == b.seamMegapix &&
+           a.composeMegapix == b.composeMegapix && a.matchConfidence == b.matchConfidence &&
+           a.panoConfidenceThresh == b.panoConfidenceThresh && a.blender == b.blender;
+}
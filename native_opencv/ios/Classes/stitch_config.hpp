@@ -0,0 +1,98 @@
+#ifndef STITCH_CONFIG_HPP
+#define STITCH_CONFIG_HPP
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/features2d.hpp"
+#include "opencv2/stitching/detail/blenders.hpp"
+#include <cstdint>
+#include <string>
+
+namespace cv {
+    namespace bill_stitching {
+        // Tăng mỗi khi bố cục của StitchConfig thay đổi
+        const int32_t kStitchConfigVersion = 2;
+
+        enum StitchEngine {
+            ENGINE_STITCHER_SCANS = 0,   // cv::Stitcher ở chế độ SCANS
+            ENGINE_BILL_CHAIN = 1,       // stitchBills(): ghép chuỗi theo cặp, features dự phòng
+            ENGINE_TRANSLATION = 2,      // stitchBills() chỉ dùng phase correlation
+        };
+
+        enum FeatureDetector {
+            DETECTOR_ORB = 0,
+            DETECTOR_SIFT = 1,
+            DETECTOR_AKAZE = 2,
+            DETECTOR_BRISK = 3,
+            DETECTOR_UPRIGHT = 4,        // UprightFeatures: lưới FAST + descriptor nhị phân không xoay
+        };
+
+        enum BlenderType {
+            BLENDER_NONE = 0,
+            BLENDER_FEATHER = 1,
+            BLENDER_MULTI_BAND = 2,
+        };
+
+        enum OutputFormat {
+            OUTPUT_JPEG = 0,
+            OUTPUT_PNG = 1,
+            OUTPUT_WEBP = 2,
+        };
+
+        enum ConfigStatus {
+            CONFIG_OK = 0,
+            CONFIG_ERR_VERSION = 1,
+            CONFIG_ERR_ENGINE = 2,
+            CONFIG_ERR_DETECTOR = 3,
+            CONFIG_ERR_RESOLUTION = 4,
+            CONFIG_ERR_MATCHING = 5,
+            CONFIG_ERR_BLENDER = 6,
+            CONFIG_ERR_OUTPUT = 7,
+            CONFIG_ERR_FILTER = 8,
+        };
+
+        // Cấu hình ghép ảnh truyền qua FFI (phía Dart là một ffi.Struct cùng bố cục).
+        // Chỉ dùng kiểu có kích thước cố định; không thêm, bớt hay đổi thứ tự trường
+        // mà không tăng kStitchConfigVersion.
+        struct StitchConfig {
+            int32_t version;
+            int32_t engine;                // StitchEngine
+            int32_t detector;              // FeatureDetector
+            int32_t detectorFeatures;      // số điểm detector tìm trước ANMS, 0 = mặc định
+            int32_t maxFeatures;           // số điểm giữ lại mỗi ảnh sau ANMS
+            int32_t matchWindow;           // SCANS: số ảnh kế tiếp ghép cặp với mỗi ảnh, <= 0 = mọi cặp
+            double workScale;              // tỉ lệ giải mã ảnh đầu vào, (0, 1]
+            double registrationMegapix;    // tìm features và ghép cặp
+            double seamMegapix;            // SCANS: ước lượng đường nối
+            double composeMegapix;         // SCANS: ghép ảnh, -1 = độ phân giải làm việc; xem composeScale
+            double matchConfidence;
+            double panoConfidenceThresh;   // SCANS
+            int32_t blender;               // BlenderType, SCANS; FEATHER = canvas dạng tile, không tìm đường nối
+            int32_t outputFormat;          // OutputFormat của file ghi từ native
+            int32_t outputQuality;         // chất lượng JPEG/WebP, 1..100
+            int32_t qualityPrefilter;      // 1 = bỏ frame mờ hoặc sai phơi sáng
+            double cullMinOverlap;         // <= 0 thì không loại frame thừa
+            // Độ phân giải của ảnh ghép so với ảnh gốc, (0, 1]. Lớn hơn workScale thì các
+            // frame được đăng ký trên ảnh proxy rồi đọc lại ở tỉ lệ này để ghép (version 2).
+            double composeScale;
+        };
+
+        StitchConfig defaultStitchConfig();
+
+        // Kiểm tra toàn bộ cấu hình một lần trước khi ghép, để các bước sau chỉ việc
+        // dùng giá trị enum đã hợp lệ. Trường không hợp lệ được ghi log.
+        ConfigStatus validateConfig(const StitchConfig &config);
+
+        // Tạo các đối tượng mà config chọn; `config` phải hợp lệ.
+        cv::Ptr<cv::Feature2D> createDetector(const StitchConfig &config);
+
+        cv::Ptr<cv::detail::Blender> createBlender(const StitchConfig &config);
+
+        // ".jpg", ".png" or ".webp"
+        std::string outputExtension(const StitchConfig &config);
+
+        // True nếu hai config dựng cùng một cv::Stitcher, để dùng lại stitcher đã cache.
+        bool sameStitcherSetup(const StitchConfig &a, const StitchConfig &b);
+    }
+}
+
+#endif //STITCH_CONFIG_HPP
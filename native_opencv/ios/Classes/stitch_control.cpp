@@ -0,0 +1,138 @@
+#include "stitch_control.hpp"
+#include "sequential_matcher.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::detail;
+
+void cv::bill_stitching::StitchControl::checkpoint() const {
+    if (cancelled()) {
+        throw StitchCancelled();
+    }
+}
+
+void cv::bill_stitching::StitchControl::report(StitchStage stage, int done, int total) const {
+    if (callback_ != nullptr) {
+        callback_(jobId_, stage, done, total);
+    }
+}
+
+void cv::bill_stitching::StitchControl::progress(StitchStage stage, int done, int total) const {
+    report(stage, done, total);
+    checkpoint();
+}
+
+//=== Features ===
+void cv::bill_stitching::ControlledFeaturesFinder::begin(const StitchControl *control, int numImages) {
+    control_ = control;
+    calls_ = 0;
+    // computeImageFeatures gọi detect rồi compute cho mỗi ảnh
+    total_ = numImages * 2;
+}
+
+void cv::bill_stitching::ControlledFeaturesFinder::detectAndCompute(InputArray image, InputArray mask,
+                                                                    vector<KeyPoint> &keypoints,
+                                                                    OutputArray descriptors,
+                                                                    bool useProvidedKeypoints) {
+    // Stitcher gọi tuần tự trên thread của job nên có thể throw an toàn tại đây
+    if (control_ != nullptr) {
+        control_->checkpoint();
+    }
+    finder_->detectAndCompute(image, mask, keypoints, descriptors, useProvidedKeypoints);
+    if (control_ != nullptr) {
+        control_->progress(STAGE_FEATURES, ++calls_, total_);
+    }
+}
+
+//=== Matching ===
+void cv::bill_stitching::ControlledMatcher::begin(const StitchControl *control, int numPairs) {
+    control_ = control;
+    done_ = 0;
+    total_ = numPairs;
+}
+
+void cv::bill_stitching::ControlledMatcher::match(const ImageFeatures &features1,
+                                                  const ImageFeatures &features2,
+                                                  MatchesInfo &matches_info) {
+    // Chạy trong parallel_for_, không throw: bỏ qua cặp còn lại và để
+    // bước kiểm tra sau estimateTransform dừng job
+    if (control_ != nullptr && control_->cancelled()) {
+        return;
+    }
+    (*matcher_)(features1, features2, matches_info);
+    if (control_ != nullptr) {
+        control_->report(STAGE_MATCHING, ++done_, total_);
+    }
+}
+
+//=== Seams ===
+void cv::bill_stitching::ControlledSeamFinder::find(const vector<UMat> &src, const vector<Point> &corners,
+                                                    vector<UMat> &masks) {
+    if (control_ != nullptr) {
+        control_->progress(STAGE_SEAMS, 0, 1);
+    }
+    finder_->find(src, corners, masks);
+    if (control_ != nullptr) {
+        control_->progress(STAGE_SEAMS, 1, 1);
+    }
+}
+
+//=== Blending ===
+void cv::bill_stitching::ControlledBlender::begin(const StitchControl *control, int numImages) {
+    control_ = control;
+    fed_ = 0;
+    total_ = numImages;
+}
+
+void cv::bill_stitching::ControlledBlender::prepare(const vector<Point> &corners, const vector<Size> &sizes) {
+    blender_->prepare(corners, sizes);
+}
+
+void cv::bill_stitching::ControlledBlender::prepare(Rect dst_roi) {
+    blender_->prepare(dst_roi);
+}
+
+void cv::bill_stitching::ControlledBlender::feed(InputArray img, InputArray mask, Point tl) {
+    if (control_ != nullptr) {
+        control_->checkpoint();
+    }
+    blender_->feed(img, mask, tl);
+    if (control_ != nullptr) {
+        control_->progress(STAGE_BLENDING, ++fed_, total_);
+    }
+}
+
+void cv::bill_stitching::ControlledBlender::blend(InputOutputArray dst, InputOutputArray dst_mask) {
+    blender_->blend(dst, dst_mask);
+}
+
+//=== Stitcher ===
+void cv::bill_stitching::wrapStitcherStages(const Ptr<Stitcher> &stitcher) {
+    stitcher->setFeaturesFinder(makePtr<ControlledFeaturesFinder>(stitcher->featuresFinder()));
+    stitcher->setFeaturesMatcher(makePtr<ControlledMatcher>(stitcher->featuresMatcher()));
+    stitcher->setSeamFinder(makePtr<ControlledSeamFinder>(stitcher->seamFinder()));
+    stitcher->setBlender(makePtr<ControlledBlender>(stitcher->blender()));
+}
+
+void cv::bill_stitching::attachControl(const Ptr<Stitcher> &stitcher, const StitchControl *control,
+                                       int numImages) {
+    if (auto finder = stitcher->featuresFinder().dynamicCast<ControlledFeaturesFinder>()) {
+        finder->begin(control, numImages);
+    }
+    Ptr<FeaturesMatcher> matcher = stitcher->featuresMatcher();
+    int numPairs = numImages * (numImages - 1) / 2;
+    if (auto sequential = matcher.dynamicCast<SequentialMatcher>()) {
+        // Cửa sổ ghép cặp bọc bên ngoài matcher có control
+        numPairs = sequential->numPairs(numImages);
+        matcher = sequential->inner();
+    }
+    if (auto controlled = matcher.dynamicCast<ControlledMatcher>()) {
+        controlled->begin(control, numPairs);
+    }
+    if (auto seamFinder = stitcher->seamFinder().dynamicCast<ControlledSeamFinder>()) {
+        seamFinder->begin(control);
+    }
+    if (auto blender = stitcher->blender().dynamicCast<ControlledBlender>()) {
+        blender->begin(control, numImages);
+    }
+}
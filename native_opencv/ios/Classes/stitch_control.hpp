@@ -0,0 +1,163 @@
+#ifndef STITCH_CONTROL_HPP
+#define STITCH_CONTROL_HPP
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/features2d.hpp"
+#include "opencv2/stitching.hpp"
+#include "opencv2/stitching/detail/blenders.hpp"
+#include "opencv2/stitching/detail/matchers.hpp"
+#include "opencv2/stitching/detail/seam_finders.hpp"
+#include <atomic>
+#include <cstdint>
+#include <exception>
+
+namespace cv {
+    namespace bill_stitching {
+        enum StitchStage {
+            STAGE_DECODE = 0,
+            STAGE_PREPROCESS = 1,
+            STAGE_FEATURES = 2,
+            STAGE_MATCHING = 3,
+            STAGE_ESTIMATION = 4,
+            STAGE_SEAMS = 5,
+            STAGE_BLENDING = 6,
+            STAGE_ENCODE = 7,
+        };
+
+        // Reported from whichever thread runs the stage (NativeCallable.listener
+        // on the Dart side). `done` and `total` count frames or pairs in the stage.
+        typedef void (*ProgressCallback)(int64_t jobId, int32_t stage, int32_t done, int32_t total);
+
+        class StitchCancelled : public std::exception {
+        public:
+            const char *what() const noexcept override { return "stitching cancelled"; }
+        };
+
+        // Token huỷ + báo tiến độ cho một job ghép ảnh. Được kiểm tra tại ranh giới
+        // giữa các stage và giữa các frame, nên job bị bỏ sẽ dừng trong vài chục ms.
+        class StitchControl {
+        public:
+            StitchControl(int64_t jobId = 0, ProgressCallback callback = nullptr)
+                    : jobId_(jobId), callback_(callback) {}
+
+            void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+
+            bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+            // Throws StitchCancelled if the job was cancelled.
+            void checkpoint() const;
+
+            // Reports progress without checking for cancellation (safe in parallel_for_).
+            void report(StitchStage stage, int done, int total) const;
+
+            // Reports progress, then checks for cancellation.
+            void progress(StitchStage stage, int done, int total) const;
+
+        private:
+            int64_t jobId_;
+            ProgressCallback callback_;
+            std::atomic<bool> cancelled_{false};
+        };
+
+        // Các decorator cho stage bên trong cv::Stitcher, để báo tiến độ và huỷ
+        // ngay giữa các stage mà Stitcher không tự expose.
+        class ControlledFeaturesFinder : public cv::Feature2D {
+        public:
+            explicit ControlledFeaturesFinder(const cv::Ptr<cv::Feature2D> &finder) : finder_(finder) {}
+
+            void begin(const StitchControl *control, int numImages);
+
+            void detectAndCompute(cv::InputArray image, cv::InputArray mask,
+                                  std::vector<cv::KeyPoint> &keypoints, cv::OutputArray descriptors,
+                                  bool useProvidedKeypoints) CV_OVERRIDE;
+
+            int descriptorSize() const CV_OVERRIDE { return finder_->descriptorSize(); }
+
+            int descriptorType() const CV_OVERRIDE { return finder_->descriptorType(); }
+
+            int defaultNorm() const CV_OVERRIDE { return finder_->defaultNorm(); }
+
+            bool empty() const CV_OVERRIDE { return finder_->empty(); }
+
+            cv::String getDefaultName() const CV_OVERRIDE { return finder_->getDefaultName(); }
+
+        private:
+            cv::Ptr<cv::Feature2D> finder_;
+            const StitchControl *control_ = nullptr;
+            int calls_ = 0;
+            int total_ = 0;
+        };
+
+        class ControlledMatcher : public cv::detail::FeaturesMatcher {
+        public:
+            explicit ControlledMatcher(const cv::Ptr<cv::detail::FeaturesMatcher> &matcher)
+                    : FeaturesMatcher(matcher->isThreadSafe()), matcher_(matcher) {}
+
+            const cv::Ptr<cv::detail::FeaturesMatcher> &inner() const { return matcher_; }
+
+            void begin(const StitchControl *control, int numPairs);
+
+            // Pairs matched beyond those given to begin(), e.g. by a widened retry pass.
+            void extend(int numPairs) { total_ += numPairs; }
+
+            void collectGarbage() CV_OVERRIDE { matcher_->collectGarbage(); }
+
+        protected:
+            using FeaturesMatcher::match;
+
+            void match(const cv::detail::ImageFeatures &features1,
+                       const cv::detail::ImageFeatures &features2,
+                       cv::detail::MatchesInfo &matches_info) CV_OVERRIDE;
+
+        private:
+            cv::Ptr<cv::detail::FeaturesMatcher> matcher_;
+            const StitchControl *control_ = nullptr;
+            std::atomic<int> done_{0};
+            int total_ = 0;
+        };
+
+        class ControlledSeamFinder : public cv::detail::SeamFinder {
+        public:
+            explicit ControlledSeamFinder(const cv::Ptr<cv::detail::SeamFinder> &finder) : finder_(finder) {}
+
+            void begin(const StitchControl *control) { control_ = control; }
+
+            void find(const std::vector<cv::UMat> &src, const std::vector<cv::Point> &corners,
+                      std::vector<cv::UMat> &masks) CV_OVERRIDE;
+
+        private:
+            cv::Ptr<cv::detail::SeamFinder> finder_;
+            const StitchControl *control_ = nullptr;
+        };
+
+        class ControlledBlender : public cv::detail::Blender {
+        public:
+            explicit ControlledBlender(const cv::Ptr<cv::detail::Blender> &blender) : blender_(blender) {}
+
+            void begin(const StitchControl *control, int numImages);
+
+            void prepare(const std::vector<cv::Point> &corners, const std::vector<cv::Size> &sizes) CV_OVERRIDE;
+
+            void prepare(cv::Rect dst_roi) CV_OVERRIDE;
+
+            void feed(cv::InputArray img, cv::InputArray mask, cv::Point tl) CV_OVERRIDE;
+
+            void blend(cv::InputOutputArray dst, cv::InputOutputArray dst_mask) CV_OVERRIDE;
+
+        private:
+            cv::Ptr<cv::detail::Blender> blender_;
+            const StitchControl *control_ = nullptr;
+            int fed_ = 0;
+            int total_ = 0;
+        };
+
+        // Bọc các stage của stitcher bằng decorator ở trên (gọi một lần khi tạo stitcher).
+        void wrapStitcherStages(const cv::Ptr<cv::Stitcher> &stitcher);
+
+        // Gắn control của job hiện tại vào các decorator (control có thể là nullptr).
+        void attachControl(const cv::Ptr<cv::Stitcher> &stitcher, const StitchControl *control,
+                           int numImages);
+    }
+}
+
+#endif //STITCH_CONTROL_HPP
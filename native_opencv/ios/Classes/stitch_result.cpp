@@ -0,0 +1,63 @@
+#include "opencv2/opencv.hpp"
+#include "stitch_result.hpp"
+#include <fstream>
+
+using namespace std;
+using namespace cv;
+
+namespace {
+    vector<int> encodeParams(const std::string &ext, int quality) {
+        if (ext == ".jpg" || ext == ".jpeg") {
+            return {IMWRITE_JPEG_QUALITY, quality};
+        }
+        if (ext == ".webp") {
+            return {IMWRITE_WEBP_QUALITY, quality};
+        }
+        return {};
+    }
+
+    std::string extensionOf(const std::string &path) {
+        size_t dotPos = path.find_last_of('.');
+        return dotPos == std::string::npos ? std::string() : path.substr(dotPos);
+    }
+}
+
+cv::bill_stitching::StitchResult::StitchResult(Composite &composite, const FrameCounts &counts) : counts_(counts) {
+    composite.readRGBA(pixels_);
+}
+
+void cv::bill_stitching::StitchResult::retain() {
+    refs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void cv::bill_stitching::StitchResult::release() {
+    if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+    }
+}
+
+bool cv::bill_stitching::StitchResult::encode(const std::string &ext, int quality) {
+    Mat bgr;
+    cvtColor(pixels_, bgr, COLOR_RGBA2BGR);
+    encoded_.clear();
+    return imencode(ext, bgr, encoded_, encodeParams(ext, quality));
+}
+
+bool cv::bill_stitching::StitchResult::write(const std::string &path, int quality) const {
+    Mat bgr;
+    cvtColor(pixels_, bgr, COLOR_RGBA2BGR);
+    if (!imwrite(path, bgr, encodeParams(extensionOf(path), quality))) {
+        return false;
+    }
+    return registration_.empty() || writeRegistration(registrationSidecarPath(path), registration_);
+}
+
+bool cv::bill_stitching::writeEncoded(const std::string &path, const Mat &bgr, const std::string &ext, int quality) {
+    vector<uchar> encoded;
+    if (!imencode(ext, bgr, encoded, encodeParams(ext, quality))) {
+        return false;
+    }
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+    return static_cast<bool>(out);
+}
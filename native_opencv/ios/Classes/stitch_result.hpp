@@ -0,0 +1,73 @@
+#ifndef STITCH_RESULT_HPP
+#define STITCH_RESULT_HPP
+
+#include "opencv2/core/core.hpp"
+#include "compositor.hpp"
+#include "registration_store.hpp"
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace cv {
+    namespace bill_stitching {
+        enum ResultPixelFormat {
+            RESULT_FORMAT_RGBA8888 = 0,
+        };
+
+        // Số frame ở từng bước lọc trước khi ghép, để theo dõi lượng việc tiết kiệm được
+        struct FrameCounts {
+            int input = 0;            // frames loaded
+            int rejected = 0;         // dropped by the quality gate
+            int culled = 0;           // dropped as redundant by overlap
+            int stitched = 0;         // handed to the stitcher
+        };
+
+        // Ảnh ghép được giữ trong bộ nhớ native và trao cho Dart dưới dạng handle.
+        // Pixel được lưu sẵn ở dạng RGBA để Flutter hiển thị trực tiếp; việc mã hoá
+        // (JPEG/PNG) chỉ thực hiện khi được yêu cầu.
+        // Handle được đếm tham chiếu vì cả đối tượng Dart lẫn các typed data view
+        // trỏ vào bộ đệm đều có finalizer riêng.
+        class StitchResult {
+        public:
+            // Đọc ảnh ghép thẳng từ các tile vào bộ đệm RGBA, không qua một ảnh BGR đầy đủ.
+            explicit StitchResult(Composite &composite, const FrameCounts &counts = FrameCounts());
+
+            void retain();
+
+            // Giảm tham chiếu và giải phóng khi về 0.
+            void release();
+
+            const cv::Mat &pixels() const { return pixels_; }
+
+            const FrameCounts &frameCounts() const { return counts_; }
+
+            // Registration của lần ghép tạo ra ảnh này (rỗng nếu không có, ví dụ phiên
+            // ghép tăng dần); được ghi kèm bởi write().
+            void setRegistration(const Registration &registration) { registration_ = registration; }
+
+            const Registration &registration() const { return registration_; }
+
+            // Encodes into the internal buffer, replacing any previous encoding.
+            bool encode(const std::string &ext, int quality);
+
+            const std::vector<uchar> &encoded() const { return encoded_; }
+
+            // Also writes the registration sidecar next to `path` when there is one.
+            bool write(const std::string &path, int quality) const;
+
+        private:
+            ~StitchResult() = default;
+
+            cv::Mat pixels_;
+            FrameCounts counts_;
+            Registration registration_;
+            std::vector<uchar> encoded_;
+            std::atomic<int> refs_{1};
+        };
+
+        // Mã hoá ảnh BGR theo `ext` (không phụ thuộc đuôi của `path`) rồi ghi ra file
+        bool writeEncoded(const std::string &path, const cv::Mat &bgr, const std::string &ext, int quality);
+    }
+}
+
+#endif //STITCH_RESULT_HPP
@@ -0,0 +1,249 @@
+#include "opencv2/opencv.hpp"
+#include "opencv2/stitching/detail/matchers.hpp"
+#include "stitch_session.hpp"
+#include "compositor.hpp"
+#include "frame_registration.hpp"
+#include "keypoint_selection.hpp"
+#include "bill_stitching.hpp"
+#include "native_opencv.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::detail;
+
+namespace {
+    // Cạnh dài nhất của ảnh dùng cho optical flow, và bán kính chấp nhận quanh chuyển
+    // động đã theo dõi (theo cạnh lớn nhất của frame) khi đăng ký keyframe
+    const int kTrackMaxDim = 320;
+    const double kTrackedPriorRadius = 0.1;
+
+    // Mã cv::rotate cho góc xoay theo chiều kim đồng hồ, -1 nếu không cần xoay. Góc khác
+    // 0/90/180/270 là lỗi của bên gọi, không được coi như 270.
+    int rotateCode(int rotation) {
+        switch (rotation) {
+            case 0:
+                return -1;
+            case 90:
+                return ROTATE_90_CLOCKWISE;
+            case 180:
+                return ROTATE_180;
+            case 270:
+                return ROTATE_90_COUNTERCLOCKWISE;
+            default:
+                CV_Error(Error::StsBadArg, format("Unsupported frame rotation: %d", rotation));
+        }
+    }
+}
+
+cv::bill_stitching::StitchSession::StitchSession() {
+    finder_ = makePtr<SelectiveFeatures>(ORB::create(8000), KeypointSelection{2.0f, 4000});
+    matcher_ = makePtr<AffineBestOf2NearestMatcher>(false, false, 0.3f);
+    clahe_ = createCLAHE(2.0, Size(8, 8));
+    // Hàng đợi đầu vào sâu hơn để camera không bị chặn khi một frame xử lý chậm
+    pipeline_.addStage("decode", [this](PendingFrame &pending) { return decodeFrame(pending); }, 4);
+    pipeline_.addStage("prepare", [this](PendingFrame &pending) { return prepareFrame(pending); });
+    pipeline_.addStage("register", [this](PendingFrame &pending) { return registerFrame(pending); });
+    pipeline_.start();
+}
+
+cv::bill_stitching::StitchSession::~StitchSession() {
+    pipeline_.stop();
+}
+
+void cv::bill_stitching::StitchSession::pushFrame(const std::string &imagePath, int64 timestampUs) {
+    PendingFrame pending;
+    pending.imagePath = imagePath;
+    pending.timestampUs = timestampUs;
+    pipeline_.push(std::move(pending));
+}
+
+void cv::bill_stitching::StitchSession::pushYuv420(const Yuv420Planes &planes) {
+    PendingFrame pending;
+    convertYuv420(planes, kWorkScale, pending.image, pending.gray);
+    pending.timestampUs = planes.timestampUs;
+    pipeline_.push(std::move(pending));
+}
+
+bool cv::bill_stitching::StitchSession::trackYuv420(const Yuv420Planes &planes) {
+    CV_Assert(planes.y && planes.width > 0 && planes.height > 0);
+    const int code = rotateCode(planes.rotation);
+    const double trackScale = std::min(1.0, static_cast<double>(kTrackMaxDim) /
+                                            std::max(planes.width, planes.height));
+    Mat y(Size(planes.width, planes.height), CV_8UC1, const_cast<uchar *>(planes.y), planes.yRowStride);
+    Mat small;
+    resize(y, small, Size(), trackScale, trackScale, INTER_AREA);
+    if (code >= 0) {
+        rotate(small, small, code);
+    }
+
+    TrackResult tracked = tracker_.track(small);
+    if (!tracked.keyframe) {
+        return false;
+    }
+    PendingFrame pending;
+    convertYuv420(planes, kWorkScale, pending.image, pending.gray);
+    pending.timestampUs = planes.timestampUs;
+    if (!tracked.lost && !tracked.toKeyframe.empty()) {
+        // Cùng một phép quay/thu nhỏ áp cho cả hai độ phân giải, chỉ cần đổi tỉ lệ
+        const double toWork = kWorkScale / trackScale;
+        pending.tracked = true;
+        pending.trackedShift = Point2d(tracked.toKeyframe.at<double>(0, 2),
+                                       tracked.toKeyframe.at<double>(1, 2)) * toWork;
+    }
+    stitching_log("Session: keyframe after %d tracks, overlap %.2f\n", tracked.numTracks, tracked.overlap);
+    pipeline_.push(std::move(pending));
+    return true;
+}
+
+void cv::bill_stitching::convertYuv420(const Yuv420Planes &planes, double scale, Mat &bgr, Mat &gray) {
+    CV_Assert(planes.y && planes.u && planes.v && planes.width > 0 && planes.height > 0);
+    CV_Assert(planes.uvPixelStride == 1 || planes.uvPixelStride == 2);
+    const int code = rotateCode(planes.rotation);
+
+    // Chỉ tạo Mat header trỏ vào bộ nhớ của camera, không sao chép
+    const Size lumaSize(planes.width, planes.height);
+    const Size chromaSize((planes.width + 1) / 2, (planes.height + 1) / 2);
+    const int chromaType = planes.uvPixelStride == 2 ? CV_8UC2 : CV_8UC1;
+    Mat y(lumaSize, CV_8UC1, const_cast<uchar *>(planes.y), planes.yRowStride);
+    Mat u(chromaSize, chromaType, const_cast<uchar *>(planes.u), planes.uvRowStride);
+    Mat v(chromaSize, chromaType, const_cast<uchar *>(planes.v), planes.uvRowStride);
+
+    // Lần đọc duy nhất vào bộ nhớ camera là bước thu nhỏ về độ phân giải làm việc
+    const Size workSize(cvRound(planes.width * scale), cvRound(planes.height * scale));
+    resize(y, gray, workSize, 0, 0, INTER_AREA);
+
+    Mat uSmall, vSmall;
+    resize(u, uSmall, workSize, 0, 0, INTER_LINEAR);
+    resize(v, vSmall, workSize, 0, 0, INTER_LINEAR);
+    if (planes.uvPixelStride == 2) {
+        // Plane xen kẽ: byte đầu tiên của mỗi cặp thuộc về plane đang xét
+        extractChannel(uSmall, uSmall, 0);
+        extractChannel(vSmall, vSmall, 0);
+    }
+    Mat yuv;
+    merge(vector<Mat>{gray, uSmall, vSmall}, yuv);
+    cvtColor(yuv, bgr, COLOR_YUV2BGR);
+
+    if (code >= 0) {
+        rotate(gray, gray, code);
+        rotate(bgr, bgr, code);
+    }
+}
+
+bool cv::bill_stitching::StitchSession::decodeFrame(PendingFrame &pending) {
+    if (pending.imagePath.empty()) {
+        // Frame từ camera: phân tích chỉ trên kênh sáng (Y) đã thu nhỏ
+        pending.image = preprocess(pending.image);
+        clahe_->apply(pending.gray, pending.gray);
+        return true;
+    }
+    pending.image = load_image(pending.imagePath);
+    if (pending.image.empty()) {
+        return false;
+    }
+    cvtColor(pending.image, pending.gray, COLOR_BGR2GRAY);
+    return true;
+}
+
+bool cv::bill_stitching::StitchSession::prepareFrame(PendingFrame &pending) {
+    pending.phase = preparePhaseImage(pending.gray);
+    return true;
+}
+
+bool cv::bill_stitching::StitchSession::registerFrame(PendingFrame &pending) {
+    long long int start = get_now();
+
+    Frame frame;
+    frame.image = std::move(pending.image);
+    frame.timestampUs = pending.timestampUs;
+    frame.features.img_idx = static_cast<int>(frames_.size());
+
+    if (frames_.empty()) {
+        frame.toPrev = Mat::eye(3, 3, CV_64F);
+    } else {
+        Frame &prev = frames_.back();
+        const int64 dtUs = frame.timestampUs > 0 && prev.timestampUs > 0
+                           ? frame.timestampUs - prev.timestampUs : 0;
+        MotionPrior prior;
+        if (pending.tracked && lastFrameKept_) {
+            // Chuyển động từ tracker chính xác hơn nhiều so với ngoại suy vận tốc
+            prior.valid = true;
+            prior.shift = pending.trackedShift;
+            prior.radius = kTrackedPriorRadius * std::max(frame.image.cols, frame.image.rows);
+        } else if (hasVelocity_) {
+            prior = predictMotion(velocity_, dtUs, frame.image.size());
+        }
+        PairRegistration reg = registerTranslation(prevPhase_, pending.phase, prior);
+        if (!reg.ok) {
+            // Chỉ tìm features khi phase correlation không đủ tin cậy
+            if (prev.features.keypoints.empty()) {
+                computeImageFeatures(finder_, prevGray_, prev.features);
+            }
+            computeImageFeatures(finder_, pending.gray, frame.features);
+            reg = registerPair(prev.features, frame.features, *matcher_, prior);
+        }
+        if (!reg.ok) {
+            // Bỏ qua frame không đăng ký được, frame sau sẽ được ghép với frame hợp lệ cuối cùng
+            stitching_log("Session: dropping frame %lu, registration failed\n", frames_.size());
+            lastFrameKept_ = false;
+            return false;
+        }
+        frame.toPrev = reg.H;
+        if (dtUs > 0) {
+            velocity_ = Point2d(reg.H.at<double>(0, 2), reg.H.at<double>(1, 2)) / static_cast<double>(dtUs);
+            hasVelocity_ = true;
+        }
+    }
+    frames_.push_back(std::move(frame));
+    lastFrameKept_ = true;
+    prevGray_ = std::move(pending.gray);
+    prevPhase_ = std::move(pending.phase);
+
+    stitching_log("Session: frame %lu registered in %lld ms\n", frames_.size(), get_now() - start);
+    return true;
+}
+
+cv::bill_stitching::SessionStatus cv::bill_stitching::StitchSession::finalize(Composite &result,
+                                                                              const StitchControl *control) {
+    // Chờ theo từng khoảng ngắn để job bị huỷ không phải đợi hết hàng đợi
+    while (!pipeline_.waitIdleFor(std::chrono::milliseconds(10))) {
+        if (control != nullptr && control->cancelled()) {
+            pipeline_.discard();
+            throw StitchCancelled();
+        }
+    }
+    logStageStats("Session", pipeline_.stats());
+
+    if (frames_.size() < 2) {
+        stitching_log("Session: need more images\n");
+        return SESSION_ERR_NEED_MORE_IMGS;
+    }
+
+    long long int start = get_now();
+    composite(control, result);
+    stitching_log("Session: compositing %lu frames took %lld ms\n", frames_.size(),
+                  get_now() - start);
+    return SESSION_OK;
+}
+
+void cv::bill_stitching::StitchSession::composite(const StitchControl *control, Composite &result) const {
+    // Bố cục toàn cục tính một lần, canvas cấp phát một lần
+    vector<Size> sizes;
+    vector<Mat> toPrev;
+    for (const auto &frame: frames_) {
+        sizes.push_back(frame.image.size());
+        toPrev.push_back(frame.toPrev);
+    }
+    FrameLayout layout = computeLayout(sizes, toPrev);
+
+    Compositor &compositor = result.compositor;
+    compositor.reset(layout.canvasSize);
+    result.region = Rect();
+    result.image.release();
+    for (size_t i = 0; i < frames_.size(); ++i) {
+        if (control != nullptr) {
+            control->progress(STAGE_BLENDING, static_cast<int>(i), static_cast<int>(frames_.size()));
+        }
+        compositor.feed(frames_[i].image, layout.toCanvas[i]);
+    }
+}
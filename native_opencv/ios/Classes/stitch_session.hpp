@@ -0,0 +1,121 @@
+#ifndef STITCH_SESSION_HPP
+#define STITCH_SESSION_HPP
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/features2d.hpp"
+#include "opencv2/imgproc.hpp"
+#include "opencv2/stitching/detail/matchers.hpp"
+#include "compositor.hpp"
+#include "frame_registration.hpp"
+#include "frame_tracker.hpp"
+#include "stage_pipeline.hpp"
+#include "stitch_control.hpp"
+#include <string>
+#include <vector>
+
+namespace cv {
+    namespace bill_stitching {
+        enum SessionStatus {
+            SESSION_OK = 0,
+            SESSION_ERR_NEED_MORE_IMGS = 1,
+            SESSION_ERR_WRITE_FAIL = 2,
+            SESSION_ERR_INVALID = 3,
+        };
+
+        // Ảnh YUV420 từ camera stream (ImageFormatGroup.yuv420). Các plane chỉ được
+        // mượn trong lúc gọi hàm; U/V có thể là planar (pixelStride 1) hoặc xen kẽ (2).
+        struct Yuv420Planes {
+            const uchar *y = nullptr;
+            const uchar *u = nullptr;
+            const uchar *v = nullptr;
+            int width = 0;
+            int height = 0;
+            int yRowStride = 0;
+            int uvRowStride = 0;
+            int uvPixelStride = 1;
+            int rotation = 0;         // độ xoay theo chiều kim đồng hồ: 0, 90, 180, 270
+            int64 timestampUs = 0;
+        };
+
+        // Đọc các plane của camera đúng một lần: thu nhỏ theo `scale`, đổi sang BGR và
+        // xoay theo `planes.rotation`. `gray` là plane Y đã thu nhỏ và xoay.
+        void convertYuv420(const Yuv420Planes &planes, double scale, cv::Mat &bgr, cv::Mat &gray);
+
+        // Phiên ghép ảnh tăng dần: mỗi frame được đọc, tiền xử lý và đăng ký với frame
+        // trước đó ngay khi được đẩy vào, nên khi người dùng dừng quét chỉ còn lại bước
+        // ghép (compositing) cuối cùng. Giải mã, chuẩn bị ảnh cho phase correlation và
+        // đăng ký chạy chồng lên nhau trên một StagePipeline ba stage.
+        class StitchSession {
+        public:
+            StitchSession();
+
+            ~StitchSession();
+
+            StitchSession(const StitchSession &) = delete;
+
+            StitchSession &operator=(const StitchSession &) = delete;
+
+            // Đưa frame vào hàng đợi; chỉ chặn khi pipeline đang chậm vài frame.
+            void pushFrame(const std::string &imagePath, int64 timestampUs = 0);
+
+            // Bọc các plane của camera mà không sao chép, thu nhỏ về độ phân giải làm việc
+            // ngay trên thread gọi rồi đưa vào hàng đợi. Các plane có thể được giải phóng
+            // ngay khi hàm trả về.
+            void pushYuv420(const Yuv420Planes &planes);
+
+            // Chế độ quét trực tiếp: gọi với mọi frame preview. Frame được theo dõi bằng
+            // optical flow ở độ phân giải thấp và chỉ được đưa vào pipeline khi trở thành
+            // keyframe; chuyển động đã theo dõi làm dự đoán cho bước đăng ký. Trả về true
+            // nếu frame được đưa vào hàng đợi. Chỉ gọi từ một thread.
+            bool trackYuv420(const Yuv420Planes &planes);
+
+            // Chờ mọi frame trong hàng đợi được đăng ký rồi ghép chúng vào canvas dạng tile
+            // của `result`. Có control thì ném StitchCancelled khi job bị huỷ (frame còn
+            // trong hàng đợi bị bỏ).
+            SessionStatus finalize(Composite &result, const StitchControl *control = nullptr);
+
+        private:
+            struct PendingFrame {
+                std::string imagePath;               // rỗng với frame từ camera
+                cv::Mat image;                       // BGR ở độ phân giải làm việc (frame camera)
+                cv::Mat gray;                        // ảnh sáng ở độ phân giải làm việc
+                PhaseImage phase;
+                int64 timestampUs = 0;
+                bool tracked = false;                // trackedShift hợp lệ
+                cv::Point2d trackedShift;            // chuyển động do tracker đo tới frame trước trong hàng đợi, px
+            };
+
+            struct Frame {
+                cv::Mat image;                       // BGR ở độ phân giải làm việc
+                cv::detail::ImageFeatures features;  // chỉ tính khi phase correlation thất bại
+                cv::Mat toPrev;                      // affine 3x3 về frame được giữ trước đó
+                int64 timestampUs = 0;
+            };
+
+            // Các stage của pipeline, mỗi stage chạy trên thread riêng.
+            bool decodeFrame(PendingFrame &pending);
+
+            bool prepareFrame(PendingFrame &pending);
+
+            bool registerFrame(PendingFrame &pending);
+
+            void composite(const StitchControl *control, Composite &result) const;
+
+            cv::Ptr<cv::Feature2D> finder_;
+            cv::Ptr<cv::detail::FeaturesMatcher> matcher_;
+            std::vector<Frame> frames_;
+            cv::Mat prevGray_;                       // frame được giữ gần nhất, cho bước dự phòng bằng features
+            PhaseImage prevPhase_;
+            cv::Point2d velocity_;                   // px mỗi micro giây, từ cặp đăng ký gần nhất
+            bool hasVelocity_ = false;
+            bool lastFrameKept_ = false;             // frame cuối trong hàng đợi đã được đăng ký
+            FrameTracker tracker_;
+
+            cv::Ptr<cv::CLAHE> clahe_;
+            // Khai báo cuối cùng để các thread dừng trước khi trạng thái chúng dùng bị huỷ
+            StagePipeline<PendingFrame> pipeline_;
+        };
+    }
+}
+
+#endif //STITCH_SESSION_HPP
@@ -0,0 +1,208 @@
+#include "opencv2/opencv.hpp"
+#include "bill_stitching.hpp"
+#include "compositor.hpp"
+#include "tiled_canvas.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace cv;
+
+namespace {
+    std::mutex gBudgetMutex;
+    cv::bill_stitching::CanvasBudget gDefaultBudget;
+}
+
+void cv::bill_stitching::setDefaultCanvasBudget(const CanvasBudget &budget) {
+    std::lock_guard<std::mutex> lock(gBudgetMutex);
+    gDefaultBudget = budget;
+}
+
+cv::bill_stitching::CanvasBudget cv::bill_stitching::defaultCanvasBudget() {
+    std::lock_guard<std::mutex> lock(gBudgetMutex);
+    return gDefaultBudget;
+}
+
+cv::bill_stitching::TiledCanvas::TiledCanvas() = default;
+
+cv::bill_stitching::TiledCanvas::~TiledCanvas() {
+    if (scratchFd_ >= 0) {
+        close(scratchFd_);
+    }
+}
+
+void cv::bill_stitching::TiledCanvas::reset(const Size &size, const CanvasBudget &budget, int tileSize) {
+    CV_Assert(size.width >= 0 && size.height >= 0 && tileSize > 0);
+    size_ = size;
+    tileSize_ = tileSize;
+    // 3 byte BGR + 1 byte trọng số mỗi pixel; với tile 256 đây là bội số của trang bộ nhớ
+    tileBytes_ = static_cast<size_t>(tileSize) * tileSize * 4;
+    budget_ = budget;
+    tilesX_ = (size.width + tileSize - 1) / tileSize;
+    const int tilesY = (size.height + tileSize - 1) / tileSize;
+    tiles_.clear();
+    tiles_.resize(static_cast<size_t>(tilesX_) * tilesY);
+    resident_.clear();
+    covered_ = Rect();
+    if (scratchFd_ >= 0) {
+        close(scratchFd_);
+        scratchFd_ = -1;
+    }
+    scratchSlots_ = 0;
+    spills_ = 0;
+}
+
+Mat cv::bill_stitching::TiledCanvas::color(Tile &tile) const {
+    return Mat(tileSize_, tileSize_, CV_8UC3, tile.data.data());
+}
+
+Mat cv::bill_stitching::TiledCanvas::weights(Tile &tile) const {
+    return Mat(tileSize_, tileSize_, CV_8U, tile.data.data() + static_cast<size_t>(tileSize_) * tileSize_ * 3);
+}
+
+bool cv::bill_stitching::TiledCanvas::openScratch() {
+    if (scratchFd_ >= 0) {
+        return true;
+    }
+    if (budget_.scratchDir.empty()) {
+        return false;
+    }
+    string path = budget_.scratchDir + "/canvas_tiles_XXXXXX";
+    vector<char> name(path.begin(), path.end());
+    name.push_back('\0');
+    scratchFd_ = mkstemp(name.data());
+    if (scratchFd_ < 0) {
+        stitching_log("TiledCanvas: cannot create scratch file in %s: %s\n", budget_.scratchDir.c_str(),
+                      strerror(errno));
+        budget_.scratchDir.clear();
+        return false;
+    }
+    // Xoá tên file ngay, dữ liệu biến mất khi fd được đóng kể cả khi app bị kill
+    unlink(name.data());
+    return true;
+}
+
+void cv::bill_stitching::TiledCanvas::evictOne() {
+    const int index = resident_.back();
+    Tile &tile = tiles_[index];
+    if (tile.slot < 0) {
+        const off_t length = static_cast<off_t>(scratchSlots_ + 1) * tileBytes_;
+        if (ftruncate(scratchFd_, length) != 0) {
+            stitching_log("TiledCanvas: cannot grow scratch file: %s\n", strerror(errno));
+            budget_.scratchDir.clear();
+            return;
+        }
+        tile.slot = scratchSlots_++;
+    }
+    void *mapped = mmap(nullptr, tileBytes_, PROT_WRITE, MAP_SHARED, scratchFd_,
+                        static_cast<off_t>(tile.slot) * tileBytes_);
+    if (mapped == MAP_FAILED) {
+        stitching_log("TiledCanvas: cannot map scratch slot: %s\n", strerror(errno));
+        budget_.scratchDir.clear();
+        return;
+    }
+    memcpy(mapped, tile.data.data(), tileBytes_);
+    munmap(mapped, tileBytes_);
+    vector<uchar>().swap(tile.data);
+    resident_.pop_back();
+    ++spills_;
+}
+
+cv::bill_stitching::TiledCanvas::Tile &cv::bill_stitching::TiledCanvas::acquire(int index) {
+    Tile &tile = tiles_[index];
+    if (!tile.data.empty()) {
+        resident_.splice(resident_.begin(), resident_, tile.lru);
+        return tile;
+    }
+
+    // Nhường chỗ trước khi cấp phát, để bộ nhớ đỉnh không vượt ngân sách
+    while (!resident_.empty() && (resident_.size() + 1) * tileBytes_ > budget_.bytes && openScratch()) {
+        const size_t before = resident_.size();
+        evictOne();
+        if (resident_.size() == before) {
+            break;
+        }
+    }
+
+    if (tile.slot >= 0) {
+        tile.data.resize(tileBytes_);
+        void *mapped = mmap(nullptr, tileBytes_, PROT_READ, MAP_SHARED, scratchFd_,
+                            static_cast<off_t>(tile.slot) * tileBytes_);
+        if (mapped == MAP_FAILED) {
+            CV_Error(Error::StsError, format("TiledCanvas: cannot map scratch slot: %s", strerror(errno)));
+        }
+        memcpy(tile.data.data(), mapped, tileBytes_);
+        munmap(mapped, tileBytes_);
+    } else {
+        tile.data.assign(tileBytes_, 0);
+    }
+    tile.touched = true;
+    resident_.push_front(index);
+    tile.lru = resident_.begin();
+    return tile;
+}
+
+void cv::bill_stitching::TiledCanvas::blend(const Mat &bgr, const Mat &weight, const Point &tl) {
+    CV_Assert(bgr.type() == CV_8UC3 && weight.type() == CV_8U && bgr.size() == weight.size());
+    const Rect area = Rect(tl, bgr.size()) & Rect(Point(), size_);
+    if (area.empty()) {
+        return;
+    }
+    covered_ = covered_.empty() ? area : (covered_ | area);
+
+    for (int ty = area.y / tileSize_; ty * tileSize_ < area.br().y; ++ty) {
+        for (int tx = area.x / tileSize_; tx * tileSize_ < area.br().x; ++tx) {
+            const Rect tileRect(tx * tileSize_, ty * tileSize_, tileSize_, tileSize_);
+            const Rect part = area & tileRect;
+            Tile &tile = acquire(ty * tilesX_ + tx);
+            Mat tileColor = color(tile), tileWeights = weights(tile);
+            for (int y = part.y; y < part.br().y; ++y) {
+                const int sy = y - tl.y, ly = y - tileRect.y;
+                const int sx = part.x - tl.x, lx = part.x - tileRect.x;
+                blendRow(bgr.ptr<uchar>(sy) + 3 * sx, weight.ptr<uchar>(sy) + sx,
+                         tileColor.ptr<uchar>(ly) + 3 * lx, tileWeights.ptr<uchar>(ly) + lx, part.width);
+            }
+        }
+    }
+}
+
+void cv::bill_stitching::TiledCanvas::read(const Rect &region, Mat &dst) {
+    dst.create(region.size(), CV_8UC3);
+    readInto(region, dst, -1);
+}
+
+void cv::bill_stitching::TiledCanvas::readRGBA(const Rect &region, Mat &dst) {
+    dst.create(region.size(), CV_8UC4);
+    readInto(region, dst, COLOR_BGR2RGBA);
+}
+
+void cv::bill_stitching::TiledCanvas::readInto(const Rect &region, Mat &dst, int code) {
+    CV_Assert((region & Rect(Point(), size_)) == region && dst.size() == region.size());
+    if (region.empty()) {
+        return;
+    }
+    const Scalar black = dst.channels() == 4 ? Scalar(0, 0, 0, 255) : Scalar::all(0);
+    for (int ty = region.y / tileSize_; ty * tileSize_ < region.br().y; ++ty) {
+        for (int tx = region.x / tileSize_; tx * tileSize_ < region.br().x; ++tx) {
+            const Rect tileRect(tx * tileSize_, ty * tileSize_, tileSize_, tileSize_);
+            const Rect part = region & tileRect;
+            Mat out = dst(part - region.tl());
+            Tile &tile = tiles_[ty * tilesX_ + tx];
+            if (!tile.touched) {
+                out.setTo(black);
+                continue;
+            }
+            const Mat in = color(acquire(ty * tilesX_ + tx))(part - tileRect.tl());
+            if (code < 0) {
+                in.copyTo(out);
+            } else {
+                // out là ROI đúng kích thước và kiểu nên cvtColor ghi thẳng vào dst
+                cvtColor(in, out, code);
+            }
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef TILED_CANVAS_HPP
+#define TILED_CANVAS_HPP
+
+#include "opencv2/core/core.hpp"
+#include <list>
+#include <string>
+#include <vector>
+
+namespace cv {
+    namespace bill_stitching {
+        // Giới hạn bộ nhớ cho canvas: khi các tile trong RAM vượt quá `bytes`, tile ít
+        // dùng nhất được đẩy ra file tạm (memory-mapped) trong `scratchDir`. scratchDir
+        // rỗng thì không spill và giới hạn chỉ mang tính tham khảo.
+        struct CanvasBudget {
+            size_t bytes = 192u << 20;
+            std::string scratchDir;
+        };
+
+        // Mặc định cho cả process, app đặt một lần (ví dụ với thư mục cache của app).
+        void setDefaultCanvasBudget(const CanvasBudget &budget);
+
+        CanvasBudget defaultCanvasBudget();
+
+        // Canvas BGR + trọng số chia thành các tile vuông kích thước cố định. Tile chỉ
+        // được cấp phát khi có frame chạm vào, nằm trong RAM theo LRU và bị spill ra đĩa
+        // khi vượt ngân sách, nên bộ nhớ đỉnh không phụ thuộc vào độ dài bill. Không
+        // thread-safe: một canvas chỉ được dùng bởi một thread.
+        class TiledCanvas {
+        public:
+            static const int kDefaultTileSize = 256;
+
+            TiledCanvas();
+
+            ~TiledCanvas();
+
+            TiledCanvas(const TiledCanvas &) = delete;
+
+            TiledCanvas &operator=(const TiledCanvas &) = delete;
+
+            // Bỏ mọi tile và bắt đầu một canvas trống kích thước `size`.
+            void reset(const cv::Size &size, const CanvasBudget &budget = defaultCanvasBudget(),
+                       int tileSize = kDefaultTileSize);
+
+            cv::Size size() const { return size_; }
+
+            // Trộn `bgr` (CV_8UC3) với trọng số từng pixel `weight` (CV_8U, 0 = không phủ)
+            // vào canvas, góc trên trái tại `tl`, lần lượt từng tile.
+            void blend(const cv::Mat &bgr, const cv::Mat &weight, const cv::Point &tl);
+
+            // Hợp các vùng đã trộn, cắt theo canvas.
+            cv::Rect covered() const { return covered_; }
+
+            // Chép vùng `region` của canvas vào `dst` (CV_8UC3, cấp phát nếu cần). Tile chưa
+            // từng được chạm tới đọc ra màu đen mà không bị cấp phát.
+            void read(const cv::Rect &region, cv::Mat &dst);
+
+            // Như read() nhưng chuyển từng tile thẳng vào `dst` (CV_8UC4, RGBA, alpha 255).
+            void readRGBA(const cv::Rect &region, cv::Mat &dst);
+
+            // Số byte dữ liệu tile đang nằm trong RAM.
+            size_t residentBytes() const { return resident_.size() * tileBytes_; }
+
+            int spilledTiles() const { return spills_; }
+
+        private:
+            struct Tile {
+                std::vector<uchar> data;           // plane BGR rồi tới plane trọng số
+                long slot = -1;                    // slot trong file tạm sau khi spill
+                std::list<int>::iterator lru;
+                bool touched = false;
+            };
+
+            // Đưa tile `index` vào RAM (cấp phát hoặc nạp lại) và đánh dấu vừa dùng.
+            Tile &acquire(int index);
+
+            void evictOne();
+
+            // `dst` phải có sẵn kích thước của `region`; `code` < 0 thì chép nguyên BGR.
+            void readInto(const cv::Rect &region, cv::Mat &dst, int code);
+
+            bool openScratch();
+
+            cv::Mat color(Tile &tile) const;
+
+            cv::Mat weights(Tile &tile) const;
+
+            cv::Size size_;
+            int tileSize_ = kDefaultTileSize;
+            int tilesX_ = 0;
+            size_t tileBytes_ = 0;
+            CanvasBudget budget_;
+            std::vector<Tile> tiles_;
+            std::list<int> resident_;              // dùng gần nhất đứng đầu
+            cv::Rect covered_;
+            int scratchFd_ = -1;
+            long scratchSlots_ = 0;
+            int spills_ = 0;
+        };
+    }
+}
+
+#endif //TILED_CANVAS_HPP
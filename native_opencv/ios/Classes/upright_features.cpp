@@ -0,0 +1,174 @@
+#include "opencv2/opencv.hpp"
+#include "upright_features.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+using namespace cv;
+
+namespace {
+    // Mỗi phép thử so sánh trung bình 5x5 quanh hai điểm trong patch
+    const int kBoxRadius = 2;
+    const int kTests = cv::bill_stitching::UprightFeatures::kDescriptorBytes * 8;
+    // Toạ độ mẫu nằm trong [-kSampleRadius, kSampleRadius] để hộp 5x5 không ra ngoài patch
+    const int kSampleRadius = cv::bill_stitching::UprightFeatures::kPatchRadius - kBoxRadius;
+    const int kBorder = cv::bill_stitching::UprightFeatures::kPatchRadius + 1;
+
+    struct TestPair {
+        Point a, b;
+    };
+
+    // Mẫu cố định, lấy ngẫu nhiên theo phân phối Gauss đẳng hướng như BRIEF (seed cố định
+    // nên descriptor giống nhau giữa các lần chạy và với feature cache)
+    const vector<TestPair> &testPattern() {
+        static const vector<TestPair> pattern = [] {
+            RNG rng(0x42494c4c);
+            const double sigma = cv::bill_stitching::UprightFeatures::kPatchRadius * 2 / 5.0;
+            auto coordinate = [&] {
+                return std::max(-kSampleRadius, std::min(kSampleRadius, cvRound(rng.gaussian(sigma))));
+            };
+            auto sample = [&] {
+                const int x = coordinate();
+                const int y = coordinate();
+                return Point(x, y);
+            };
+            vector<TestPair> tests(kTests);
+            for (auto &test: tests) {
+                do {
+                    test.a = sample();
+                    test.b = sample();
+                } while (test.a == test.b);
+            }
+            return tests;
+        }();
+        return pattern;
+    }
+
+    inline int boxSum(const Mat &integral, int x, int y) {
+        const int *top = integral.ptr<int>(y - kBoxRadius);
+        const int *bottom = integral.ptr<int>(y + kBoxRadius + 1);
+        const int x0 = x - kBoxRadius, x1 = x + kBoxRadius + 1;
+        return bottom[x1] - bottom[x0] - top[x1] + top[x0];
+    }
+
+    void describe(const Mat &integral, const Point &center, uchar *descriptor) {
+        const vector<TestPair> &pattern = testPattern();
+        for (int byte = 0; byte < cv::bill_stitching::UprightFeatures::kDescriptorBytes; ++byte) {
+            uchar bits = 0;
+            for (int bit = 0; bit < 8; ++bit) {
+                const TestPair &test = pattern[byte * 8 + bit];
+                if (boxSum(integral, center.x + test.a.x, center.y + test.a.y) <
+                    boxSum(integral, center.x + test.b.x, center.y + test.b.y)) {
+                    bits |= static_cast<uchar>(1 << bit);
+                }
+            }
+            descriptor[byte] = bits;
+        }
+    }
+
+    bool insideBorder(const Point &pt, const Size &size) {
+        return pt.x >= kBorder && pt.y >= kBorder && pt.x < size.width - kBorder && pt.y < size.height - kBorder;
+    }
+}
+
+void cv::bill_stitching::UprightFeatures::detectLevel(const Mat &level, int octave, int budget,
+                                                      vector<KeyPoint> &keypoints) const {
+    if (budget <= 0 || level.cols <= 2 * kBorder || level.rows <= 2 * kBorder) {
+        return;
+    }
+    vector<KeyPoint> corners;
+    FAST(level, corners, params_.fastThreshold, true);
+    // Bill ít chữ (vùng trắng lớn): hạ ngưỡng một lần thay vì để thiếu điểm
+    if (static_cast<int>(corners.size()) < budget / 2) {
+        corners.clear();
+        FAST(level, corners, std::max(5, params_.fastThreshold / 2), true);
+    }
+
+    // Chia lưới, mỗi ô chỉ giữ các góc mạnh nhất
+    const int cells = params_.gridCols * params_.gridRows;
+    const int perCell = std::max(1, (budget + cells - 1) / cells);
+    vector<vector<KeyPoint>> buckets(cells);
+    for (const auto &corner: corners) {
+        const Point pt(cvRound(corner.pt.x), cvRound(corner.pt.y));
+        if (!insideBorder(pt, level.size())) {
+            continue;
+        }
+        const int cx = std::min(params_.gridCols - 1, pt.x * params_.gridCols / level.cols);
+        const int cy = std::min(params_.gridRows - 1, pt.y * params_.gridRows / level.rows);
+        buckets[cy * params_.gridCols + cx].push_back(corner);
+    }
+    const float scale = std::pow(params_.scaleFactor, static_cast<float>(octave));
+    for (auto &bucket: buckets) {
+        if (static_cast<int>(bucket.size()) > perCell) {
+            std::nth_element(bucket.begin(), bucket.begin() + perCell, bucket.end(),
+                             [](const KeyPoint &a, const KeyPoint &b) { return a.response > b.response; });
+            bucket.resize(perCell);
+        }
+        for (auto &corner: bucket) {
+            // Toạ độ ở tầng 0; octave chọn lại tầng khi tính descriptor
+            keypoints.emplace_back(corner.pt * scale, (2 * kPatchRadius + 1) * scale, -1, corner.response, octave);
+        }
+    }
+}
+
+void cv::bill_stitching::UprightFeatures::detectAndCompute(InputArray image, InputArray mask,
+                                                           vector<KeyPoint> &keypoints, OutputArray descriptors,
+                                                           bool useProvidedKeypoints) {
+    Mat gray = image.getMat();
+    if (gray.channels() != 1) {
+        cvtColor(gray, gray, gray.channels() == 4 ? COLOR_BGRA2GRAY : COLOR_BGR2GRAY);
+    }
+    const int levels = std::max(1, params_.levels);
+
+    // Pyramid với số tầng cố định; tầng l nhỏ hơn scaleFactor^l lần
+    vector<Mat> pyramid(levels);
+    pyramid[0] = gray;
+    double totalArea = static_cast<double>(gray.total());
+    for (int l = 1; l < levels; ++l) {
+        const double s = 1.0 / std::pow(params_.scaleFactor, l);
+        resize(gray, pyramid[l], Size(cvRound(gray.cols * s), cvRound(gray.rows * s)), 0, 0, INTER_AREA);
+        totalArea += static_cast<double>(pyramid[l].total());
+    }
+
+    if (!useProvidedKeypoints) {
+        keypoints.clear();
+        // Ngân sách mỗi tầng tỉ lệ với diện tích của tầng
+        for (int l = 0; l < levels; ++l) {
+            const int budget = cvRound(params_.maxFeatures * pyramid[l].total() / totalArea);
+            detectLevel(pyramid[l], l, budget, keypoints);
+        }
+        if (!mask.empty()) {
+            KeyPointsFilter::runByPixelsMask(keypoints, mask.getMat());
+        }
+    }
+    if (!descriptors.needed()) {
+        return;
+    }
+
+    vector<Mat> integrals(levels);
+    for (int l = 0; l < levels; ++l) {
+        integral(pyramid[l], integrals[l], CV_32S);
+    }
+    // Bỏ các điểm không đủ patch ở tầng của nó (chỉ xảy ra với keypoint do bên ngoài đưa vào)
+    vector<Point> centers;
+    centers.reserve(keypoints.size());
+    size_t kept = 0;
+    for (size_t i = 0; i < keypoints.size(); ++i) {
+        const int l = std::min(std::max(keypoints[i].octave, 0), levels - 1);
+        const float s = 1.0f / std::pow(params_.scaleFactor, static_cast<float>(l));
+        const Point center(cvRound(keypoints[i].pt.x * s), cvRound(keypoints[i].pt.y * s));
+        if (insideBorder(center, pyramid[l].size())) {
+            keypoints[kept] = keypoints[i];
+            keypoints[kept].octave = l;
+            centers.push_back(center);
+            ++kept;
+        }
+    }
+    keypoints.resize(kept);
+
+    Mat out(static_cast<int>(kept), kDescriptorBytes, CV_8U);
+    for (size_t i = 0; i < kept; ++i) {
+        describe(integrals[keypoints[i].octave], centers[i], out.ptr<uchar>(static_cast<int>(i)));
+    }
+    out.copyTo(descriptors);
+}
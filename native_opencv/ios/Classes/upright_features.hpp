@@ -0,0 +1,60 @@
+#ifndef UPRIGHT_FEATURES_HPP
+#define UPRIGHT_FEATURES_HPP
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/features2d.hpp"
+#include <vector>
+
+namespace cv {
+    namespace bill_stitching {
+        struct UprightParams {
+            int maxFeatures = 2000;        // total over levels and grid cells
+            int gridCols = 8;
+            int gridRows = 8;
+            int levels = 3;
+            float scaleFactor = 1.5f;      // between pyramid levels
+            int fastThreshold = 20;
+        };
+
+        // Extractor chuyên cho ảnh scan bill: giữa hai frame bill chỉ nghiêng vài độ (lớp
+        // phủ độ nghiêng đảm bảo điều này) nên không cần ước lượng hướng như ORB hay dựng
+        // scale space như SIFT. Góc FAST trên vài tầng pyramid cố định, chia theo lưới để
+        // điểm rải đều trên cả tờ bill, mô tả bằng 256 phép so sánh nhị phân không xoay
+        // (kiểu BRIEF) trên trung bình 5x5 từ ảnh tích phân. Descriptor 32 byte CV_8U,
+        // NORM_HAMMING như ORB, nên dùng được với mọi matcher của cv::detail.
+        class UprightFeatures : public cv::Feature2D {
+        public:
+            static const int kDescriptorBytes = 32;
+            static const int kPatchRadius = 15;
+
+            explicit UprightFeatures(const UprightParams &params = UprightParams()) : params_(params) {}
+
+            static cv::Ptr<UprightFeatures> create(const UprightParams &params = UprightParams()) {
+                return cv::makePtr<UprightFeatures>(params);
+            }
+
+            // With useProvidedKeypoints, `keypoints` must come from this extractor (the
+            // octave selects the pyramid level); points too close to the border are removed.
+            void detectAndCompute(cv::InputArray image, cv::InputArray mask,
+                                  std::vector<cv::KeyPoint> &keypoints, cv::OutputArray descriptors,
+                                  bool useProvidedKeypoints) CV_OVERRIDE;
+
+            int descriptorSize() const CV_OVERRIDE { return kDescriptorBytes; }
+
+            int descriptorType() const CV_OVERRIDE { return CV_8U; }
+
+            int defaultNorm() const CV_OVERRIDE { return cv::NORM_HAMMING; }
+
+            bool empty() const CV_OVERRIDE { return false; }
+
+            cv::String getDefaultName() const CV_OVERRIDE { return "BillStitching.UprightFeatures"; }
+
+        private:
+            void detectLevel(const cv::Mat &level, int octave, int budget, std::vector<cv::KeyPoint> &keypoints) const;
+
+            UprightParams params_;
+        };
+    }
+}
+
+#endif //UPRIGHT_FEATURES_HPP
@@ -0,0 +1,93 @@
+#include "opencv2/opencv.hpp"
+#include "compositor.hpp"
+#include "test_support.hpp"
+
+using namespace std;
+using namespace cv;
+using cv::bill_stitching::blendRow;
+using cv::bill_stitching::Compositor;
+
+namespace {
+    // Độ rộng lẻ để cả nhánh SIMD lẫn phần đuôi vô hướng đều chạy
+    const int kWidth = 131;
+
+    // Công thức của blendRow viết lại từng pixel, làm chuẩn so sánh
+    void referenceBlend(const vector<uchar> &src, const vector<uchar> &srcW, vector<uchar> &dst,
+                        vector<uchar> &dstW) {
+        for (int x = 0; x < kWidth; ++x) {
+            const int wn = srcW[x], wo = dstW[x];
+            const int a = cvRound(255.f * wn / std::max(wn + wo, 1));
+            for (int c = 0; c < 3; ++c) {
+                const int t = src[3 * x + c] * a + dst[3 * x + c] * (255 - a) + 128;
+                dst[3 * x + c] = static_cast<uchar>((t + (t >> 8)) >> 8);
+            }
+            dstW[x] = static_cast<uchar>(std::max(wn, wo));
+        }
+    }
+
+    vector<uchar> randomBytes(RNG &rng, size_t count) {
+        vector<uchar> bytes(count);
+        for (auto &b: bytes) {
+            b = static_cast<uchar>(rng.uniform(0, 256));
+        }
+        return bytes;
+    }
+}
+
+TEST_CASE(blendRow_matchesTheScalarFormula) {
+    RNG rng(3);
+    for (int round = 0; round < 20; ++round) {
+        const vector<uchar> src = randomBytes(rng, 3 * kWidth), srcW = randomBytes(rng, kWidth);
+        vector<uchar> dst = randomBytes(rng, 3 * kWidth), dstW = randomBytes(rng, kWidth);
+        vector<uchar> expected = dst, expectedW = dstW;
+        referenceBlend(src, srcW, expected, expectedW);
+        blendRow(src.data(), srcW.data(), dst.data(), dstW.data(), kWidth);
+        CHECK(dst == expected);
+        CHECK(dstW == expectedW);
+    }
+}
+
+TEST_CASE(blendRow_keepsUncoveredPixelsAndCopiesIntoEmptyOnes) {
+    RNG rng(4);
+    const vector<uchar> src = randomBytes(rng, 3 * kWidth);
+    vector<uchar> srcW(kWidth, 0), dst = randomBytes(rng, 3 * kWidth), dstW(kWidth, 200);
+    const vector<uchar> before = dst;
+    blendRow(src.data(), srcW.data(), dst.data(), dstW.data(), kWidth);
+    CHECK(dst == before);
+    CHECK(dstW == vector<uchar>(kWidth, 200));
+
+    // Canvas chưa phủ: pixel mới được chép nguyên vẹn
+    srcW.assign(kWidth, 1);
+    dstW.assign(kWidth, 0);
+    blendRow(src.data(), srcW.data(), dst.data(), dstW.data(), kWidth);
+    CHECK(dst == src);
+    CHECK(dstW == vector<uchar>(kWidth, 1));
+}
+
+TEST_CASE(blendRow_averagesEqualWeights) {
+    const vector<uchar> src(3 * kWidth, 200), srcW(kWidth, 90);
+    vector<uchar> dst(3 * kWidth, 100), dstW(kWidth, 90);
+    blendRow(src.data(), srcW.data(), dst.data(), dstW.data(), kWidth);
+    for (int i = 0; i < 3 * kWidth; ++i) {
+        CHECK_NEAR(static_cast<int>(dst[i]), 150, 1);
+    }
+}
+
+TEST_CASE(compositor_blendsOnlyWhereFramesOverlap) {
+    Compositor compositor;
+    compositor.reset(Size(300, 100));
+    const Mat dark(100, 200, CV_8UC3, Scalar::all(60)), light(100, 200, CV_8UC3, Scalar::all(180));
+    compositor.feed(dark, Mat::eye(3, 3, CV_64F));
+    compositor.feed(light, (Mat_<double>(3, 3) << 1, 0, 100, 0, 1, 0, 0, 0, 1));
+    CHECK_EQ(compositor.canvas().covered(), Rect(0, 0, 300, 100));
+
+    const Mat result = compositor.result();
+    CHECK_EQ(result.at<Vec3b>(50, 20), Vec3b::all(60));
+    CHECK_EQ(result.at<Vec3b>(50, 280), Vec3b::all(180));
+    // Trong vùng chồng lấp giá trị nằm giữa hai frame và tăng dần về phía frame sáng
+    const int left = result.at<Vec3b>(50, 110)[0], mid = result.at<Vec3b>(50, 150)[0],
+            right = result.at<Vec3b>(50, 190)[0];
+    CHECK(left >= 60 && right <= 180);
+    CHECK(left <= mid && mid <= right);
+    CHECK(left < right);
+}
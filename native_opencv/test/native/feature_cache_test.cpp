@@ -0,0 +1,186 @@
+#include "opencv2/opencv.hpp"
+#include "feature_cache.hpp"
+#include "test_support.hpp"
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+using namespace cv;
+using cv::bill_stitching::FeatureCacheSettings;
+
+namespace {
+    const uint64_t kKey = 0x0123456789abcdefULL;
+
+    // Cache trỏ vào một thư mục tạm trong suốt vòng đời của fixture
+    struct TempCache {
+        std::string dir = bill_stitching_test::makeTempDir();
+
+        TempCache() {
+            FeatureCacheSettings settings;
+            settings.dir = dir;
+            cv::bill_stitching::setFeatureCache(settings);
+        }
+
+        ~TempCache() {
+            cv::bill_stitching::setFeatureCache(FeatureCacheSettings());
+            bill_stitching_test::removeDir(dir);
+        }
+
+        // Path of the only entry in the cache, empty if there is none or several.
+        std::string onlyEntry() const {
+            vector<std::string> entries;
+            if (DIR *handle = opendir(dir.c_str())) {
+                while (dirent *entry = readdir(handle)) {
+                    if (std::strcmp(entry->d_name, ".") != 0 && std::strcmp(entry->d_name, "..") != 0) {
+                        entries.push_back(dir + "/" + entry->d_name);
+                    }
+                }
+                closedir(handle);
+            }
+            return entries.size() == 1 ? entries[0] : std::string();
+        }
+    };
+
+    void sampleFeatures(vector<KeyPoint> &keypoints, Mat &descriptors) {
+        keypoints = {KeyPoint(Point2f(1.5f, 2.5f), 7.f, 30.f, 0.25f, 1, 3),
+                     KeyPoint(Point2f(100.f, 40.f), 11.f, -1.f, 0.75f, 0, -1)};
+        descriptors.create(2, 32, CV_8U);
+        randu(descriptors, 0, 256);
+    }
+
+    std::string readFile(const std::string &path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    void writeFile(const std::string &path, const std::string &bytes) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+}
+
+TEST_CASE(featureCache_roundTripsAnEntry) {
+    TempCache cache;
+    vector<KeyPoint> keypoints;
+    Mat descriptors;
+    sampleFeatures(keypoints, descriptors);
+    cv::bill_stitching::storeCachedFeatures(kKey, keypoints, descriptors);
+
+    vector<KeyPoint> loaded;
+    Mat loadedDescriptors;
+    CHECK(cv::bill_stitching::loadCachedFeatures(kKey, loaded, loadedDescriptors));
+    CHECK_EQ(loaded.size(), keypoints.size());
+    for (size_t i = 0; i < loaded.size() && i < keypoints.size(); ++i) {
+        CHECK_EQ(loaded[i].pt, keypoints[i].pt);
+        CHECK_EQ(loaded[i].size, keypoints[i].size);
+        CHECK_EQ(loaded[i].angle, keypoints[i].angle);
+        CHECK_EQ(loaded[i].response, keypoints[i].response);
+        CHECK_EQ(loaded[i].octave, keypoints[i].octave);
+        CHECK_EQ(loaded[i].class_id, keypoints[i].class_id);
+    }
+    CHECK_EQ(loadedDescriptors.type(), descriptors.type());
+    CHECK(loadedDescriptors.size() == descriptors.size() && norm(loadedDescriptors, descriptors, NORM_INF) == 0);
+    CHECK(!cv::bill_stitching::loadCachedFeatures(kKey + 1, loaded, loadedDescriptors));
+}
+
+TEST_CASE(featureCache_storesTheSameKeyFromManyThreads) {
+    // Cùng pid: mỗi thread phải ghi vào file tạm riêng rồi rename
+    TempCache cache;
+    vector<KeyPoint> keypoints;
+    Mat descriptors;
+    sampleFeatures(keypoints, descriptors);
+    vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 20; ++i) {
+                cv::bill_stitching::storeCachedFeatures(kKey, keypoints, descriptors);
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    // Không còn file tạm nào, và mục cuối cùng là một mục hoàn chỉnh
+    CHECK(!cache.onlyEntry().empty());
+    vector<KeyPoint> loaded;
+    Mat loadedDescriptors;
+    CHECK(cv::bill_stitching::loadCachedFeatures(kKey, loaded, loadedDescriptors));
+    CHECK_EQ(loaded.size(), keypoints.size());
+    CHECK(loadedDescriptors.size() == descriptors.size() && norm(loadedDescriptors, descriptors, NORM_INF) == 0);
+}
+
+TEST_CASE(featureCache_rejectsTruncatedEntries) {
+    TempCache cache;
+    vector<KeyPoint> keypoints;
+    Mat descriptors;
+    sampleFeatures(keypoints, descriptors);
+    cv::bill_stitching::storeCachedFeatures(kKey, keypoints, descriptors);
+    const std::string path = cache.onlyEntry();
+    CHECK(!path.empty());
+
+    const std::string bytes = readFile(path);
+    writeFile(path, bytes.substr(0, bytes.size() - 5));
+    vector<KeyPoint> loaded;
+    Mat loadedDescriptors;
+    CHECK(!cv::bill_stitching::loadCachedFeatures(kKey, loaded, loadedDescriptors));
+    // Mục hỏng bị xoá để lần sau ghi lại
+    CHECK(access(path.c_str(), F_OK) != 0);
+
+    // Ngắn hơn cả header
+    cv::bill_stitching::storeCachedFeatures(kKey, keypoints, descriptors);
+    writeFile(cache.onlyEntry(), "BFC1");
+    CHECK(!cv::bill_stitching::loadCachedFeatures(kKey, loaded, loadedDescriptors));
+}
+
+TEST_CASE(featureCache_rejectsCorruptHeaders) {
+    TempCache cache;
+    vector<KeyPoint> keypoints;
+    Mat descriptors;
+    sampleFeatures(keypoints, descriptors);
+    vector<KeyPoint> loaded;
+    Mat loadedDescriptors;
+
+    // Sai magic
+    cv::bill_stitching::storeCachedFeatures(kKey, keypoints, descriptors);
+    std::string bytes = readFile(cache.onlyEntry());
+    bytes[0] = 'X';
+    writeFile(cache.onlyEntry(), bytes);
+    CHECK(!cv::bill_stitching::loadCachedFeatures(kKey, loaded, loadedDescriptors));
+
+    // Số keypoint trong header không khớp với kích thước file
+    cv::bill_stitching::storeCachedFeatures(kKey, keypoints, descriptors);
+    bytes = readFile(cache.onlyEntry());
+    const int32_t count = 3;
+    bytes.replace(16, sizeof(count), reinterpret_cast<const char *>(&count), sizeof(count));
+    writeFile(cache.onlyEntry(), bytes);
+    CHECK(!cv::bill_stitching::loadCachedFeatures(kKey, loaded, loadedDescriptors));
+}
+
+TEST_CASE(featureCache_isInertWhenDisabled) {
+    cv::bill_stitching::setFeatureCache(FeatureCacheSettings());
+    vector<KeyPoint> keypoints;
+    Mat descriptors;
+    sampleFeatures(keypoints, descriptors);
+    cv::bill_stitching::storeCachedFeatures(kKey, keypoints, descriptors);
+    CHECK(!cv::bill_stitching::loadCachedFeatures(kKey, keypoints, descriptors));
+}
+
+TEST_CASE(hashImage_dependsOnPixelsAndShape) {
+    Mat image(48, 64, CV_8UC3);
+    randu(image, 0, 256);
+    const uint64_t hash = cv::bill_stitching::hashImage(image);
+    CHECK_EQ(cv::bill_stitching::hashImage(image.clone()), hash);
+
+    // ROI không liên tục: chỉ hash các pixel của ROI
+    Mat padded(60, 80, CV_8UC3, Scalar::all(0));
+    image.copyTo(padded(Rect(5, 5, 64, 48)));
+    CHECK_EQ(cv::bill_stitching::hashImage(padded(Rect(5, 5, 64, 48))), hash);
+
+    Mat changed = image.clone();
+    changed.at<Vec3b>(47, 63)[2] ^= 1;
+    CHECK(cv::bill_stitching::hashImage(changed) != hash);
+    CHECK(cv::bill_stitching::hashImage(image.reshape(3, 64)) != hash);
+}
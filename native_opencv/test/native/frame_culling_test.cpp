@@ -0,0 +1,66 @@
+#include "opencv2/opencv.hpp"
+#include "frame_culling.hpp"
+#include "test_support.hpp"
+
+using namespace std;
+using namespace cv;
+using cv::bill_stitching::CullResult;
+using cv::bill_stitching::cullRedundantFrames;
+
+namespace {
+    const Size kFrameSize(480, 360);
+
+    Mat noisePage(uint64 seed = 41) {
+        Mat page(1000, 700, CV_8U);
+        RNG rng(seed);
+        rng.fill(page, RNG::UNIFORM, 0, 256);
+        GaussianBlur(page, page, Size(), 1.5);
+        normalize(page, page, 0, 255, NORM_MINMAX);
+        return page;
+    }
+
+    // Frame BGR có góc trên trái ở (100, y) của trang
+    Mat frameAt(const Mat &page, int y) {
+        Mat frame;
+        cvtColor(page(Rect(Point(100, y), kFrameSize)), frame, COLOR_GRAY2BGR);
+        return frame;
+    }
+}
+
+TEST_CASE(cullRedundantFrames_skipsStalledFrames) {
+    const Mat page = noisePage();
+    // Người dùng dừng lại ở đầu bill và giữa bill; 110 px ~ chồng lấp 0.69, 220 px ~ 0.39
+    const vector<int> offsets = {0, 2, 4, 6, 110, 220, 220, 220, 330};
+    vector<Mat> images;
+    for (int y: offsets) {
+        images.push_back(frameAt(page, y));
+    }
+
+    const CullResult culled = cullRedundantFrames(images, 0.5);
+    CHECK(culled.kept == vector<int>({0, 4, 7, 8}));
+    CHECK_EQ(culled.dropped, 5);
+}
+
+TEST_CASE(cullRedundantFrames_keepsEveryFrameWithoutOverlap) {
+    vector<Mat> images;
+    for (int i = 0; i < 4; ++i) {
+        images.push_back(frameAt(noisePage(50 + i), 0));
+    }
+    const CullResult culled = cullRedundantFrames(images, 0.5);
+    CHECK(culled.kept == vector<int>({0, 1, 2, 3}));
+    CHECK_EQ(culled.dropped, 0);
+}
+
+TEST_CASE(cullRedundantFrames_handlesShortSequences) {
+    CHECK(cullRedundantFrames(vector<Mat>(), 0.5).kept.empty());
+
+    const Mat page = noisePage();
+    const CullResult single = cullRedundantFrames({frameAt(page, 0)}, 0.5);
+    CHECK(single.kept == vector<int>({0}));
+    CHECK_EQ(single.dropped, 0);
+
+    // Frame đầu và cuối luôn được giữ, kể cả khi trùng nhau
+    const CullResult pair = cullRedundantFrames({frameAt(page, 0), frameAt(page, 0)}, 0.5);
+    CHECK(pair.kept == vector<int>({0, 1}));
+    CHECK_EQ(pair.dropped, 0);
+}
@@ -0,0 +1,44 @@
+#include "frame_order.hpp"
+#include "test_support.hpp"
+
+using namespace std;
+using cv::bill_stitching::captureOrder;
+
+TEST_CASE(captureOrder_sortsNumbersNaturally) {
+    CHECK((captureOrder({"img_10.jpg", "img_2.jpg", "img_1.jpg"}, {}) == vector<int>{2, 1, 0}));
+}
+
+TEST_CASE(captureOrder_ignoresLeadingZeros) {
+    CHECK((captureOrder({"img_010.jpg", "img_9.jpg", "img_0001.jpg"}, {}) == vector<int>{2, 1, 0}));
+    // Cùng giá trị số: tên ngắn hơn đứng trước, ổn định giữa các lần chạy
+    CHECK((captureOrder({"img_02.jpg", "img_2.jpg"}, {}) == vector<int>{1, 0}));
+    CHECK((captureOrder({"img_0.jpg", "img_00.jpg"}, {}) == vector<int>{0, 1}));
+}
+
+TEST_CASE(captureOrder_comparesLongNumbersWithoutOverflow) {
+    CHECK((captureOrder({"IMG_20240101123000000000001.jpg", "IMG_20240101123000000000000.jpg"}, {}) ==
+           vector<int>{1, 0}));
+}
+
+TEST_CASE(captureOrder_usesOnlyTheFileName) {
+    CHECK((captureOrder({"/cache/dir9/img_2.jpg", "/cache/dir1/img_1.jpg"}, {}) == vector<int>{1, 0}));
+}
+
+TEST_CASE(captureOrder_prefersTimestamps) {
+    CHECK((captureOrder({"a_1.jpg", "a_2.jpg", "a_3.jpg"}, {300, 100, 200}) == vector<int>{1, 2, 0}));
+}
+
+TEST_CASE(captureOrder_breaksEqualTimestampsByName) {
+    CHECK((captureOrder({"x_1.jpg", "x_3.jpg", "x_2.jpg"}, {200, 100, 100}) == vector<int>{2, 1, 0}));
+}
+
+TEST_CASE(captureOrder_fallsBackToNamesWithoutUsableTimestamps) {
+    // Tất cả trùng nhau (ảnh chép vào cache), thiếu timestamp, hoặc sai số lượng
+    CHECK((captureOrder({"b_2.jpg", "b_1.jpg"}, {5, 5}) == vector<int>{1, 0}));
+    CHECK((captureOrder({"b_2.jpg", "b_1.jpg"}, {0, 100}) == vector<int>{1, 0}));
+    CHECK((captureOrder({"b_2.jpg", "b_1.jpg"}, {100}) == vector<int>{1, 0}));
+}
+
+TEST_CASE(captureOrder_handlesEmptyInput) {
+    CHECK(captureOrder({}, {}).empty());
+}
@@ -0,0 +1,114 @@
+#include "opencv2/opencv.hpp"
+#include "frame_quality.hpp"
+#include "test_support.hpp"
+
+using namespace std;
+using namespace cv;
+using cv::bill_stitching::FrameQuality;
+using cv::bill_stitching::QualitySelection;
+using cv::bill_stitching::scoreFrame;
+using cv::bill_stitching::selectQualityFrames;
+
+namespace {
+    const Size kFrameSize(480, 360);
+
+    Mat noisePage() {
+        Mat page(1100, 700, CV_8U);
+        RNG rng(61);
+        rng.fill(page, RNG::UNIFORM, 0, 256);
+        GaussianBlur(page, page, Size(), 1.0);
+        normalize(page, page, 0, 255, NORM_MINMAX);
+        return page;
+    }
+
+    // Frame BGR ở (100, y) của trang, nhoè thêm với `blurSigma` > 0 như khi camera rung
+    Mat frameAt(const Mat &page, int y, double blurSigma = 0) {
+        Mat frame;
+        cvtColor(page(Rect(Point(100, y), kFrameSize)), frame, COLOR_GRAY2BGR);
+        if (blurSigma > 0) {
+            GaussianBlur(frame, frame, Size(), blurSigma);
+        }
+        return frame;
+    }
+
+    QualitySelection select(const vector<Mat> &images) {
+        vector<FrameQuality> qualities;
+        for (const auto &image: images) {
+            qualities.push_back(scoreFrame(image));
+        }
+        return selectQualityFrames(images, qualities);
+    }
+}
+
+TEST_CASE(scoreFrame_rejectsBlurredFrames) {
+    const Mat page = noisePage();
+    const FrameQuality sharp = scoreFrame(frameAt(page, 0));
+    const FrameQuality blurred = scoreFrame(frameAt(page, 0, 4.0));
+    CHECK(sharp.acceptable);
+    CHECK(!blurred.acceptable);
+    CHECK(blurred.sharpness < sharp.sharpness);
+    CHECK(blurred.tenengrad < sharp.tenengrad);
+}
+
+TEST_CASE(scoreFrame_rejectsBadExposure) {
+    const Mat frame = frameAt(noisePage(), 0);
+    Mat bright, dark;
+    frame.convertTo(bright, -1, 1.0, 150);
+    frame.convertTo(dark, -1, 0.15, 0);
+
+    const FrameQuality overexposed = scoreFrame(bright);
+    CHECK(overexposed.clippedRatio > 0.3);
+    CHECK(!overexposed.acceptable);
+
+    const FrameQuality underexposed = scoreFrame(dark);
+    CHECK(underexposed.meanLuma < 50);
+    CHECK(!underexposed.acceptable);
+}
+
+TEST_CASE(scoreFrame_ignoresTheResolution) {
+    const Mat frame = frameAt(noisePage(), 0);
+    Mat large;
+    resize(frame, large, Size(), 2.0, 2.0, INTER_NEAREST);
+    // Ảnh lớn được thu về cùng cỡ chấm điểm, nên độ sáng và tỉ lệ cháy sáng không đổi
+    const FrameQuality a = scoreFrame(frame), b = scoreFrame(large);
+    CHECK_NEAR(a.meanLuma, b.meanLuma, 1.0);
+    CHECK_NEAR(a.clippedRatio, b.clippedRatio, 0.01);
+}
+
+TEST_CASE(selectQualityFrames_dropsABlurredFrameBetweenOverlappingNeighbours) {
+    const Mat page = noisePage();
+    vector<Mat> images;
+    for (int i = 0; i < 6; ++i) {
+        images.push_back(frameAt(page, 40 * i, i == 3 ? 4.0 : 0));
+    }
+    const QualitySelection selection = select(images);
+    CHECK(selection.kept == vector<int>({0, 1, 2, 4, 5}));
+    CHECK_EQ(selection.rejected, 1);
+    CHECK_EQ(selection.restored, 0);
+}
+
+TEST_CASE(selectQualityFrames_restoresAFrameToCloseAGap) {
+    const Mat page = noisePage();
+    // Frame 1 và 3 chỉ chồng lấp ~0.11 khi bỏ frame 2
+    vector<Mat> images;
+    for (int i = 0; i < 5; ++i) {
+        images.push_back(frameAt(page, 160 * i, i == 2 ? 4.0 : 0));
+    }
+    const QualitySelection selection = select(images);
+    CHECK(selection.kept == vector<int>({0, 1, 2, 3, 4}));
+    CHECK_EQ(selection.rejected, 0);
+    CHECK_EQ(selection.restored, 1);
+}
+
+TEST_CASE(selectQualityFrames_keepsTheBestFrameAtTheStart) {
+    const Mat page = noisePage();
+    // Hai frame đầu đều nhoè; frame ít nhoè hơn được giữ để không mất mép trên của bill
+    vector<Mat> images;
+    for (int i = 0; i < 6; ++i) {
+        images.push_back(frameAt(page, 40 * i, i == 0 ? 4.0 : i == 1 ? 3.0 : 0));
+    }
+    const QualitySelection selection = select(images);
+    CHECK(selection.kept == vector<int>({1, 2, 3, 4, 5}));
+    CHECK_EQ(selection.rejected, 1);
+    CHECK_EQ(selection.restored, 1);
+}
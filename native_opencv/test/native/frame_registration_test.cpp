@@ -0,0 +1,96 @@
+#include "opencv2/opencv.hpp"
+#include "frame_registration.hpp"
+#include "test_support.hpp"
+
+using namespace std;
+using namespace cv;
+using cv::bill_stitching::MotionPrior;
+using cv::bill_stitching::PairRegistration;
+using cv::bill_stitching::PhaseImage;
+using cv::bill_stitching::preparePhaseImage;
+
+namespace {
+    const Size kFrameSize(480, 360);
+    const Point kOrigin(300, 300);
+
+    // Trang nhiễu đã làm mờ: có kết cấu ở mọi tần số mà không lặp lại như dòng chữ
+    Mat noisePage() {
+        Mat page(1200, 1200, CV_8U);
+        RNG rng(21);
+        rng.fill(page, RNG::UNIFORM, 0, 256);
+        GaussianBlur(page, page, Size(), 1.5);
+        normalize(page, page, 0, 255, NORM_MINMAX);
+        return page;
+    }
+
+    // Frame có góc trên trái tại `origin` của trang, xoay `angleDeg` quanh tâm frame
+    Mat frameAt(const Mat &page, const Point2d &origin, double angleDeg = 0) {
+        Mat M = getRotationMatrix2D(Point2f(kFrameSize.width * 0.5f, kFrameSize.height * 0.5f), angleDeg, 1.0);
+        M.at<double>(0, 2) += origin.x;
+        M.at<double>(1, 2) += origin.y;
+        Mat frame;
+        warpAffine(page, frame, M, kFrameSize, INTER_LINEAR | WARP_INVERSE_MAP);
+        return frame;
+    }
+
+    Point2d shiftOf(const PairRegistration &reg) {
+        return Point2d(reg.H.at<double>(0, 2), reg.H.at<double>(1, 2));
+    }
+}
+
+TEST_CASE(registerTranslation_recoversASubPixelShift) {
+    const Mat page = noisePage();
+    const Point2d step(17, 95.5);
+    const PhaseImage prev = preparePhaseImage(frameAt(page, kOrigin));
+    const PhaseImage cur = preparePhaseImage(frameAt(page, Point2d(kOrigin) + step));
+
+    const PairRegistration reg = cv::bill_stitching::registerTranslation(prev, cur);
+    CHECK(reg.ok);
+    CHECK(reg.confidence >= 0.75);
+    if (reg.ok) {
+        // H đưa điểm của cur về prev: nội dung của cur nằm lệch `step` trong prev
+        CHECK_NEAR(shiftOf(reg).x, step.x, 0.5);
+        CHECK_NEAR(shiftOf(reg).y, step.y, 0.5);
+    }
+}
+
+TEST_CASE(registerTranslation_rejectsRotatedPairs) {
+    const Mat page = noisePage();
+    const PhaseImage prev = preparePhaseImage(frameAt(page, kOrigin));
+    const PhaseImage cur = preparePhaseImage(frameAt(page, Point2d(kOrigin) + Point2d(0, 80), 4.0));
+    CHECK(!cv::bill_stitching::registerTranslation(prev, cur).ok);
+}
+
+TEST_CASE(registerTranslation_rejectsShiftsOutsideThePrior) {
+    const Mat page = noisePage();
+    const PhaseImage prev = preparePhaseImage(frameAt(page, kOrigin));
+    const PhaseImage cur = preparePhaseImage(frameAt(page, Point2d(kOrigin) + Point2d(0, 90)));
+    MotionPrior prior;
+    prior.valid = true;
+    prior.radius = 10;
+
+    prior.shift = Point2d(0, 88);
+    CHECK(cv::bill_stitching::registerTranslation(prev, cur, prior).ok);
+    prior.shift = Point2d(0, 140);
+    CHECK(!cv::bill_stitching::registerTranslation(prev, cur, prior).ok);
+}
+
+TEST_CASE(registerTranslation_rejectsUnrelatedFrames) {
+    const Mat page = noisePage();
+    Mat other(page.size(), CV_8U);
+    RNG rng(22);
+    rng.fill(other, RNG::UNIFORM, 0, 256);
+    GaussianBlur(other, other, Size(), 1.5);
+    const PhaseImage prev = preparePhaseImage(frameAt(page, kOrigin));
+    const PhaseImage cur = preparePhaseImage(frameAt(other, kOrigin));
+    CHECK(!cv::bill_stitching::registerTranslation(prev, cur).ok);
+}
+
+TEST_CASE(estimateOverlap_followsTheShift) {
+    const Mat page = noisePage();
+    const PhaseImage prev = preparePhaseImage(frameAt(page, kOrigin), false);
+    const PhaseImage cur = preparePhaseImage(frameAt(page, Point2d(kOrigin) + Point2d(0, 120)), false);
+    const double expected = (kFrameSize.height - 120.0) / kFrameSize.height;
+    CHECK_NEAR(cv::bill_stitching::estimateOverlap(prev, cur), expected, 0.05);
+    CHECK_NEAR(cv::bill_stitching::estimateOverlap(prev, prev), 1.0, 1e-9);
+}
@@ -0,0 +1,97 @@
+#include "opencv2/opencv.hpp"
+#include "frame_tracker.hpp"
+#include "test_support.hpp"
+
+using namespace std;
+using namespace cv;
+using cv::bill_stitching::FrameTracker;
+using cv::bill_stitching::TrackResult;
+
+namespace {
+    // Độ phân giải tracking: frame dọc như preview camera khi quét bill
+    const Size kFrameSize(240, 320);
+    const Point kOrigin(200, 100);
+    const int kStep = 10;
+
+    Mat noisePage() {
+        Mat page(900, 640, CV_8U);
+        RNG rng(31);
+        rng.fill(page, RNG::UNIFORM, 0, 256);
+        GaussianBlur(page, page, Size(), 2.0);
+        normalize(page, page, 0, 255, NORM_MINMAX);
+        return page;
+    }
+
+    // Frame thứ `index` khi camera trượt xuống `kStep` px mỗi frame
+    Mat frameAt(const Mat &page, int index) {
+        return page(Rect(kOrigin + Point(0, index * kStep), kFrameSize)).clone();
+    }
+}
+
+TEST_CASE(frameTracker_firstFrameIsAKeyframeWithoutMotion) {
+    FrameTracker tracker;
+    const TrackResult first = tracker.track(frameAt(noisePage(), 0));
+    CHECK(first.keyframe);
+    CHECK(!first.lost);
+    CHECK(first.toKeyframe.empty());
+    CHECK(first.numTracks > 0);
+}
+
+TEST_CASE(frameTracker_followsTheShiftUntilOverlapDrops) {
+    const Mat page = noisePage();
+    FrameTracker tracker;
+    tracker.track(frameAt(page, 0));
+
+    // Chồng lấp với keyframe = (320 - 10n) / 320, xuống dưới 0.6 ở frame 13
+    int keyframeAt = -1;
+    for (int i = 1; i <= 16 && keyframeAt < 0; ++i) {
+        const TrackResult r = tracker.track(frameAt(page, i));
+        CHECK(!r.lost);
+        CHECK(!r.toKeyframe.empty());
+        if (r.toKeyframe.empty()) {
+            break;
+        }
+        // toKeyframe đưa điểm của frame hiện tại về keyframe: lệch i * kStep theo y
+        CHECK_NEAR(r.toKeyframe.at<double>(0, 2), 0.0, 1.0);
+        CHECK_NEAR(r.toKeyframe.at<double>(1, 2), i * kStep, 1.0);
+        CHECK_NEAR(r.overlap, (kFrameSize.height - i * kStep) / double(kFrameSize.height), 0.02);
+        if (r.keyframe) {
+            keyframeAt = i;
+        }
+    }
+    CHECK_EQ(keyframeAt, 13);
+
+    // Sau keyframe, chuyển động được đo lại từ đầu
+    const TrackResult next = tracker.track(frameAt(page, 14));
+    CHECK(!next.keyframe);
+    if (!next.toKeyframe.empty()) {
+        CHECK_NEAR(next.toKeyframe.at<double>(1, 2), kStep, 1.0);
+    }
+}
+
+TEST_CASE(frameTracker_restartsWithoutMotionWhenTheSizeChanges) {
+    const Mat page = noisePage();
+    FrameTracker tracker;
+    tracker.track(frameAt(page, 0));
+    CHECK(!tracker.track(frameAt(page, 1)).keyframe);
+
+    Mat smaller;
+    resize(frameAt(page, 2), smaller, Size(), 0.5, 0.5, INTER_AREA);
+    const TrackResult restarted = tracker.track(smaller);
+    CHECK(restarted.keyframe);
+    CHECK(!restarted.lost);
+    CHECK(restarted.toKeyframe.empty());
+}
+
+TEST_CASE(frameTracker_resetStartsANewSequence) {
+    const Mat page = noisePage();
+    FrameTracker tracker;
+    tracker.track(frameAt(page, 0));
+    tracker.track(frameAt(page, 1));
+    tracker.reset();
+
+    const TrackResult r = tracker.track(frameAt(page, 2));
+    CHECK(r.keyframe);
+    CHECK(!r.lost);
+    CHECK(r.toKeyframe.empty());
+}
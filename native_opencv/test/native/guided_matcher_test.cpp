@@ -0,0 +1,135 @@
+#include "opencv2/opencv.hpp"
+#include "bill_stitching.hpp"
+#include "guided_matcher.hpp"
+#include "test_support.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::detail;
+using cv::bill_stitching::GuidedMatcher;
+
+namespace {
+    const Size kFrameSize(480, 360);
+    const double kStepAngleDeg = 4;       // đủ để phase correlation từ chối mọi cặp
+    const double kStepShiftPx = 120;
+
+    // Fallback ghi lại số lần được gọi và không bao giờ ghép được cặp nào
+    class FailingMatcher : public FeaturesMatcher {
+    public:
+        int calls = 0;
+
+    protected:
+        void match(const ImageFeatures &, const ImageFeatures &, MatchesInfo &) CV_OVERRIDE {
+            ++calls;
+        }
+    };
+
+    // Chuyển động giữa hai frame liên tiếp: 3x3 CV_64F, frame k px -> frame k-1 px
+    Mat stepMotion() {
+        const Point2f center(kFrameSize.width * 0.5f, kFrameSize.height * 0.5f);
+        Mat D = Mat::eye(3, 3, CV_64F);
+        getRotationMatrix2D(center, kStepAngleDeg, 1.0).copyTo(D.rowRange(0, 2));
+        D.at<double>(1, 2) += kStepShiftPx;
+        return D;
+    }
+
+    // Các frame cắt từ một trang nhiễu đã làm mờ, mỗi frame cách frame trước một `stepMotion()`
+    vector<Mat> scanFrames(int count) {
+        Mat page(1600, 1600, CV_8U);
+        RNG rng(11);
+        rng.fill(page, RNG::UNIFORM, 0, 256);
+        GaussianBlur(page, page, Size(), 1.5);
+        normalize(page, page, 0, 255, NORM_MINMAX);
+        cvtColor(page, page, COLOR_GRAY2BGR);
+
+        Mat M = (Mat_<double>(3, 3) << 1, 0, 500, 0, 1, 300, 0, 0, 1);
+        const Mat D = stepMotion();
+        vector<Mat> frames(count);
+        for (int k = 0; k < count; ++k) {
+            warpAffine(page, frames[k], M.rowRange(0, 2), kFrameSize, INTER_LINEAR | WARP_INVERSE_MAP);
+            M = M * D;
+        }
+        return frames;
+    }
+
+    ImageFeatures findFeatures(const Mat &image, int index) {
+        ImageFeatures features;
+        ORB::create(3000)->detectAndCompute(image, noArray(), features.keypoints, features.descriptors);
+        features.img_idx = index;
+        features.img_size = image.size();
+        return features;
+    }
+
+    bool nearAffine(const Mat &actual, const Mat &expected) {
+        Mat a;
+        actual.convertTo(a, CV_64F);
+        for (int i = 0; i < 2; ++i) {
+            for (int j = 0; j < 2; ++j) {
+                if (std::abs(a.at<double>(i, j) - expected.at<double>(i, j)) > 0.01) {
+                    return false;
+                }
+            }
+            if (std::abs(a.at<double>(i, 2) - expected.at<double>(i, 2)) > 2.0) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE(guidedMatcher_matchesAroundThePriorWithoutFallback) {
+    const vector<Mat> frames = scanFrames(3);
+    Ptr<FailingMatcher> fallback = makePtr<FailingMatcher>();
+    GuidedMatcher matcher(fallback, 0.3, 0.92);
+    matcher.recordMotion(1, 0, stepMotion());
+
+    MatchesInfo info;
+    matcher(findFeatures(frames[1], 1), findFeatures(frames[2], 2), info);
+    CHECK_EQ(fallback->calls, 0);
+    CHECK(info.confidence >= 0.92);
+    CHECK(!info.H.empty() && nearAffine(info.H, stepMotion().inv()));
+}
+
+TEST_CASE(guidedMatcher_usesFrameSpacingForEqualTimestamps) {
+    // Hai frame cùng timestamp: prior vẫn được ngoại suy theo chỉ số frame
+    const vector<Mat> frames = scanFrames(3);
+    Ptr<FailingMatcher> fallback = makePtr<FailingMatcher>();
+    GuidedMatcher matcher(fallback, 0.3, 0.92);
+    matcher.setTimestamps(vector<int64>{1000, 1000, 2000});
+    matcher.recordMotion(1, 0, stepMotion());
+
+    MatchesInfo info;
+    matcher(findFeatures(frames[1], 1), findFeatures(frames[2], 2), info);
+    CHECK_EQ(fallback->calls, 0);
+    CHECK(!info.H.empty() && nearAffine(info.H, stepMotion().inv()));
+}
+
+TEST_CASE(guidedMatcher_fallsBackOnAZeroSearchRadius) {
+    // Không biết kích thước ảnh và prior đứng yên: bán kính tìm kiếm bằng 0
+    const vector<Mat> frames = scanFrames(2);
+    ImageFeatures features1 = findFeatures(frames[1], 1), features2 = findFeatures(frames[1], 2);
+    features1.img_size = features2.img_size = Size();
+    Ptr<FailingMatcher> fallback = makePtr<FailingMatcher>();
+    GuidedMatcher matcher(fallback, 0.3, 0.92);
+    matcher.recordMotion(1, 0, Mat::eye(3, 3, CV_64F));
+
+    MatchesInfo info;
+    matcher(features1, features2, info);
+    CHECK_EQ(fallback->calls, 1);
+    CHECK(info.matches.empty());
+}
+
+TEST_CASE(stitchBills_chainRegistersRotatedFramesThroughGuidedMatching) {
+    // Cặp đầu ghép toàn bộ; chuyển động của nó là prior cho các cặp sau
+    const vector<Mat> frames = scanFrames(4);
+    cv::bill_stitching::StitchConfig config = cv::bill_stitching::defaultStitchConfig();
+    config.engine = cv::bill_stitching::ENGINE_BILL_CHAIN;
+    cv::bill_stitching::Composite result;
+    cv::bill_stitching::Registration registration;
+    CHECK(cv::bill_stitching::stitchBills(frames, result, config, nullptr, &registration));
+    CHECK(!result.bgr().empty());
+    CHECK_EQ(registration.toCanvas.size(), frames.size());
+    for (size_t k = 1; k < registration.toCanvas.size(); ++k) {
+        CHECK(nearAffine(registration.toCanvas[k - 1].inv() * registration.toCanvas[k], stepMotion()));
+    }
+}
@@ -0,0 +1,89 @@
+#include "keypoint_selection.hpp"
+#include "test_support.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace std;
+using namespace cv;
+using cv::bill_stitching::KeypointSelection;
+using cv::bill_stitching::selectKeypoints;
+
+namespace {
+    // Lưới cols x rows, cách nhau `spacing` px, response giả ngẫu nhiên (cố định)
+    vector<KeyPoint> gridKeypoints(int cols, int rows, float spacing) {
+        vector<KeyPoint> keypoints;
+        RNG rng(7);
+        for (int y = 0; y < rows; ++y) {
+            for (int x = 0; x < cols; ++x) {
+                keypoints.emplace_back(Point2f(x * spacing, y * spacing), 7.f, -1, rng.uniform(0.f, 1.f));
+            }
+        }
+        return keypoints;
+    }
+
+    bool strictlyIncreasing(const vector<int> &indices) {
+        return std::adjacent_find(indices.begin(), indices.end(), std::greater_equal<int>()) == indices.end();
+    }
+}
+
+TEST_CASE(selectKeypoints_keepsEverythingWhenDisabled) {
+    const vector<KeyPoint> keypoints = gridKeypoints(4, 3, 5.f);
+    const vector<int> kept = selectKeypoints(keypoints, KeypointSelection());
+    CHECK_EQ(kept.size(), keypoints.size());
+    CHECK(strictlyIncreasing(kept));
+}
+
+TEST_CASE(selectKeypoints_dropsDuplicatesAroundStrongerPoints) {
+    const vector<KeyPoint> keypoints = {
+            KeyPoint(Point2f(10, 10), 7.f, -1, 1.f),
+            KeyPoint(Point2f(11, 10), 7.f, -1, 5.f),
+            KeyPoint(Point2f(50, 50), 7.f, -1, 2.f),
+    };
+    CHECK((selectKeypoints(keypoints, KeypointSelection{2.f, 0}) == vector<int>{1, 2}));
+}
+
+TEST_CASE(selectKeypoints_anmsReturnsExactlyTheTarget) {
+    const vector<KeyPoint> keypoints = gridKeypoints(20, 20, 10.f);
+    const vector<int> kept = selectKeypoints(keypoints, KeypointSelection{0.f, 50});
+    CHECK_EQ(kept.size(), 50u);
+    CHECK(strictlyIncreasing(kept));
+    // Rải đều: bán kính tìm được lớn hơn khoảng cách lưới
+    float minDistance = FLT_MAX;
+    for (size_t i = 0; i < kept.size(); ++i) {
+        for (size_t j = i + 1; j < kept.size(); ++j) {
+            minDistance = std::min(minDistance, static_cast<float>(norm(keypoints[kept[i]].pt -
+                                                                         keypoints[kept[j]].pt)));
+        }
+    }
+    CHECK(minDistance > 10.f);
+}
+
+TEST_CASE(selectKeypoints_anmsTerminatesOnCoincidentPoints) {
+    // Bounding box rỗng: không có bán kính nào để tìm, chỉ giữ các điểm mạnh nhất
+    vector<KeyPoint> keypoints;
+    for (int i = 0; i < 30; ++i) {
+        keypoints.emplace_back(Point2f(5, 5), 7.f, -1, static_cast<float>(i));
+    }
+    const vector<int> kept = selectKeypoints(keypoints, KeypointSelection{0.f, 10});
+    CHECK_EQ(kept.size(), 10u);
+    CHECK_EQ(kept.front(), 20);
+    CHECK_EQ(kept.back(), 29);
+}
+
+TEST_CASE(selectKeypoints_anmsKeepsTheStrongestForTargetOne) {
+    const vector<KeyPoint> keypoints = gridKeypoints(6, 6, 4.f);
+    const vector<int> kept = selectKeypoints(keypoints, KeypointSelection{0.f, 1});
+    CHECK_EQ(kept.size(), 1u);
+    const auto strongest = std::max_element(keypoints.begin(), keypoints.end(),
+                                            [](const KeyPoint &a, const KeyPoint &b) {
+                                                return a.response < b.response;
+                                            });
+    CHECK_EQ(kept[0], static_cast<int>(strongest - keypoints.begin()));
+}
+
+TEST_CASE(selectKeypoints_anmsIsOffBelowTheTarget) {
+    const vector<KeyPoint> keypoints = gridKeypoints(3, 3, 10.f);
+    CHECK_EQ(selectKeypoints(keypoints, KeypointSelection{0.f, 100}).size(), keypoints.size());
+    CHECK(selectKeypoints(vector<KeyPoint>(), KeypointSelection{2.f, 10}).empty());
+}
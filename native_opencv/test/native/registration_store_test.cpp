@@ -0,0 +1,146 @@
+#include "opencv2/opencv.hpp"
+#include "registration_store.hpp"
+#include "test_support.hpp"
+
+using namespace std;
+using namespace cv;
+using cv::bill_stitching::Registration;
+
+namespace {
+    Registration sampleRegistration() {
+        Registration registration;
+        registration.engine = 1;
+        registration.canvasSize = Size(1000, 800);
+        registration.crop = Rect(100, 50, 400, 300);
+        Mat rotation = getRotationMatrix2D(Point2f(200, 150), 3.0, 1.0);
+        Mat H = Mat::eye(3, 3, CV_64F);
+        rotation.copyTo(H.rowRange(0, 2));
+        H.at<double>(1, 2) += 250;
+        registration.toCanvas = {Mat::eye(3, 3, CV_64F), H};
+        registration.paths = {"/photos/img_1.jpg", "/photos/img_2.jpg"};
+        registration.gains = {1.0, 1.1};
+        return registration;
+    }
+
+    Point2d transform(const Mat &H, const Point2d &p) {
+        const Mat q = H * (Mat_<double>(3, 1) << p.x, p.y, 1);
+        return Point2d(q.at<double>(0) / q.at<double>(2), q.at<double>(1) / q.at<double>(2));
+    }
+}
+
+TEST_CASE(scaleRegistration_conjugatesTransforms) {
+    // Điểm p của frame ở đơn vị cũ phải rơi vào factor * H(p) ở đơn vị mới
+    const Registration original = sampleRegistration();
+    Registration scaled = original;
+    cv::bill_stitching::scaleRegistration(scaled, 0.5);
+    const Point2d p(320, 410);
+    const Point2d expected = transform(original.toCanvas[1], p) * 0.5;
+    const Point2d actual = transform(scaled.toCanvas[1], p * 0.5);
+    CHECK_NEAR(actual.x, expected.x, 1e-9);
+    CHECK_NEAR(actual.y, expected.y, 1e-9);
+    CHECK_EQ(scaled.canvasSize, Size(500, 400));
+    CHECK_EQ(scaled.crop, Rect(50, 25, 200, 150));
+}
+
+TEST_CASE(scaleRegistration_roundTrips) {
+    const Registration original = sampleRegistration();
+    Registration scaled = original;
+    cv::bill_stitching::scaleRegistration(scaled, 0.5);
+    cv::bill_stitching::scaleRegistration(scaled, 2.0);
+    for (size_t i = 0; i < original.toCanvas.size(); ++i) {
+        CHECK(norm(scaled.toCanvas[i], original.toCanvas[i], NORM_INF) < 1e-9);
+    }
+    CHECK_EQ(scaled.canvasSize, original.canvasSize);
+    CHECK_EQ(scaled.crop, original.crop);
+}
+
+TEST_CASE(scaleRegistration_growsOddCropsOutwardAndClipsToCanvas) {
+    Registration registration = sampleRegistration();
+    registration.crop = Rect(101, 51, 799, 599);
+    cv::bill_stitching::scaleRegistration(registration, 0.5);
+    // floor cho góc trên trái, ceil cho góc dưới phải
+    CHECK_EQ(registration.crop, Rect(Point(50, 25), Point(450, 325)));
+
+    Registration outside = sampleRegistration();
+    outside.crop = Rect(101, 51, 950, 800);
+    cv::bill_stitching::scaleRegistration(outside, 0.5);
+    CHECK_EQ(outside.crop, Rect(Point(50, 25), Point(500, 400)));
+
+    Registration empty = sampleRegistration();
+    empty.crop = Rect();
+    cv::bill_stitching::scaleRegistration(empty, 2.0);
+    CHECK(empty.crop.empty());
+}
+
+TEST_CASE(registration_writesAndReadsBack) {
+    const std::string dir = bill_stitching_test::makeTempDir();
+    CHECK(!dir.empty());
+    const std::string path = cv::bill_stitching::registrationSidecarPath(dir + "/bill.jpg");
+    const Registration original = sampleRegistration();
+    CHECK(cv::bill_stitching::writeRegistration(path, original));
+
+    Registration loaded;
+    CHECK(cv::bill_stitching::readRegistration(path, loaded));
+    CHECK_EQ(loaded.engine, original.engine);
+    CHECK_EQ(loaded.canvasSize, original.canvasSize);
+    CHECK_EQ(loaded.crop, original.crop);
+    CHECK(loaded.paths == original.paths);
+    CHECK_EQ(loaded.toCanvas.size(), original.toCanvas.size());
+    for (size_t i = 0; i < loaded.toCanvas.size() && i < original.toCanvas.size(); ++i) {
+        CHECK_EQ(loaded.toCanvas[i].type(), CV_64F);
+        CHECK(norm(loaded.toCanvas[i], original.toCanvas[i], NORM_INF) < 1e-12);
+        CHECK_NEAR(loaded.gains[i], original.gains[i], 1e-12);
+    }
+    bill_stitching_test::removeDir(dir);
+}
+
+TEST_CASE(writeRegistration_failsForAnUnwritablePath) {
+    const std::string dir = bill_stitching_test::makeTempDir();
+    const std::string path = dir + "/missing/bill.jpg.reg.yml.gz";
+    CHECK(!cv::bill_stitching::writeRegistration(path, sampleRegistration()));
+    Registration registration;
+    CHECK(!cv::bill_stitching::readRegistration(path, registration));
+    bill_stitching_test::removeDir(dir);
+}
+
+TEST_CASE(readRegistration_rejectsMissingOrMalformedFiles) {
+    const std::string dir = bill_stitching_test::makeTempDir();
+    const Registration untouched = sampleRegistration();
+    Registration registration = untouched;
+    CHECK(!cv::bill_stitching::readRegistration(dir + "/missing.reg.yml.gz", registration));
+
+    // Phiên bản khác
+    const std::string otherVersion = dir + "/version.reg.yml";
+    {
+        FileStorage fs(otherVersion, FileStorage::WRITE);
+        fs << "version" << cv::bill_stitching::kRegistrationVersion + 1;
+        fs << "canvas" << Size(10, 10);
+    }
+    CHECK(!cv::bill_stitching::readRegistration(otherVersion, registration));
+
+    // Frame có ma trận 2x3
+    const std::string badFrame = dir + "/frame.reg.yml";
+    {
+        FileStorage fs(badFrame, FileStorage::WRITE);
+        fs << "version" << cv::bill_stitching::kRegistrationVersion;
+        fs << "engine" << 0 << "canvas" << Size(10, 10) << "crop" << Rect();
+        fs << "frames" << "[" << "{" << "path" << "a.jpg" << "H" << Mat(Mat::eye(2, 3, CV_64F)) << "gain" << 1.0
+           << "}" << "]";
+    }
+    CHECK(!cv::bill_stitching::readRegistration(badFrame, registration));
+
+    // Không có frame nào
+    const std::string noFrames = dir + "/empty.reg.yml";
+    {
+        FileStorage fs(noFrames, FileStorage::WRITE);
+        fs << "version" << cv::bill_stitching::kRegistrationVersion;
+        fs << "engine" << 0 << "canvas" << Size(10, 10) << "crop" << Rect();
+        fs << "frames" << "[" << "]";
+    }
+    CHECK(!cv::bill_stitching::readRegistration(noFrames, registration));
+
+    // Lỗi không được làm hỏng registration đang có
+    CHECK_EQ(registration.canvasSize, untouched.canvasSize);
+    CHECK(registration.paths == untouched.paths);
+    bill_stitching_test::removeDir(dir);
+}
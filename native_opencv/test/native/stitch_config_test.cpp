@@ -0,0 +1,55 @@
+#include "opencv2/opencv.hpp"
+#include "stitch_config.hpp"
+#include "test_support.hpp"
+#include <functional>
+#include <limits>
+
+using namespace std;
+using namespace cv;
+using namespace cv::bill_stitching;
+
+namespace {
+    // Kết quả kiểm tra config mặc định sau khi đổi một trường
+    ConfigStatus validateWith(const function<void(StitchConfig &)> &change) {
+        StitchConfig config = defaultStitchConfig();
+        change(config);
+        return validateConfig(config);
+    }
+}
+
+TEST_CASE(validateConfig_acceptsTheDefaults) {
+    CHECK_EQ(validateConfig(defaultStitchConfig()), CONFIG_OK);
+    CHECK_EQ(defaultStitchConfig().version, kStitchConfigVersion);
+}
+
+TEST_CASE(validateConfig_acceptsAnyMatchWindowAsAllPairs) {
+    CHECK_EQ(validateWith([](StitchConfig &c) { c.matchWindow = 0; }), CONFIG_OK);
+    CHECK_EQ(validateWith([](StitchConfig &c) { c.matchWindow = -1; }), CONFIG_OK);
+    CHECK_EQ(validateWith([](StitchConfig &c) { c.matchWindow = 3; }), CONFIG_OK);
+}
+
+TEST_CASE(validateConfig_reportsTheInvalidField) {
+    CHECK_EQ(validateWith([](StitchConfig &c) { c.version = kStitchConfigVersion + 1; }), CONFIG_ERR_VERSION);
+    CHECK_EQ(validateWith([](StitchConfig &c) { c.engine = ENGINE_TRANSLATION + 1; }), CONFIG_ERR_ENGINE);
+    CHECK_EQ(validateWith([](StitchConfig &c) { c.engine = -1; }), CONFIG_ERR_ENGINE);
+    CHECK_EQ(validateWith([](StitchConfig &c) { c.detector = DETECTOR_UPRIGHT + 1; }), CONFIG_ERR_DETECTOR);
+    CHECK_EQ(validateWith([](StitchConfig &c) { c.maxFeatures = 0; }), CONFIG_ERR_DETECTOR);
+    CHECK_EQ(validateWith([](StitchConfig &c) { c.workScale = 0; }), CONFIG_ERR_RESOLUTION);
+    CHECK_EQ(validateWith([](StitchConfig &c) { c.workScale = 1.5; }), CONFIG_ERR_RESOLUTION);
+    CHECK_EQ(validateWith([](StitchConfig &c) { c.composeScale = 0; }), CONFIG_ERR_RESOLUTION);
+    CHECK_EQ(validateWith([](StitchConfig &c) { c.matchConfidence = 1; }), CONFIG_ERR_MATCHING);
+    CHECK_EQ(validateWith([](StitchConfig &c) { c.blender = BLENDER_MULTI_BAND + 1; }), CONFIG_ERR_BLENDER);
+    CHECK_EQ(validateWith([](StitchConfig &c) { c.outputFormat = OUTPUT_WEBP + 1; }), CONFIG_ERR_OUTPUT);
+    CHECK_EQ(validateWith([](StitchConfig &c) { c.outputQuality = 0; }), CONFIG_ERR_OUTPUT);
+    CHECK_EQ(validateWith([](StitchConfig &c) { c.outputQuality = 101; }), CONFIG_ERR_OUTPUT);
+    CHECK_EQ(validateWith([](StitchConfig &c) { c.qualityPrefilter = 2; }), CONFIG_ERR_FILTER);
+    CHECK_EQ(validateWith([](StitchConfig &c) { c.cullMinOverlap = 1; }), CONFIG_ERR_FILTER);
+}
+
+TEST_CASE(validateConfig_rejectsNaN) {
+    // NaN từ phía Dart không được lọt qua các phép so sánh
+    const double nan = numeric_limits<double>::quiet_NaN();
+    CHECK_EQ(validateWith([&](StitchConfig &c) { c.workScale = nan; }), CONFIG_ERR_RESOLUTION);
+    CHECK_EQ(validateWith([&](StitchConfig &c) { c.matchConfidence = nan; }), CONFIG_ERR_MATCHING);
+    CHECK_EQ(validateWith([&](StitchConfig &c) { c.cullMinOverlap = nan; }), CONFIG_ERR_FILTER);
+}
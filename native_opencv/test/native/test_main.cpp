@@ -0,0 +1,62 @@
+#include "test_support.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <exception>
+#include <unistd.h>
+
+namespace {
+    int gFailures = 0;
+}
+
+std::vector<bill_stitching_test::TestCase> &bill_stitching_test::registry() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+void bill_stitching_test::fail(const char *file, int line, const std::string &message) {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, message.c_str());
+    ++gFailures;
+}
+
+std::string bill_stitching_test::makeTempDir() {
+    const char *base = std::getenv("TMPDIR");
+    std::string pattern = std::string(base != nullptr && base[0] != '\0' ? base : "/tmp") + "/bill_test_XXXXXX";
+    std::vector<char> buffer(pattern.begin(), pattern.end());
+    buffer.push_back('\0');
+    return mkdtemp(buffer.data()) != nullptr ? std::string(buffer.data()) : std::string();
+}
+
+void bill_stitching_test::removeDir(const std::string &dir) {
+    if (DIR *handle = opendir(dir.c_str())) {
+        while (dirent *entry = readdir(handle)) {
+            if (std::strcmp(entry->d_name, ".") != 0 && std::strcmp(entry->d_name, "..") != 0) {
+                unlink((dir + "/" + entry->d_name).c_str());
+            }
+        }
+        closedir(handle);
+    }
+    rmdir(dir.c_str());
+}
+
+// Chạy mọi test (hoặc các test có tên chứa argv[1]); mã thoát khác 0 nếu có lỗi
+int main(int argc, char **argv) {
+    const char *filter = argc > 1 ? argv[1] : nullptr;
+    int run = 0;
+    for (const auto &test: bill_stitching_test::registry()) {
+        if (filter != nullptr && std::strstr(test.name, filter) == nullptr) {
+            continue;
+        }
+        const int before = gFailures;
+        try {
+            test.fn();
+        } catch (const std::exception &e) {
+            bill_stitching_test::fail(test.name, 0, std::string("unexpected exception: ") + e.what());
+        }
+        std::printf("[%s] %s\n", gFailures == before ? "  OK  " : " FAIL ", test.name);
+        ++run;
+    }
+    std::printf("%d tests, %d failed checks\n", run, gFailures);
+    return gFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
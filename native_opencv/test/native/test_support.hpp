@@ -0,0 +1,57 @@
+#ifndef TEST_SUPPORT_HPP
+#define TEST_SUPPORT_HPP
+
+#include <string>
+#include <vector>
+
+// Bộ kiểm thử tối giản cho các hàm thuần của plugin, không phụ thuộc framework ngoài.
+// TEST_CASE đăng ký một hàm; CHECK ghi nhận lỗi và chạy tiếp phần còn lại của test.
+namespace bill_stitching_test {
+    typedef void (*TestFn)();
+
+    struct TestCase {
+        const char *name;
+        TestFn fn;
+    };
+
+    std::vector<TestCase> &registry();
+
+    struct Registrar {
+        Registrar(const char *name, TestFn fn) { registry().push_back(TestCase{name, fn}); }
+    };
+
+    void fail(const char *file, int line, const std::string &message);
+
+    // A fresh directory under the system temp dir, removed with its files by removeDir().
+    std::string makeTempDir();
+
+    void removeDir(const std::string &dir);
+}
+
+#define TEST_CASE(name) \
+    static void name(); \
+    static const bill_stitching_test::Registrar name##_registrar(#name, name); \
+    static void name()
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            bill_stitching_test::fail(__FILE__, __LINE__, #condition); \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do { \
+        if (!((actual) == (expected))) { \
+            bill_stitching_test::fail(__FILE__, __LINE__, #actual " == " #expected); \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+    do { \
+        if (!(std::abs((actual) - (expected)) <= (tolerance))) { \
+            bill_stitching_test::fail(__FILE__, __LINE__, #actual " ~= " #expected); \
+        } \
+    } while (0)
+
+#endif //TEST_SUPPORT_HPP
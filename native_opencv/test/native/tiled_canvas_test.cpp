@@ -0,0 +1,90 @@
+#include "opencv2/opencv.hpp"
+#include "compositor.hpp"
+#include "tiled_canvas.hpp"
+#include "test_support.hpp"
+
+using namespace std;
+using namespace cv;
+using cv::bill_stitching::CanvasBudget;
+using cv::bill_stitching::TiledCanvas;
+
+namespace {
+    const int kTileSize = 64;
+    const size_t kTileBytes = static_cast<size_t>(kTileSize) * kTileSize * 4;
+
+    // Ngân sách chỉ đủ cho 3 tile, phần còn lại phải spill ra thư mục tạm
+    struct TempBudget {
+        std::string dir = bill_stitching_test::makeTempDir();
+        CanvasBudget budget;
+
+        TempBudget() {
+            budget.bytes = 3 * kTileBytes;
+            budget.scratchDir = dir;
+        }
+
+        ~TempBudget() { bill_stitching_test::removeDir(dir); }
+    };
+
+    Mat randomImage(const Size &size) {
+        Mat image(size, CV_8UC3);
+        RNG rng(5);
+        rng.fill(image, RNG::UNIFORM, 0, 256);
+        return image;
+    }
+
+    bool samePixels(const Mat &a, const Mat &b) {
+        return a.size() == b.size() && a.type() == b.type() && norm(a, b, NORM_INF) == 0;
+    }
+}
+
+TEST_CASE(tiledCanvas_spillsAndReloadsTilesUnchanged) {
+    TempBudget temp;
+    TiledCanvas canvas;
+    canvas.reset(Size(300, 200), temp.budget, kTileSize);
+    // Canvas trống: trọng số mới chiếm toàn bộ nên pixel được chép nguyên vẹn
+    const Mat image = randomImage(canvas.size());
+    canvas.blend(image, Mat(image.size(), CV_8U, Scalar(255)), Point());
+    CHECK(canvas.spilledTiles() > 0);
+    CHECK(canvas.residentBytes() <= temp.budget.bytes);
+
+    Mat bgr;
+    canvas.read(Rect(Point(), canvas.size()), bgr);
+    CHECK(samePixels(bgr, image));
+    CHECK(canvas.residentBytes() <= temp.budget.bytes);
+
+    const Rect region(37, 21, 190, 150);
+    Mat rgba, expected;
+    canvas.readRGBA(region, rgba);
+    cvtColor(image(region), expected, COLOR_BGR2RGBA);
+    CHECK(samePixels(rgba, expected));
+}
+
+TEST_CASE(tiledCanvas_readsUntouchedTilesAsBlack) {
+    TiledCanvas canvas;
+    canvas.reset(Size(300, 200), CanvasBudget(), kTileSize);
+    const Mat image = randomImage(Size(50, 40));
+    canvas.blend(image, Mat(image.size(), CV_8U, Scalar(255)), Point(10, 10));
+    CHECK(canvas.covered() == Rect(10, 10, 50, 40));
+
+    Mat rgba;
+    canvas.readRGBA(Rect(Point(), canvas.size()), rgba);
+    CHECK_EQ(rgba.at<Vec4b>(150, 250), Vec4b(0, 0, 0, 255));
+    Mat expected;
+    cvtColor(image, expected, COLOR_BGR2RGBA);
+    CHECK(samePixels(rgba(Rect(10, 10, 50, 40)), expected));
+}
+
+TEST_CASE(composite_readsSpilledCanvasStraightIntoRGBA) {
+    TempBudget temp;
+    cv::bill_stitching::Composite composite;
+    composite.compositor.reset(Size(320, 260), temp.budget);
+    const Mat image = randomImage(Size(320, 260));
+    composite.compositor.feed(image, Mat::eye(3, 3, CV_64F));
+    CHECK(!composite.empty());
+
+    Mat rgba, expected;
+    composite.readRGBA(rgba);
+    cvtColor(image, expected, COLOR_BGR2RGBA);
+    CHECK(samePixels(rgba, expected));
+    CHECK(samePixels(composite.bgr(), image));
+}
@@ -0,0 +1,149 @@
+#include "opencv2/opencv.hpp"
+#include "stitch_session.hpp"
+#include "test_support.hpp"
+#include <functional>
+
+using namespace std;
+using namespace cv;
+using cv::bill_stitching::Yuv420Planes;
+
+namespace {
+    const int kWidth = 64;
+    const int kHeight = 48;
+    // Stride lớn hơn độ rộng như buffer camera thật
+    const int kYStride = 80;
+
+    // Frame YUV420 giữ cả hai cách sắp xếp chroma của cùng một nội dung: planar (I420)
+    // và xen kẽ (NV21, V trước U)
+    struct CameraFrame {
+        vector<uchar> y, u, v, vu;
+
+        Yuv420Planes planar() const {
+            Yuv420Planes planes = base();
+            planes.u = u.data();
+            planes.v = v.data();
+            planes.uvRowStride = kWidth / 2;
+            planes.uvPixelStride = 1;
+            return planes;
+        }
+
+        Yuv420Planes interleaved() const {
+            Yuv420Planes planes = base();
+            planes.v = vu.data();
+            planes.u = vu.data() + 1;
+            planes.uvRowStride = kWidth;
+            planes.uvPixelStride = 2;
+            return planes;
+        }
+
+    private:
+        Yuv420Planes base() const {
+            Yuv420Planes planes;
+            planes.y = y.data();
+            planes.width = kWidth;
+            planes.height = kHeight;
+            planes.yRowStride = kYStride;
+            return planes;
+        }
+    };
+
+    CameraFrame makeFrame(const function<Vec3b(int, int)> &yuvAt) {
+        CameraFrame frame;
+        frame.y.assign(kYStride * kHeight, 0);
+        frame.u.assign(kWidth / 2 * kHeight / 2, 0);
+        frame.v.assign(frame.u.size(), 0);
+        // Thêm một byte cuối: plane U xen kẽ bắt đầu sau plane V một byte
+        frame.vu.assign(kWidth * kHeight / 2 + 1, 0);
+        for (int r = 0; r < kHeight; ++r) {
+            for (int c = 0; c < kWidth; ++c) {
+                const Vec3b p = yuvAt(r, c);
+                frame.y[r * kYStride + c] = p[0];
+                if (r % 2 == 0 && c % 2 == 0) {
+                    const int i = (r / 2) * (kWidth / 2) + c / 2;
+                    frame.u[i] = p[1];
+                    frame.v[i] = p[2];
+                    frame.vu[(r / 2) * kWidth + c] = p[2];
+                    frame.vu[(r / 2) * kWidth + c + 1] = p[1];
+                }
+            }
+        }
+        return frame;
+    }
+
+    Vec3b referenceBgr(const Vec3b &yuv) {
+        Mat bgr;
+        cvtColor(Mat(1, 1, CV_8UC3, Scalar(yuv[0], yuv[1], yuv[2])), bgr, COLOR_YUV2BGR);
+        return bgr.at<Vec3b>(0, 0);
+    }
+}
+
+TEST_CASE(convertYuv420_matchesAFlatColour) {
+    const Vec3b yuv(120, 90, 170);
+    const CameraFrame frame = makeFrame([&](int, int) { return yuv; });
+    Mat bgr, gray;
+    cv::bill_stitching::convertYuv420(frame.planar(), 1.0, bgr, gray);
+    CHECK_EQ(bgr.size(), Size(kWidth, kHeight));
+    CHECK_EQ(gray.size(), Size(kWidth, kHeight));
+    CHECK_EQ(countNonZero(gray != yuv[0]), 0);
+
+    // U và V không bị đảo: so với cvtColor của đúng pixel đó
+    const Vec3b expected = referenceBgr(yuv);
+    for (int r = 0; r < kHeight; ++r) {
+        for (int c = 0; c < kWidth; ++c) {
+            const Vec3b got = bgr.at<Vec3b>(r, c);
+            for (int ch = 0; ch < 3; ++ch) {
+                CHECK_NEAR(static_cast<int>(got[ch]), static_cast<int>(expected[ch]), 1);
+            }
+        }
+    }
+}
+
+TEST_CASE(convertYuv420_treatsPlanarAndInterleavedChromaAlike) {
+    RNG rng(7);
+    const CameraFrame frame = makeFrame([&](int, int) {
+        return Vec3b(rng.uniform(16, 236), rng.uniform(16, 241), rng.uniform(16, 241));
+    });
+    Mat planarBgr, planarGray, interleavedBgr, interleavedGray;
+    cv::bill_stitching::convertYuv420(frame.planar(), 0.5, planarBgr, planarGray);
+    cv::bill_stitching::convertYuv420(frame.interleaved(), 0.5, interleavedBgr, interleavedGray);
+    CHECK_EQ(planarBgr.size(), Size(kWidth / 2, kHeight / 2));
+    CHECK(cv::norm(planarBgr, interleavedBgr, NORM_INF) <= 1.0);
+    CHECK_EQ(cv::norm(planarGray, interleavedGray, NORM_INF), 0.0);
+}
+
+TEST_CASE(convertYuv420_rotatesClockwise) {
+    RNG rng(8);
+    const CameraFrame frame = makeFrame([&](int, int) {
+        return Vec3b(rng.uniform(16, 236), 128, 128);
+    });
+    Yuv420Planes planes = frame.planar();
+    Mat bgr, gray;
+    cv::bill_stitching::convertYuv420(planes, 1.0, bgr, gray);
+
+    const int codes[] = {ROTATE_90_CLOCKWISE, ROTATE_180, ROTATE_90_COUNTERCLOCKWISE};
+    const int rotations[] = {90, 180, 270};
+    for (int i = 0; i < 3; ++i) {
+        planes.rotation = rotations[i];
+        Mat rotatedBgr, rotatedGray, expectedBgr, expectedGray;
+        cv::bill_stitching::convertYuv420(planes, 1.0, rotatedBgr, rotatedGray);
+        rotate(bgr, expectedBgr, codes[i]);
+        rotate(gray, expectedGray, codes[i]);
+        CHECK_EQ(rotatedBgr.size(), expectedBgr.size());
+        CHECK_EQ(cv::norm(rotatedBgr, expectedBgr, NORM_INF), 0.0);
+        CHECK_EQ(cv::norm(rotatedGray, expectedGray, NORM_INF), 0.0);
+    }
+}
+
+TEST_CASE(convertYuv420_rejectsUnsupportedRotations) {
+    const CameraFrame frame = makeFrame([](int, int) { return Vec3b(100, 128, 128); });
+    Yuv420Planes planes = frame.planar();
+    planes.rotation = 45;
+    bool threw = false;
+    try {
+        Mat bgr, gray;
+        cv::bill_stitching::convertYuv420(planes, 1.0, bgr, gray);
+    } catch (const cv::Exception &) {
+        threw = true;
+    }
+    CHECK(threw);
+}